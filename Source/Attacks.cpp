@@ -0,0 +1,183 @@
+#include "Attacks.h"
+#include "Moves.h"
+#include "Sliders.h"
+
+namespace vimlock
+{
+
+static Bitboard betweenTable[64][64];
+static Bitboard lineTable[64][64];
+
+namespace
+{
+
+struct LineInit
+{
+	LineInit()
+	{
+		Bitboard empty;
+
+		for (uint64_t a = 0; a < 64; ++a) {
+			for (uint64_t b = 0; b < 64; ++b) {
+				if (a == b)
+					continue;
+
+				Bitboard bitA = Bitboard(Square(a));
+				Bitboard bitB = Bitboard(Square(b));
+
+				if (getRookMoves(Square(a), empty) & bitB) {
+					betweenTable[a][b] = getRookMoves(Square(a), bitB) & getRookMoves(Square(b), bitA);
+					lineTable[a][b] = (getRookMoves(Square(a), empty) & getRookMoves(Square(b), empty)) | bitA | bitB;
+				}
+				else if (getBishopMoves(Square(a), empty) & bitB) {
+					betweenTable[a][b] = getBishopMoves(Square(a), bitB) & getBishopMoves(Square(b), bitA);
+					lineTable[a][b] = (getBishopMoves(Square(a), empty) & getBishopMoves(Square(b), empty)) | bitA | bitB;
+				}
+			}
+		}
+	}
+};
+
+LineInit init;
+
+} // anonymous namespace
+
+Bitboard getBetween(Square a, Square b)
+{
+	return betweenTable[a.getIndex()][b.getIndex()];
+}
+
+Bitboard getLine(Square a, Square b)
+{
+	return lineTable[a.getIndex()][b.getIndex()];
+}
+
+void AttackInfo::reset()
+{
+	validAttacks = 0;
+	validPieceAttacks[0] = validPieceAttacks[1] = 0;
+	validPins = false;
+}
+
+Bitboard AttackInfo::getAttacks(const Board &board, Color color)
+{
+	int c = colorIndex(color);
+
+	if (validAttacks & (1 << c))
+		return attacks[c];
+
+	Bitboard allPieces = board.getPieces();
+	Bitboard queens = board.getPieces(color, QUEEN);
+
+	Bitboard ret = color == WHITE
+		? getPawnAttacks<WHITE>(board.getPieces(color, PAWN))
+		: getPawnAttacks<BLACK>(board.getPieces(color, PAWN));
+
+	ret |= getKnightAttacks(board.getPieces(color, KNIGHT));
+	ret |= getKingAttacks(board.getPieces(color, KING));
+	ret |= getSliderAttacks(board.getPieces(color, ROOK) | queens, board.getPieces(color, BISHOP) | queens, allPieces);
+
+	attacks[c] = ret;
+	validAttacks |= 1 << c;
+
+	return ret;
+}
+
+Bitboard AttackInfo::getAttacks(const Board &board, Color color, Piece piece)
+{
+	int c = colorIndex(color);
+	int p = pieceIndex(piece);
+
+	if (validPieceAttacks[c] & (1 << p))
+		return pieceAttacks[c][p];
+
+	Bitboard allPieces = board.getPieces();
+	Bitboard pieces = board.getPieces(color, piece);
+	Bitboard ret;
+
+	switch (piece) {
+		case PAWN:
+			ret = color == WHITE ? getPawnAttacks<WHITE>(pieces) : getPawnAttacks<BLACK>(pieces);
+			break;
+		case KNIGHT:
+			ret = getKnightAttacks(pieces);
+			break;
+		case KING:
+			ret = getKingAttacks(pieces);
+			break;
+		case ROOK:
+			ret = getSliderAttacks(pieces, Bitboard(), allPieces);
+			break;
+		case BISHOP:
+			ret = getSliderAttacks(Bitboard(), pieces, allPieces);
+			break;
+		case QUEEN:
+			ret = getSliderAttacks(pieces, pieces, allPieces);
+			break;
+	}
+
+	pieceAttacks[c][p] = ret;
+	validPieceAttacks[c] |= 1 << p;
+
+	return ret;
+}
+
+Bitboard AttackInfo::getCheckers(const Board &board)
+{
+	if (!validPins)
+		computePins(board);
+
+	return checkers;
+}
+
+Bitboard AttackInfo::getPinned(const Board &board)
+{
+	if (!validPins)
+		computePins(board);
+
+	return pinned;
+}
+
+Bitboard AttackInfo::getKingZone(const Board &board, Color color)
+{
+	Bitboard king = board.getPieces(color, KING);
+	return king | getKingAttacks(king);
+}
+
+void AttackInfo::computePins(const Board &board)
+{
+	Color own = board.getCurrent();
+	Color opp = flipColor(own);
+
+	Bitboard allPieces = board.getPieces();
+	Bitboard ownPieces = board.getPieces(own);
+	Bitboard oppPieces = board.getPieces(opp);
+	Bitboard king = board.getPieces(own, KING);
+
+	checkers = Bitboard();
+	pinned = Bitboard();
+	validPins = true;
+
+	if (!king)
+		return;
+
+	Square kingSquare = king.findFirstSquare();
+
+	checkers = getAttackers(board, kingSquare, allPieces, oppPieces);
+
+	// Opponent sliders which would attack the king on an empty board
+	Bitboard queens = board.getPieces(opp, QUEEN);
+	Bitboard snipers =
+		(getRookMoves(kingSquare, Bitboard()) & (board.getPieces(opp, ROOK) | queens)) |
+		(getBishopMoves(kingSquare, Bitboard()) & (board.getPieces(opp, BISHOP) | queens));
+
+	// Pinned if our piece is the only one in between
+	while (snipers) {
+		Bitboard between = getBetween(kingSquare, snipers.popFirstSquare()) & allPieces;
+
+		if (between.count() == 1 && (between & ownPieces))
+			pinned |= between;
+	}
+}
+
+} // namespace vimlock
@@ -0,0 +1,59 @@
+#pragma once
+#include "Bitboard.h"
+#include "Board.h"
+
+namespace vimlock
+{
+
+/// Return squares strictly between two squares on the same rank, file or diagonal.
+/// Empty if the squares are not aligned.
+Bitboard getBetween(Square a, Square b);
+
+/// Return all squares on the rank, file or diagonal going through both squares.
+/// Empty if the squares are not aligned.
+Bitboard getLine(Square a, Square b);
+
+/// Attack maps and check information of a single position.
+///
+/// Each part is computed on first use and then reused, so that all users within a
+/// node share the work and a node which needs only e.g. pins doesn't pay for full
+/// attack maps. Must be reset if the board changes.
+class AttackInfo
+{
+public:
+	/// Forget everything computed so far.
+	void reset();
+
+	/// Return all squares attacked by given color.
+	Bitboard getAttacks(const Board &board, Color color);
+
+	/// Return all squares attacked by given pieces of given color.
+	Bitboard getAttacks(const Board &board, Color color, Piece piece);
+
+	/// Return opponent pieces giving check to the side to move.
+	Bitboard getCheckers(const Board &board);
+
+	/// Return pieces of the side to move which are pinned to their own king.
+	Bitboard getPinned(const Board &board);
+
+	/// Return king of given color and the squares around it.
+	Bitboard getKingZone(const Board &board, Color color);
+
+private:
+	void computePins(const Board &board);
+
+	/// Bitmask of colors whose `attacks` are valid, bits indexed by `colorIndex()`.
+	int validAttacks = 0;
+
+	/// Bitmask of piece types whose `pieceAttacks` are valid, for each color.
+	int validPieceAttacks[2] = { 0, 0 };
+
+	bool validPins = false;
+
+	Bitboard attacks[2];
+	Bitboard pieceAttacks[2][6];
+	Bitboard checkers;
+	Bitboard pinned;
+};
+
+} // namespace vimlock
@@ -0,0 +1,193 @@
+#include "Bitbase.h"
+#include "Bitboard.h"
+#include "Log.h"
+#include "Moves.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace vimlock
+{
+
+// Positions are normalized to white having the pawn on files A-D, which leaves
+// 24 pawn squares, 64 squares for each king and two sides to move.
+constexpr int maxIndex = 2 * 24 * 64 * 64;
+
+/// One bit per position, set if won for white.
+static uint64_t kpkBitbase[maxIndex / 64];
+
+static std::once_flag kpkOnce;
+
+/// Bits: white king 0-5, black king 6-11, side to move 12, pawn file 13-14, pawn rank 15-17.
+static int getIndex(Color current, Square blackKing, Square whiteKing, Square pawn)
+{
+	return static_cast<int>(whiteKing.getIndex())
+		| static_cast<int>(blackKing.getIndex()) << 6
+		| (current == WHITE ? 0 : 1) << 12
+		| pawn.getFile() << 13
+		| (RANK_7 - pawn.getRank()) << 15;
+}
+
+/// Swap rows and columns of a 64x64 bit matrix, bit `c` of row `r` becomes bit `r` of row `c`.
+static void transpose(uint64_t *rows)
+{
+	uint64_t mask = 0x00000000ffffffffull;
+
+	for (int width = 32; width; width >>= 1, mask ^= mask << width) {
+		for (int k = 0; k < 64; k = ((k | width) + 1) & ~width) {
+			uint64_t swap = ((rows[k] >> width) ^ rows[k | width]) & mask;
+			rows[k] ^= swap << width;
+			rows[k | width] ^= swap;
+		}
+	}
+}
+
+/// Retrograde analysis: extend the set of won positions until nothing changes.
+///
+/// For one pawn square and side to move the bitbase holds a row of white king squares
+/// for each black king square, so king moves of a whole row are found with bitboard
+/// shifts. Black moves need rows of black king squares instead, which are kept as
+/// transposed copies.
+static void generateKPK()
+{
+	auto start = std::chrono::steady_clock::now();
+
+	// Rows by white king, bits by black king
+	std::vector<uint64_t> whiteWon(24 * 64);
+	std::vector<uint64_t> blackUnknown(24 * 64);
+	uint64_t blackWon[64];
+
+	// Results which can be decided without looking at the moves
+	for (int pawnIndex = 0; pawnIndex < 24; ++pawnIndex) {
+		Square pawn(pawnIndex & 0x3, RANK_7 - (pawnIndex >> 2));
+		Square push(pawn.getFile(), pawn.getRank() + 1);
+		Bitboard pawnAttacks = getPawnAttacks<WHITE>(pawn);
+
+		// Pawn promotes safely
+		for (uint64_t blackKing = 0; pawn.getRank() == RANK_7 && blackKing < 64; ++blackKing) {
+			if (Square(blackKing) == pawn || Square(blackKing) == push || (pawnAttacks & Bitboard(Square(blackKing))))
+				continue;
+
+			Bitboard valid = ~(getKingMoves(Square(blackKing)) | Bitboard(Square(blackKing)) | Bitboard(pawn) | Bitboard(push));
+			Bitboard defended = getKingMoves(Square(blackKing)) & Bitboard(push) ? getKingMoves(push) : ~Bitboard();
+
+			whiteWon[pawnIndex * 64 + blackKing] = (valid & defended).rawBits();
+		}
+
+		std::copy_n(&whiteWon[pawnIndex * 64], 64, &kpkBitbase[pawnIndex * 128]);
+		transpose(&whiteWon[pawnIndex * 64]);
+
+		// Black to move draws by stalemate or by taking the pawn
+		for (uint64_t whiteKing = 0; whiteKing < 64; ++whiteKing) {
+			if (Square(whiteKing) == pawn)
+				continue;
+
+			Bitboard whiteKingAttacks = getKingMoves(Square(whiteKing));
+			Bitboard valid = ~(whiteKingAttacks | Bitboard(Square(whiteKing)) | Bitboard(pawn));
+			Bitboard mobile = getKingAttacks(~(whiteKingAttacks | pawnAttacks));
+			Bitboard takesPawn = whiteKingAttacks & Bitboard(pawn) ? Bitboard() : getKingMoves(pawn);
+
+			blackUnknown[pawnIndex * 64 + whiteKing] = (valid & mobile & ~takesPawn).rawBits();
+		}
+	}
+
+	int passes = 0;
+	bool changed = true;
+
+	while (changed) {
+		changed = false;
+		passes++;
+
+		// Pawns closer to promotion first, so pushes see results of the same pass
+		for (int pawnIndex = 0; pawnIndex < 24; ++pawnIndex) {
+			Square pawn(pawnIndex & 0x3, RANK_7 - (pawnIndex >> 2));
+			Square push(pawn.getFile(), pawn.getRank() + 1);
+			Bitboard pawnAttacks = getPawnAttacks<WHITE>(pawn);
+
+			uint64_t *white = &kpkBitbase[pawnIndex * 128];
+			uint64_t *black = white + 64;
+
+			// Black to move loses when every move leads to a won position. Moves into check
+			// or onto a protected pawn lead to invalid positions, which never count as won.
+			for (uint64_t whiteKing = 0; whiteKing < 64; ++whiteKing) {
+				Bitboard legal = ~(getKingMoves(Square(whiteKing)) | Bitboard(Square(whiteKing)) | Bitboard(pawn) | pawnAttacks);
+				Bitboard escapes = legal & ~Bitboard(whiteWon[pawnIndex * 64 + whiteKing]);
+
+				blackWon[whiteKing] = blackUnknown[pawnIndex * 64 + whiteKing] & ~getKingAttacks(escapes).rawBits();
+			}
+
+			transpose(blackWon);
+
+			if (!std::equal(blackWon, blackWon + 64, black)) {
+				std::copy_n(blackWon, 64, black);
+				changed = true;
+			}
+
+			// White to move wins when any move leads to a won position
+			bool whiteChanged = false;
+
+			for (uint64_t blackKing = 0; blackKing < 64; ++blackKing) {
+				if (Square(blackKing) == pawn || (pawnAttacks & Bitboard(Square(blackKing))))
+					continue;
+
+				Bitboard valid = ~(getKingMoves(Square(blackKing)) | Bitboard(Square(blackKing)) | Bitboard(pawn));
+				Bitboard reached = getKingAttacks(Bitboard(black[blackKing]));
+
+				// Moves to the 8th rank are decided by the initial result
+				if (pawn.getRank() < RANK_7 && push != Square(blackKing)) {
+					reached |= Bitboard(kpkBitbase[(pawnIndex - 4) * 128 + 64 + blackKing]);
+
+					if (pawn.getRank() == RANK_2)
+						reached |= Bitboard(kpkBitbase[(pawnIndex - 8) * 128 + 64 + blackKing]) & ~Bitboard(push);
+				}
+
+				uint64_t won = white[blackKing] | (valid & reached).rawBits();
+
+				if (won != white[blackKing]) {
+					white[blackKing] = won;
+					whiteChanged = true;
+				}
+			}
+
+			if (whiteChanged) {
+				std::copy_n(white, 64, &whiteWon[pawnIndex * 64]);
+				transpose(&whiteWon[pawnIndex * 64]);
+				changed = true;
+			}
+		}
+	}
+
+	auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+	logInfo("KPK bitbase generated in " + std::to_string(elapsed.count() / 1000.0) + " ms, "
+		+ std::to_string(passes) + " passes");
+}
+
+void initBitbases()
+{
+	std::call_once(kpkOnce, generateKPK);
+}
+
+bool probeKPK(Color strongSide, Square strongKing, Square pawn, Square weakKing, Color current)
+{
+	initBitbases();
+
+	// Normalize to white pawn on files A-D
+	uint64_t flipRanks = strongSide == WHITE ? 0 : 56;
+	uint64_t flipFiles = pawn.getFile() >= FILE_E ? 7 : 0;
+	uint64_t flip = flipRanks ^ flipFiles;
+
+	Square whiteKing(strongKing.getIndex() ^ flip);
+	Square blackKing(weakKing.getIndex() ^ flip);
+	Square whitePawn(pawn.getIndex() ^ flip);
+	Color normalized = current == strongSide ? WHITE : BLACK;
+
+	int index = getIndex(normalized, blackKing, whiteKing, whitePawn);
+
+	return kpkBitbase[index / 64] & (1ull << (index % 64));
+}
+
+} // namespace vimlock
@@ -0,0 +1,18 @@
+#pragma once
+#include "Enums.h"
+#include "Square.h"
+
+namespace vimlock
+{
+
+/// Generate the KPK bitbase, unless already generated.
+/// Called automatically on first probe, but generating up front keeps the cost out of the search.
+void initBitbases();
+
+/// Returns true if king and pawn against king is won for the side with the pawn.
+///
+/// `strongSide` owns the pawn and `current` is the side to move. The position must be legal,
+/// kings must not be next to each other and the side not to move must not be in check.
+bool probeKPK(Color strongSide, Square strongKing, Square pawn, Square weakKing, Color current);
+
+} // namespace vimlock
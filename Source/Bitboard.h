@@ -43,6 +43,10 @@ public:
 	/// Returns first available square with a bit set.
 	constexpr Square findFirstSquare() const; 
 
+	/// Clears the first set bit and returns its square, used for iterating set bits.
+	/// Must not be called on an empty bitboard.
+	Square popFirstSquare();
+
 	/// Returns total number of bits set on the board.
 	constexpr int count() const;
 
@@ -102,7 +102,7 @@ inline constexpr int Bitboard::count() const
 inline constexpr Square Bitboard::findFirstSquare() const
 {
 #if defined(__GNUC__) || defined(__clang__)
-	return Square(__builtin_ffsll(bits));
+	return Square(bits ? static_cast<uint64_t>(__builtin_ctzll(bits)) : 0ULL);
 #else
 #warning "no optimized function for ffs"
 	for (unsigned i = 0; i < 64; ++i) {
@@ -113,6 +113,15 @@ inline constexpr Square Bitboard::findFirstSquare() const
 #endif
 }
 
+inline Square Bitboard::popFirstSquare()
+{
+	assert(bits);
+
+	Square ret = findFirstSquare();
+	bits &= bits - 1;
+	return ret;
+}
+
 inline constexpr Bitboard Bitboard::inverted() const
 {
 	return Bitboard(~bits);
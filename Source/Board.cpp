@@ -3,6 +3,9 @@
 #include "Format.h"
 #include "Log.h"
 
+#include <algorithm>
+#include <cctype>
+
 namespace vimlock
 {
 
@@ -26,6 +29,23 @@ void Board::clear()
 {
 	for (int i = 0; i < 64; ++i)
 		squares[i] = SquareState();
+
+	for (Bitboard &it : colorPieces)
+		it = Bitboard();
+
+	for (Bitboard &it : typePieces)
+		it = Bitboard();
+
+	pieceKey = 0;
+	pawnKey = 0;
+	materialKey = 0;
+
+	material[0] = material[1] = 0;
+	positional[0] = positional[1] = Score();
+	phase = 0;
+
+	halfmoveClock = 0;
+	fullmoveNumber = 1;
 }
 
 void Board::setStandardPosition()
@@ -107,6 +127,15 @@ bool Board::movePiece(Square src, Square dst, Piece promote)
 		return false;
 	}
 
+	// Clocks count moves of the pieces, not the promoted ones
+	if (tmp.getPiece() == PAWN || getSquare(dst).isOccupied())
+		halfmoveClock = 0;
+	else
+		halfmoveClock++;
+
+	if (tmp.getColor() == BLACK)
+		fullmoveNumber++;
+
 	if (promote != PAWN) {
 		tmp = SquareState(tmp.getColor(), promote);
 	}
@@ -118,13 +147,24 @@ bool Board::movePiece(Square src, Square dst, Piece promote)
 	castleRights = castleRights & ~Bitboard(src);
 
 	if (tmp.getPiece() == KING) {
+		Square rookSrc;
+		Square rookDst;
+
 		if (dst.getFile() == src.getFile() + 2) {
 			// Castling kingside
-			movePiece(Square(FILE_H, dst.getRank()), Square(FILE_F, dst.getRank()));
+			rookSrc = Square(FILE_H, dst.getRank());
+			rookDst = Square(FILE_F, dst.getRank());
 		}
 		else if (dst.getFile() == src.getFile() - 2) {
 			// Castling queenside
-			movePiece(Square(FILE_A, dst.getRank()), Square(FILE_D, dst.getRank()));
+			rookSrc = Square(FILE_A, dst.getRank());
+			rookDst = Square(FILE_D, dst.getRank());
+		}
+
+		if (rookSrc != rookDst) {
+			setSquare(rookDst, getSquare(rookSrc));
+			setSquare(rookSrc, SquareState());
+			castleRights = castleRights & ~Bitboard(rookSrc);
 		}
 	}
 
@@ -180,4 +220,234 @@ Bitboard Board::getMoves(Square idx) const
 	return getAvailableMoves(square.getColor(), square.getPiece(), idx, allPieces, ownPieces);
 }
 
+static const char *skipSpaces(const char *ptr, const char *end)
+{
+	while (ptr < end && (*ptr == ' ' || *ptr == '\t'))
+		ptr++;
+
+	return ptr;
+}
+
+/// Parse a non-negative number, returns false if there are no digits.
+static bool parseNumber(const char *&ptr, const char *end, int &ret)
+{
+	const char *start = ptr;
+
+	ret = 0;
+	while (ptr < end && *ptr >= '0' && *ptr <= '9' && ret < 100000)
+		ret = ret * 10 + (*ptr++ - '0');
+
+	return ptr != start;
+}
+
+static bool parsePieceChar(char c, Color &color, Piece &piece)
+{
+	color = c >= 'a' ? BLACK : WHITE;
+
+	switch (c | 0x20) {
+		case 'p': piece = PAWN; return true;
+		case 'n': piece = KNIGHT; return true;
+		case 'b': piece = BISHOP; return true;
+		case 'r': piece = ROOK; return true;
+		case 'q': piece = QUEEN; return true;
+		case 'k': piece = KING; return true;
+	}
+
+	return false;
+}
+
+static char getPieceChar(SquareState state)
+{
+	char c = ' ';
+
+	switch (state.getPiece()) {
+		case PAWN: c = 'p'; break;
+		case KNIGHT: c = 'n'; break;
+		case BISHOP: c = 'b'; break;
+		case ROOK: c = 'r'; break;
+		case QUEEN: c = 'q'; break;
+		case KING: c = 'k'; break;
+	}
+
+	return state.getColor() == WHITE ? c - 0x20 : c;
+}
+
+bool Board::fromFen(const std::string &fen)
+{
+	const char *end = fen.data() + fen.size();
+	const char *rest;
+
+	return fromFen(fen.data(), end, rest) && skipSpaces(rest, end) == end;
+}
+
+bool Board::fromFen(const char *ptr, const char *end, const char *&rest)
+{
+	clear();
+
+	ptr = skipSpaces(ptr, end);
+
+	// Pieces, from rank 8 to rank 1
+	int file = 0;
+	int rank = RANK_8;
+
+	for (; ptr < end && !isspace(static_cast<unsigned char>(*ptr)); ++ptr) {
+		char c = *ptr;
+		Color color;
+		Piece piece;
+
+		if (c == '/') {
+			if (file != 8 || rank == RANK_1)
+				return false;
+
+			file = 0;
+			rank--;
+		}
+		else if (c >= '1' && c <= '8') {
+			file += c - '0';
+			if (file > 8)
+				return false;
+		}
+		else if (parsePieceChar(c, color, piece) && file < 8) {
+			setSquare(Square(file++, rank), color, piece);
+		}
+		else {
+			return false;
+		}
+	}
+
+	if (file != 8 || rank != RANK_1)
+		return false;
+
+	// Side to move
+	ptr = skipSpaces(ptr, end);
+	if (ptr == end || (*ptr != 'w' && *ptr != 'b'))
+		return false;
+
+	current = *ptr++ == 'w' ? WHITE : BLACK;
+
+	// Castle rights, each a pair of king and rook squares
+	ptr = skipSpaces(ptr, end);
+	castleRights = Bitboard();
+
+	if (ptr < end && *ptr == '-') {
+		ptr++;
+	}
+	else {
+		const char *start = ptr;
+
+		for (; ptr < end && !isspace(static_cast<unsigned char>(*ptr)); ++ptr) {
+			switch (*ptr) {
+				case 'K': castleRights |= Bitboard(E1) | Bitboard(H1); break;
+				case 'Q': castleRights |= Bitboard(E1) | Bitboard(A1); break;
+				case 'k': castleRights |= Bitboard(E8) | Bitboard(H8); break;
+				case 'q': castleRights |= Bitboard(E8) | Bitboard(A8); break;
+				default: return false;
+			}
+		}
+
+		if (ptr == start)
+			return false;
+	}
+
+	// En passant target square, ignored unless a pawn has just moved past it
+	ptr = skipSpaces(ptr, end);
+	enpassantSquares = Bitboard();
+
+	if (ptr < end && *ptr == '-') {
+		ptr++;
+	}
+	else {
+		if (end - ptr < 2 || ptr[0] < 'a' || ptr[0] > 'h' || (ptr[1] != '3' && ptr[1] != '6'))
+			return false;
+
+		Square target = Square(ptr[0] - 'a', ptr[1] - '1');
+		Color mover = target.getRank() == RANK_3 ? WHITE : BLACK;
+		Square pawn = Square(target.getFile(), mover == WHITE ? RANK_4 : RANK_5);
+
+		if (current != mover && !getSquare(target).isOccupied() && getSquare(pawn).getBits() == SquareState(mover, PAWN).getBits())
+			enpassantSquares = Bitboard(target);
+
+		ptr += 2;
+	}
+
+	// Optional clocks
+	rest = ptr;
+	ptr = skipSpaces(ptr, end);
+
+	int halfmove;
+	int fullmove;
+
+	if (parseNumber(ptr, end, halfmove)) {
+		ptr = skipSpaces(ptr, end);
+
+		if (!parseNumber(ptr, end, fullmove))
+			return false;
+
+		halfmoveClock = halfmove;
+		fullmoveNumber = std::max(fullmove, 1);
+		rest = ptr;
+	}
+
+	return true;
+}
+
+std::string Board::toFen() const
+{
+	std::string ret;
+
+	for (int rank = RANK_8; rank >= RANK_1; --rank) {
+		int empty = 0;
+
+		for (int file = FILE_A; file <= FILE_H; ++file) {
+			SquareState state = getSquare(file, rank);
+
+			if (!state.isOccupied()) {
+				empty++;
+				continue;
+			}
+
+			if (empty)
+				ret += static_cast<char>('0' + empty);
+
+			empty = 0;
+			ret += getPieceChar(state);
+		}
+
+		if (empty)
+			ret += static_cast<char>('0' + empty);
+
+		if (rank != RANK_1)
+			ret += '/';
+	}
+
+	ret += current == WHITE ? " w " : " b ";
+
+	int castling = getCastleMask();
+
+	if (castling & 1)
+		ret += 'K';
+	if (castling & 2)
+		ret += 'Q';
+	if (castling & 4)
+		ret += 'k';
+	if (castling & 8)
+		ret += 'q';
+	if (!castling)
+		ret += '-';
+
+	if (enpassantSquares) {
+		Square target = enpassantSquares.findFirstSquare();
+		ret += ' ';
+		ret += static_cast<char>('a' + target.getFile());
+		ret += static_cast<char>('1' + target.getRank());
+	}
+	else {
+		ret += " -";
+	}
+
+	ret += ' ' + std::to_string(halfmoveClock) + ' ' + std::to_string(fullmoveNumber);
+
+	return ret;
+}
+
 } // namespace vimlock
@@ -3,6 +3,9 @@
 #include "Square.h"
 #include "Enums.h"
 #include "Bitboard.h"
+#include "Score.h"
+
+#include <string>
 
 namespace vimlock
 {
@@ -83,6 +86,24 @@ public:
 	/// Apply given moves to board state.
 	bool applyMoves(const MoveList &moves);
 
+	/// Set up the position described by a FEN string, e.g.
+	/// "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1".
+	/// Clocks may be left out. Returns false and leaves the board unspecified if the string is invalid.
+	bool fromFen(const std::string &fen);
+
+	/// Same as above, parsing from the start of a range and storing the end of the parsed
+	/// part into `rest`, e.g. for reading EPD operations following the position.
+	bool fromFen(const char *begin, const char *end, const char *&rest);
+
+	/// Return FEN string of the position.
+	std::string toFen() const;
+
+	/// Return number of plies since the last capture or pawn move, for the fifty move rule.
+	int getHalfmoveClock() const { return halfmoveClock; }
+
+	/// Return number of the move, starting from one and incremented after black moves.
+	int getFullmoveNumber() const { return fullmoveNumber; }
+
 	/// Returns true if given square can be castled to
 	/// 
 	/// G1: white kingside castle
@@ -114,7 +135,31 @@ public:
 	/// Return bitboard of pawns which are potentially targets for en passant.
 	Bitboard getEnPassantSquares() const { return enpassantSquares; }
 
+	/// Return sum of piece values of given color, kept up to date as pieces move.
+	int getMaterial(Color color) const;
+
+	/// Return sum of piece-square table scores of given color, kept up to date as pieces move.
+	/// Includes midgame and endgame material values.
+	Score getPositional(Color color) const;
+
+	/// Return game phase based on remaining pieces, see `MAX_PHASE`.
+	/// Can exceed `MAX_PHASE` after promotions.
+	int getPhase() const;
+
+	/// Return Zobrist hash of the position.
+	/// Includes side to move, castle rights and en passant file in addition to the pieces.
+	uint64_t getKey() const;
+
+	/// Return Zobrist hash of the pawns only, for caching pawn structure evaluation.
+	uint64_t getPawnKey() const;
+
+	/// Return hash of the number of pieces of each type and color, regardless of their squares.
+	uint64_t getMaterialKey() const;
+
 private:
+	/// Return castle rights packed into 4 bits, used for hashing.
+	int getCastleMask() const;
+
 	Bitboard getPawnMoves(Color color, Square idx) const;
 	Bitboard getPawnAttacks(Color color, Square idx) const;
 	Bitboard getRookMoves(Square idx) const;
@@ -126,6 +171,12 @@ private:
 	/// State of all the squares on the board.
 	SquareState squares[64];
 
+	/// Squares occupied by each color, indexed by `colorIndex()`.
+	Bitboard colorPieces[2];
+
+	/// Squares occupied by each piece type, indexed by `pieceIndex()`.
+	Bitboard typePieces[6];
+
 	/// Current players turn.
 	Color current = WHITE;
 
@@ -135,6 +186,26 @@ private:
 	/// Squares which are eligible for en passant.
 	Bitboard enpassantSquares;
 
+	/// Zobrist hash of the pieces, updated whenever a square changes.
+	uint64_t pieceKey = 0;
+
+	/// Zobrist hash of the pawns, subset of `pieceKey`.
+	uint64_t pawnKey = 0;
+
+	/// Hash of the piece counts, see `getMaterialKey()`.
+	uint64_t materialKey = 0;
+
+	/// Running totals of `getMaterial()` and `getPositional()`, indexed by `colorIndex()`.
+	int material[2] = { 0, 0 };
+	Score positional[2];
+
+	/// Running total of `getPhase()`.
+	int phase = 0;
+
+	/// See `getHalfmoveClock()` and `getFullmoveNumber()`.
+	int halfmoveClock = 0;
+	int fullmoveNumber = 1;
+
 	// TODO: en-passant state
 };
 
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "Board.h"
+#include "Psqt.h"
+#include "Zobrist.h"
 
 #include <cassert>
 
@@ -51,6 +53,47 @@ inline void Board::setSquare(RankAndFile idx, Color color, Piece piece)
 
 inline void Board::setSquare(Square idx, SquareState square)
 {
+	SquareState old = squares[idx.getIndex()];
+
+	Bitboard bit(idx);
+
+	if (old.isOccupied()) {
+		Color color = old.getColor();
+		Piece piece = old.getPiece();
+
+		pieceKey ^= Zobrist::piece(color, piece, idx);
+		if (piece == PAWN)
+			pawnKey ^= Zobrist::piece(color, piece, idx);
+
+		// Key of the piece count, count includes the removed piece
+		int count = (colorPieces[colorIndex(color)] & typePieces[pieceIndex(piece)]).count();
+		materialKey ^= Zobrist::pieces[colorIndex(color)][pieceIndex(piece)][count - 1];
+
+		colorPieces[colorIndex(color)] &= ~bit;
+		typePieces[pieceIndex(piece)] &= ~bit;
+		material[colorIndex(color)] -= getPieceValue(piece);
+		positional[colorIndex(color)] -= Psqt::get(color, piece, idx);
+		phase -= getPhaseWeight(piece);
+	}
+
+	if (square.isOccupied()) {
+		Color color = square.getColor();
+		Piece piece = square.getPiece();
+
+		pieceKey ^= Zobrist::piece(color, piece, idx);
+		if (piece == PAWN)
+			pawnKey ^= Zobrist::piece(color, piece, idx);
+
+		int count = (colorPieces[colorIndex(color)] & typePieces[pieceIndex(piece)]).count();
+		materialKey ^= Zobrist::pieces[colorIndex(color)][pieceIndex(piece)][count];
+
+		colorPieces[colorIndex(color)] |= bit;
+		typePieces[pieceIndex(piece)] |= bit;
+		material[colorIndex(color)] += getPieceValue(piece);
+		positional[colorIndex(color)] += Psqt::get(color, piece, idx);
+		phase += getPhaseWeight(piece);
+	}
+
 	squares[idx.getIndex()] = square;
 }
 
@@ -74,53 +117,75 @@ inline void Board::setCurrent(Color color)
 	current = color;
 }
 
-inline Bitboard Board::getPieces() const
+inline int Board::getMaterial(Color color) const
 {
-	Bitboard ret;
+	return material[colorIndex(color)];
+}
 
-	for (uint64_t i = 0; i < 64; ++i) {
-		SquareState square = getSquare(Square(i));
-		ret |= Bitboard((square.getBits() ? 1ULL : 0ULL) << i);
-	}
+inline Score Board::getPositional(Color color) const
+{
+	return positional[colorIndex(color)];
+}
 
-	return ret;
+inline int Board::getPhase() const
+{
+	return phase;
 }
 
-inline Bitboard Board::getPieces(Color color) const
+inline uint64_t Board::getKey() const
 {
-	Bitboard ret;
+	uint64_t ret = pieceKey ^ Zobrist::castling[getCastleMask()];
 
-	for (uint64_t i = 0; i < 64; ++i) {
-		SquareState square = getSquare(Square(i));
-		ret |= Bitboard(((square.getBits() & color) ? 1ULL : 0ULL) << i);
-	}
+	if (current == BLACK)
+		ret ^= Zobrist::side;
+
+	if (enpassantSquares)
+		ret ^= Zobrist::enpassant[enpassantSquares.findFirstSquare().getFile()];
 
 	return ret;
 }
 
-inline Bitboard Board::getPieces(Piece piece) const
+inline uint64_t Board::getPawnKey() const
 {
-	Bitboard ret;
+	return pawnKey;
+}
 
-	for (uint64_t i = 0; i < 64; ++i) {
-		SquareState square = getSquare(Square(i));
-		ret |= Bitboard(((square.getBits() & piece) ? 1ULL : 0ULL) << i);
-	}
+inline uint64_t Board::getMaterialKey() const
+{
+	return materialKey;
+}
 
-	return ret;
+inline int Board::getCastleMask() const
+{
+	Bitboard whitek = Bitboard(H1) | Bitboard(E1);
+	Bitboard whiteq = Bitboard(A1) | Bitboard(E1);
+	Bitboard blackk = Bitboard(H8) | Bitboard(E8);
+	Bitboard blackq = Bitboard(A8) | Bitboard(E8);
+
+	return ((castleRights & whitek) == whitek ? 1 : 0)
+		| ((castleRights & whiteq) == whiteq ? 2 : 0)
+		| ((castleRights & blackk) == blackk ? 4 : 0)
+		| ((castleRights & blackq) == blackq ? 8 : 0);
 }
 
-inline Bitboard Board::getPieces(Color color, Piece piece) const
+inline Bitboard Board::getPieces() const
+{
+	return colorPieces[0] | colorPieces[1];
+}
+
+inline Bitboard Board::getPieces(Color color) const
 {
-	Bitboard ret;
-	uint8_t mask  = color | piece;
+	return colorPieces[colorIndex(color)];
+}
 
-	for (uint64_t i = 0; i < 64; ++i) {
-		SquareState square = getSquare(Square(i));
-		ret |= Bitboard((((square.getBits() & mask) == mask) ? 1ULL : 0ULL) << i);
-	}
+inline Bitboard Board::getPieces(Piece piece) const
+{
+	return typePieces[pieceIndex(piece)];
+}
 
-	return ret;
+inline Bitboard Board::getPieces(Color color, Piece piece) const
+{
+	return colorPieces[colorIndex(color)] & typePieces[pieceIndex(piece)];
 }
 
 } // namespace vimlock
@@ -0,0 +1,89 @@
+#pragma once
+#include "Board.h"
+#include "Move.h"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace vimlock
+{
+
+/// Single move of an opening book, as stored in the file.
+struct BookEntry
+{
+	/// Hash of the position, see `Book::getKey()`.
+	uint64_t key;
+
+	/// Move in Polyglot encoding, see `Book::encodeMove()`.
+	uint16_t move;
+
+	/// Relative probability of playing the move.
+	uint16_t weight;
+
+	uint32_t learn;
+};
+
+/// Size of a single entry in the file.
+constexpr size_t BOOK_ENTRY_SIZE = 16;
+
+/// Opening book in Polyglot format, memory mapped from a `.bin` file.
+///
+/// The file is an array of big endian entries sorted by key, so a position is found by
+/// binary search without reading the whole file. Castling is stored as the king capturing
+/// its own rook. Keys use the table of random numbers published with the format, so books
+/// built by other tools can be read.
+class Book
+{
+public:
+	Book();
+	~Book();
+
+	Book(const Book &) = delete;
+	Book & operator = (const Book &) = delete;
+
+	/// Map the book from a file, empty path closes the current book.
+	/// Returns false and closes the current book if the file is missing or invalid.
+	bool load(const std::string &path);
+
+	/// Returns true if a book is loaded.
+	bool isLoaded() const { return map != nullptr; }
+
+	/// Return number of entries in the book.
+	size_t getSize() const { return count; }
+
+	/// Store all entries of the position into `ret`, ordered as in the file.
+	void getEntries(const Board &board, std::vector<BookEntry> &ret) const;
+
+	/// Pick a legal book move of the position, with probability based on the weights.
+	/// Returns false if the position is not in the book.
+	bool probe(const Board &board, Move &ret);
+
+	/// Return hash of the position, following Polyglot rules: en passant file is included
+	/// only if a pawn can capture en passant.
+	static uint64_t getKey(const Board &board);
+
+	/// Convert a move of the position into Polyglot encoding and back.
+	static uint16_t encodeMove(const Board &board, Move move);
+	static Move decodeMove(const Board &board, uint16_t move);
+
+	/// Write a single entry into `data`, in the layout of the file.
+	static void writeEntry(const BookEntry &entry, uint8_t *data);
+
+private:
+	BookEntry readEntry(size_t idx) const;
+
+	/// Index of the first entry with given key or greater.
+	size_t findFirst(uint64_t key) const;
+
+	void *map = nullptr;
+	size_t mapSize = 0;
+
+	const uint8_t *entries = nullptr;
+	size_t count = 0;
+
+	std::mt19937_64 random;
+};
+
+} // namespace vimlock
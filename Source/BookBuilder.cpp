@@ -0,0 +1,393 @@
+#include "BookBuilder.h"
+#include "Book.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+
+namespace vimlock
+{
+
+/// Number of games handed to a worker at a time.
+constexpr size_t batchSize = 256;
+
+/// Number of shards of the map, a power of two.
+constexpr int shardCount = 64;
+
+struct BookMoveKey
+{
+	uint64_t key;
+	uint16_t move;
+
+	bool operator == (const BookMoveKey &rhs) const
+	{
+		return key == rhs.key && move == rhs.move;
+	}
+};
+
+struct BookMoveKeyHash
+{
+	size_t operator () (const BookMoveKey &value) const
+	{
+		return static_cast<size_t>(value.key ^ (value.move * 0x9E3779B97F4A7C15ULL));
+	}
+};
+
+struct BookMoveStats
+{
+	/// Number of times the move was played.
+	uint32_t games;
+
+	/// Sum of results for the side playing the move: 2 for a win, 1 for a draw.
+	uint32_t score;
+};
+
+struct BookBuilderShard
+{
+	std::mutex mutex;
+	std::unordered_map<BookMoveKey, BookMoveStats, BookMoveKeyHash> moves;
+};
+
+/// Single move of a run file.
+struct RunRecord
+{
+	uint64_t key;
+	uint16_t move;
+	uint32_t games;
+	uint32_t score;
+
+	bool operator < (const RunRecord &rhs) const
+	{
+		return key < rhs.key || (key == rhs.key && move < rhs.move);
+	}
+};
+
+// NOTE: run files are temporary, values are written in host byte order.
+template <typename T>
+static void writeValue(std::ostream &stream, const T &value)
+{
+	stream.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+static void readValue(std::istream &stream, T &value)
+{
+	stream.read(reinterpret_cast<char *>(&value), sizeof(T));
+}
+
+static void writeRecord(std::ostream &stream, const RunRecord &record)
+{
+	writeValue(stream, record.key);
+	writeValue(stream, record.move);
+	writeValue(stream, record.games);
+	writeValue(stream, record.score);
+}
+
+static bool readRecord(std::istream &stream, RunRecord &record)
+{
+	readValue(stream, record.key);
+	readValue(stream, record.move);
+	readValue(stream, record.games);
+	readValue(stream, record.score);
+
+	return static_cast<bool>(stream);
+}
+
+BookBuilder::BookBuilder(const Options &options_):
+	options(options_),
+	entries(0),
+	failed(false),
+	games(0),
+	positions(0)
+{
+	options.threads = std::max(options.threads, 1);
+	options.maxEntries = std::max<size_t>(options.maxEntries, 1);
+
+	for (int i = 0; i < shardCount; ++i)
+		shards.emplace_back(new BookBuilderShard());
+}
+
+BookBuilder::~BookBuilder()
+{
+	for (const std::string &it : runs)
+		remove(it.c_str());
+}
+
+void BookBuilder::addMove(uint64_t key, uint16_t move, uint32_t score)
+{
+	BookBuilderShard &shard = *shards[key >> 58 & (shardCount - 1)];
+	std::lock_guard<std::mutex> lock(shard.mutex);
+
+	auto it = shard.moves.find(BookMoveKey{key, move});
+
+	if (it == shard.moves.end()) {
+		shard.moves.emplace(BookMoveKey{key, move}, BookMoveStats{1, score});
+		entries++;
+	}
+	else {
+		it->second.games++;
+		it->second.score += score;
+	}
+}
+
+void BookBuilder::addGame(const PgnGame &game)
+{
+	// Only games from the standard position
+	if (game.tags.count("FEN") || game.tags.count("SetUp"))
+		return;
+
+	Board board;
+	board.setStandardPosition();
+
+	games++;
+
+	int plies = std::min<int>(options.maxPly, static_cast<int>(game.moves.size()));
+
+	for (int i = 0; i < plies; ++i) {
+		Move move;
+		if (!parseSan(board, game.moves[i], move))
+			break;
+
+		// Games without a result count as draws
+		uint32_t score = 1;
+		if (game.result == RESULT_WHITE_WINS)
+			score = board.getCurrent() == WHITE ? 2 : 0;
+		else if (game.result == RESULT_BLACK_WINS)
+			score = board.getCurrent() == BLACK ? 2 : 0;
+
+		addMove(Book::getKey(board), Book::encodeMove(board, move), score);
+		positions++;
+
+		board.movePiece(move.getSource(), move.getDestination(), move.getPromotion());
+		board.flipCurrent();
+	}
+}
+
+bool BookBuilder::addFile(const std::string &path)
+{
+	std::ifstream stream(path);
+	if (!stream) {
+		logError("Can't open PGN file: " + path);
+		return false;
+	}
+
+	PgnReader reader(stream);
+
+	// Batches of games waiting for a worker, bounded so that reading doesn't run ahead
+	std::mutex mutex;
+	std::condition_variable changed;
+	std::deque<std::vector<PgnGame>> queue;
+	bool done = false;
+
+	const size_t maxQueued = 2 * options.threads;
+
+	auto worker = [&]() {
+		while (true) {
+			std::vector<PgnGame> batch;
+
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				changed.wait(lock, [&]() { return done || !queue.empty(); });
+
+				if (queue.empty())
+					break;
+
+				batch = std::move(queue.front());
+				queue.pop_front();
+			}
+
+			changed.notify_all();
+
+			for (const PgnGame &game : batch) {
+				addGame(game);
+
+				if (entries >= options.maxEntries) {
+					std::lock_guard<std::mutex> lock(spillMutex);
+
+					// Another thread may have spilled while waiting
+					if (entries >= options.maxEntries && !spill())
+						failed = true;
+				}
+			}
+		}
+	};
+
+	std::vector<std::thread> pool;
+	for (int i = 0; i < options.threads; ++i)
+		pool.emplace_back(worker);
+
+	std::vector<PgnGame> batch;
+	PgnGame game;
+
+	while (!failed) {
+		bool more = reader.readGame(game);
+
+		if (more)
+			batch.push_back(std::move(game));
+
+		if (batch.size() == batchSize || (!more && !batch.empty())) {
+			std::unique_lock<std::mutex> lock(mutex);
+			changed.wait(lock, [&]() { return queue.size() < maxQueued; });
+
+			queue.push_back(std::move(batch));
+			batch.clear();
+
+			lock.unlock();
+			changed.notify_all();
+		}
+
+		if (!more)
+			break;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		done = true;
+	}
+
+	changed.notify_all();
+
+	for (std::thread &it : pool)
+		it.join();
+
+	return !failed;
+}
+
+bool BookBuilder::spill()
+{
+	std::vector<RunRecord> records;
+
+	for (std::unique_ptr<BookBuilderShard> &shard : shards) {
+		std::lock_guard<std::mutex> lock(shard->mutex);
+
+		for (const auto &it : shard->moves)
+			records.push_back(RunRecord{it.first.key, it.first.move, it.second.games, it.second.score});
+
+		entries -= shard->moves.size();
+
+		// Release the memory too, clear() keeps the buckets
+		decltype(shard->moves)().swap(shard->moves);
+	}
+
+	std::sort(records.begin(), records.end());
+
+	std::string path = options.tempPrefix + "." + std::to_string(runs.size());
+	std::ofstream stream(path, std::ios::binary);
+
+	for (const RunRecord &it : records)
+		writeRecord(stream, it);
+
+	if (!stream) {
+		logError("Can't write run file: " + path);
+		return false;
+	}
+
+	runs.push_back(path);
+
+	return true;
+}
+
+/// Write entries of a single position, best moves first.
+static void writePosition(std::ostream &stream, std::vector<RunRecord> &moves, int minGames)
+{
+	moves.erase(std::remove_if(moves.begin(), moves.end(), [minGames](const RunRecord &it) {
+		return it.games < static_cast<uint32_t>(minGames);
+	}), moves.end());
+
+	if (moves.empty())
+		return;
+
+	std::stable_sort(moves.begin(), moves.end(), [](const RunRecord &a, const RunRecord &b) {
+		return a.score > b.score;
+	});
+
+	// Weights are relative, scale down to fit
+	uint32_t maxScore = moves.front().score;
+
+	for (const RunRecord &it : moves) {
+		BookEntry entry;
+		entry.key = it.key;
+		entry.move = it.move;
+		entry.weight = static_cast<uint16_t>(maxScore > 0xFFFF ? uint64_t(it.score) * 0xFFFF / maxScore : it.score);
+		entry.learn = 0;
+
+		uint8_t data[BOOK_ENTRY_SIZE];
+		Book::writeEntry(entry, data);
+		stream.write(reinterpret_cast<const char *>(data), sizeof(data));
+	}
+
+	moves.clear();
+}
+
+bool BookBuilder::write(const std::string &path)
+{
+	{
+		std::lock_guard<std::mutex> lock(spillMutex);
+
+		if ((entries > 0 || runs.empty()) && !spill())
+			return false;
+	}
+
+	std::vector<std::unique_ptr<std::ifstream>> inputs;
+
+	// Smallest record of each run first
+	typedef std::pair<RunRecord, size_t> Head;
+	auto greater = [](const Head &a, const Head &b) { return b.first < a.first; };
+	std::priority_queue<Head, std::vector<Head>, decltype(greater)> heads(greater);
+
+	for (const std::string &it : runs) {
+		inputs.emplace_back(new std::ifstream(it, std::ios::binary));
+
+		RunRecord record;
+		if (readRecord(*inputs.back(), record))
+			heads.push(Head(record, inputs.size() - 1));
+	}
+
+	std::ofstream stream(path, std::ios::binary);
+	if (!stream) {
+		logError("Can't write book file: " + path);
+		return false;
+	}
+
+	std::vector<RunRecord> position;
+
+	while (!heads.empty()) {
+		Head head = heads.top();
+		heads.pop();
+
+		RunRecord next;
+		if (readRecord(*inputs[head.second], next))
+			heads.push(Head(next, head.second));
+
+		const RunRecord &record = head.first;
+
+		if (!position.empty() && position.back().key != record.key)
+			writePosition(stream, position, options.minGames);
+
+		// Same move of the same position from another run
+		if (!position.empty() && position.back().key == record.key && position.back().move == record.move) {
+			position.back().games += record.games;
+			position.back().score += record.score;
+		}
+		else {
+			position.push_back(record);
+		}
+	}
+
+	writePosition(stream, position, options.minGames);
+
+	if (!stream) {
+		logError("Can't write book file: " + path);
+		return false;
+	}
+
+	return true;
+}
+
+} // namespace vimlock
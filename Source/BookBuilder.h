@@ -0,0 +1,90 @@
+#pragma once
+#include "Pgn.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace vimlock
+{
+
+struct BookBuilderShard;
+
+/// Builds a Polyglot opening book, see `Book`, from games of PGN files.
+///
+/// Games are replayed by worker threads, which count how often each move was played in
+/// each position and how it scored. Counts are kept in a hash map split into shards with
+/// their own locks. When the map grows past the entry limit, it's sorted and written into
+/// a run file, so memory use is bounded regardless of the input size. Finally the runs
+/// are merged into the book.
+class BookBuilder
+{
+public:
+	struct Options
+	{
+		/// Number of threads replaying games.
+		int threads = 1;
+
+		/// Number of plies from the start of each game to include.
+		int maxPly = 30;
+
+		/// Moves played fewer times are left out of the book.
+		int minGames = 1;
+
+		/// Number of distinct moves kept in memory before spilling them into a run file.
+		size_t maxEntries = 1 << 22;
+
+		/// Prefix of the run files, which are removed once merged.
+		std::string tempPrefix = "BookRun";
+	};
+
+	explicit BookBuilder(const Options &options);
+	~BookBuilder();
+
+	/// Add games of a PGN file. Games starting from a custom position or containing
+	/// an illegal move are skipped from that point on.
+	/// Returns false if the file can't be read or a run can't be written.
+	bool addFile(const std::string &path);
+
+	/// Merge everything added so far into a book file.
+	/// Returns false if a file can't be read or written.
+	bool write(const std::string &path);
+
+	/// Return number of games and positions replayed, and run files written.
+	uint64_t getGames() const { return games; }
+	uint64_t getPositions() const { return positions; }
+	size_t getRuns() const { return runs.size(); }
+
+private:
+	/// Replay a game, adding its moves to the map.
+	void addGame(const PgnGame &game);
+
+	/// Add a single move to the map.
+	void addMove(uint64_t key, uint16_t move, uint32_t score);
+
+	/// Write all entries of the map into a new run file, emptying the map.
+	bool spill();
+
+	Options options;
+
+	std::vector<std::unique_ptr<BookBuilderShard>> shards;
+
+	/// Number of entries in all the shards.
+	std::atomic<size_t> entries;
+
+	/// Held while spilling, so that only one thread writes a run at a time.
+	std::mutex spillMutex;
+
+	/// Set if writing a run failed.
+	std::atomic<bool> failed;
+
+	std::vector<std::string> runs;
+
+	std::atomic<uint64_t> games;
+	std::atomic<uint64_t> positions;
+};
+
+} // namespace vimlock
@@ -0,0 +1,997 @@
+#include "Dtm.h"
+#include "Log.h"
+#include "Moves.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace vimlock
+{
+
+/// Largest number of pieces, kings included. Five pieces need up to 3 bytes per index
+/// during generation, several gigabytes with pawns.
+constexpr int maxPieces = 5;
+
+/// Maximum number of moves a player can choose from during a single turn.
+constexpr int maxMoves = 256;
+
+/// Number of values in a compressed block of a file.
+constexpr uint32_t blockEntries = 4096;
+
+/// Number of indices processed by a thread at a time.
+constexpr uint64_t chunkSize = 4096;
+
+static const char fileMagic[8] = { 'V', 'D', 'T', 'M', 0, 0, 0, 0 };
+constexpr uint32_t fileVersion = 2;
+
+/// Encoding of a block is stored in the top bits of its offset: zero for runs, otherwise
+/// one more than the number of bits of each packed value.
+constexpr int blockEncodingShift = 56;
+constexpr uint64_t blockOffsetMask = (1ULL << blockEncodingShift) - 1;
+
+/// Size of the name in the file header, including the terminating zero.
+constexpr size_t fileNameSize = 16;
+
+/// Bytes before the block offsets: magic, version, block entries, entries, blocks and name.
+constexpr size_t headerSize = 8 + 4 + 4 + 8 + 8 + fileNameSize;
+
+/// Flag of move counts, set if a capture or promotion draws.
+constexpr uint8_t drawExitFlag = 0x80;
+
+/// White king square of each code and code of each square, without and with pawns.
+static int kingSquares[2][32];
+static int kingCodes[2][64];
+static const int kingSquareCount[2] = { 10, 32 };
+
+namespace
+{
+
+struct KingInit
+{
+	KingInit()
+	{
+		// Triangle A1-D1-D4 without pawns, files A-D with pawns
+		int code = 0;
+		for (int rank = RANK_1; rank <= RANK_4; ++rank) {
+			for (int file = rank; file <= FILE_D; ++file) {
+				kingSquares[0][code] = rank * 8 + file;
+				kingCodes[0][rank * 8 + file] = code++;
+			}
+		}
+
+		code = 0;
+		for (int rank = RANK_1; rank <= RANK_8; ++rank) {
+			for (int file = FILE_A; file <= FILE_D; ++file) {
+				kingSquares[1][code] = rank * 8 + file;
+				kingCodes[1][rank * 8 + file] = code++;
+			}
+		}
+	}
+};
+
+KingInit init;
+
+} // anonymous namespace
+
+/// Swap files and ranks, mirroring over the A1-H8 diagonal.
+static int transpose(int square)
+{
+	return ((square >> 3) | (square << 3)) & 63;
+}
+
+/// Parse material such as "KRvK" into a board with pieces on arbitrary squares.
+static bool parseMaterial(const std::string &name, Board &ret)
+{
+	ret.clear();
+
+	Color color = WHITE;
+	uint64_t square = 0;
+
+	for (char c : name) {
+		Piece piece;
+
+		switch (c) {
+			case 'K': piece = KING; break;
+			case 'Q': piece = QUEEN; break;
+			case 'R': piece = ROOK; break;
+			case 'B': piece = BISHOP; break;
+			case 'N': piece = KNIGHT; break;
+			case 'P': piece = PAWN; break;
+			case 'v':
+				if (color == BLACK)
+					return false;
+
+				color = BLACK;
+				continue;
+			default:
+				return false;
+		}
+
+		if (square >= maxPieces)
+			return false;
+
+		ret.setSquare(Square(square++), color, piece);
+	}
+
+	return color == BLACK
+		&& ret.getPieces(WHITE, KING).count() == 1
+		&& ret.getPieces(BLACK, KING).count() == 1;
+}
+
+/// Return board with colors swapped and ranks mirrored.
+static Board getFlipped(const Board &board)
+{
+	Board ret;
+	ret.clear();
+
+	Bitboard pieces = board.getPieces();
+	while (pieces) {
+		Square square = pieces.popFirstSquare();
+		SquareState state = board.getSquare(square);
+		ret.setSquare(Square(square.getIndex() ^ 56), flipColor(state.getColor()), state.getPiece());
+	}
+
+	ret.setCurrent(flipColor(board.getCurrent()));
+
+	return ret;
+}
+
+static bool isInCheck(const Board &board, Color color)
+{
+	Bitboard king = board.getPieces(color, KING);
+	return king && getAttackers(board, king.findFirstSquare(), board.getPieces(), board.getPieces(flipColor(color)));
+}
+
+/// Generate legal moves of the side to move, without castling and en passant.
+/// Returns number of moves stored in `ret`.
+static int getLegalMoves(const Board &board, Move *ret)
+{
+	Color own = board.getCurrent();
+
+	Bitboard allPieces = board.getPieces();
+	Bitboard ownPieces = board.getPieces(own);
+	Bitboard promotionRank = Bitboard::rank(own == WHITE ? RANK_8 : RANK_1);
+
+	int count = 0;
+	Bitboard pieces = ownPieces;
+
+	while (pieces) {
+		Square src = pieces.popFirstSquare();
+		Piece piece = board.getSquare(src).getPiece();
+
+		Bitboard moves = getAvailableMoves(own, piece, src, allPieces, ownPieces);
+
+		while (moves) {
+			Square dst = moves.popFirstSquare();
+
+			Board next = board;
+			next.movePiece(src, dst);
+
+			if (isInCheck(next, own))
+				continue;
+
+			if (piece == PAWN && (Bitboard(dst) & promotionRank)) {
+				for (Piece promote : { QUEEN, ROOK, BISHOP, KNIGHT })
+					ret[count++] = Move(src, dst, promote);
+			}
+			else {
+				ret[count++] = Move(src, dst);
+			}
+		}
+	}
+
+	return count;
+}
+
+/// Generate distinct indices of positions leading to given position by a move which is
+/// neither a capture nor a promotion. Returns number of indices stored in `ret`.
+static int getPredecessors(const DtmIndex &index, const Board &board, uint64_t *ret)
+{
+	Color mover = flipColor(board.getCurrent());
+	Bitboard allPieces = board.getPieces();
+	Bitboard pieces = board.getPieces(mover);
+
+	int count = 0;
+
+	while (pieces) {
+		Square dst = pieces.popFirstSquare();
+		SquareState state = board.getSquare(dst);
+
+		Bitboard sources;
+
+		if (state.getPiece() == PAWN) {
+			// Single step back, or two from the rank after a double move
+			int back = mover == WHITE ? -8 : 8;
+			int doubleRank = mover == WHITE ? RANK_4 : RANK_5;
+			int firstRank = mover == WHITE ? RANK_2 : RANK_7;
+
+			Square one = Square(static_cast<uint64_t>(static_cast<int>(dst.getIndex()) + back));
+
+			if (!(allPieces & Bitboard(one))) {
+				if ((mover == WHITE ? one.getRank() >= firstRank : one.getRank() <= firstRank))
+					sources |= Bitboard(one);
+
+				Square two = Square(static_cast<uint64_t>(static_cast<int>(one.getIndex()) + back));
+
+				if (dst.getRank() == doubleRank && !(allPieces & Bitboard(two)))
+					sources |= Bitboard(two);
+			}
+		}
+		else {
+			// Other pieces move back the same way they move forward
+			sources = getAvailableCaptures(mover, state.getPiece(), dst, allPieces) & ~allPieces;
+		}
+
+		while (sources) {
+			Board prev = board;
+			prev.setSquare(sources.popFirstSquare(), state);
+			prev.setSquare(dst, SquareState());
+			prev.setCurrent(mover);
+
+			index.getIndex(prev, ret[count++]);
+		}
+	}
+
+	std::sort(ret, ret + count);
+	return static_cast<int>(std::unique(ret, ret + count) - ret);
+}
+
+/// Call `fn` with each index below `count`, from given number of threads.
+template <typename Function>
+static void parallelFor(uint64_t count, int threads, Function fn)
+{
+	std::atomic<uint64_t> next(0);
+
+	auto worker = [&]() {
+		while (true) {
+			uint64_t begin = next.fetch_add(chunkSize);
+			if (begin >= count)
+				break;
+
+			uint64_t end = std::min(begin + chunkSize, count);
+			for (uint64_t i = begin; i < end; ++i)
+				fn(i);
+		}
+	};
+
+	std::vector<std::thread> pool;
+	for (int i = 1; i < threads; ++i)
+		pool.emplace_back(worker);
+
+	worker();
+
+	for (std::thread &it : pool)
+		it.join();
+}
+
+/// Store `value` into `target` if it's greater.
+static void updateMax(std::atomic<int> &target, int value)
+{
+	int current = target.load(std::memory_order_relaxed);
+	while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed));
+}
+
+bool DtmIndex::parse(const std::string &name_)
+{
+	Board board;
+	if (!parseMaterial(name_, board))
+		return false;
+
+	name = name_;
+	colors.clear();
+	pieces.clear();
+
+	// Kings first, then the rest from the most valuable so that identical pieces are next to each other
+	colors.push_back(WHITE);
+	pieces.push_back(KING);
+	colors.push_back(BLACK);
+	pieces.push_back(KING);
+
+	for (Color color : { WHITE, BLACK }) {
+		for (Piece piece : { QUEEN, ROOK, BISHOP, KNIGHT, PAWN }) {
+			for (int i = 0; i < board.getPieces(color, piece).count(); ++i) {
+				colors.push_back(color);
+				pieces.push_back(piece);
+			}
+		}
+	}
+
+	hasPawns = bool(board.getPieces(PAWN));
+
+	size = 2 * kingSquareCount[hasPawns];
+	for (size_t i = 1; i < pieces.size(); ++i)
+		size *= pieces[i] == PAWN ? 48 : 64;
+
+	key = board.getMaterialKey();
+	flippedKey = getFlipped(board).getMaterialKey();
+
+	return true;
+}
+
+std::string DtmIndex::getName(const Board &board)
+{
+	std::string sides[2];
+
+	for (Color color : { WHITE, BLACK }) {
+		std::string &side = sides[colorIndex(color)];
+		side = "K";
+
+		const char chars[] = { 'Q', 'R', 'B', 'N', 'P' };
+		const Piece types[] = { QUEEN, ROOK, BISHOP, KNIGHT, PAWN };
+
+		for (int i = 0; i < 5; ++i)
+			side.append(board.getPieces(color, types[i]).count(), chars[i]);
+	}
+
+	int white = board.getMaterial(WHITE);
+	int black = board.getMaterial(BLACK);
+
+	if (white > black || (white == black && sides[0] >= sides[1]))
+		return sides[0] + "v" + sides[1];
+	else
+		return sides[1] + "v" + sides[0];
+}
+
+uint64_t DtmIndex::encode(const Board &board, bool flip, int transform) const
+{
+	auto transformSquare = [flip, transform](Square square) {
+		int ret = static_cast<int>(square.getIndex());
+
+		if (flip)
+			ret ^= 56;
+		if (transform & 1)
+			ret ^= 7;
+		if (transform & 2)
+			ret ^= 56;
+		if (transform & 4)
+			ret = transpose(ret);
+
+		return ret;
+	};
+
+	Color current = flip ? flipColor(board.getCurrent()) : board.getCurrent();
+
+	uint64_t ret = current == WHITE ? 0 : 1;
+	uint64_t multiplier = 2;
+
+	for (size_t i = 0; i < pieces.size(); ) {
+		// Identical pieces in the order of their squares
+		size_t end = i;
+		while (end < pieces.size() && pieces[end] == pieces[i] && colors[end] == colors[i])
+			end++;
+
+		Bitboard group = board.getPieces(flip ? flipColor(colors[i]) : colors[i], pieces[i]);
+
+		int squares[maxPieces];
+		int count = 0;
+
+		while (group)
+			squares[count++] = transformSquare(group.popFirstSquare());
+
+		assert(count == static_cast<int>(end - i));
+		std::sort(squares, squares + count);
+
+		for (size_t k = i; k < end; ++k) {
+			int square = squares[k - i];
+
+			if (k == 0) {
+				ret += kingCodes[hasPawns][square] * multiplier;
+				multiplier *= kingSquareCount[hasPawns];
+			}
+			else if (pieces[k] == PAWN) {
+				ret += (square - 8) * multiplier;
+				multiplier *= 48;
+			}
+			else {
+				ret += square * multiplier;
+				multiplier *= 64;
+			}
+		}
+
+		i = end;
+	}
+
+	return ret;
+}
+
+bool DtmIndex::getIndex(const Board &board, uint64_t &ret) const
+{
+	bool flip;
+
+	if (board.getMaterialKey() == key)
+		flip = false;
+	else if (board.getMaterialKey() == flippedKey)
+		flip = true;
+	else
+		return false;
+
+	// Move the white king to files A-D, and without pawns below rank 5 and the diagonal
+	int king = static_cast<int>(board.getPieces(flip ? BLACK : WHITE, KING).findFirstSquare().getIndex());
+	if (flip)
+		king ^= 56;
+
+	int transform = 0;
+
+	if ((king & 7) > FILE_D) {
+		transform |= 1;
+		king ^= 7;
+	}
+
+	if (!hasPawns) {
+		if ((king >> 3) > RANK_4) {
+			transform |= 2;
+			king ^= 56;
+		}
+
+		if ((king >> 3) > (king & 7)) {
+			transform |= 4;
+			king = transpose(king);
+		}
+	}
+
+	ret = encode(board, flip, transform);
+
+	// On the diagonal both sides of it are equivalent, pick the lower index
+	if (!hasPawns && (king >> 3) == (king & 7))
+		ret = std::min(ret, encode(board, flip, transform ^ 4));
+
+	return true;
+}
+
+bool DtmIndex::getBoard(uint64_t idx, Board &ret) const
+{
+	uint64_t rest = idx;
+
+	ret.clear();
+	ret.setCurrent(rest % 2 ? BLACK : WHITE);
+	rest /= 2;
+
+	for (size_t k = 0; k < pieces.size(); ++k) {
+		int square;
+
+		if (k == 0) {
+			square = kingSquares[hasPawns][rest % kingSquareCount[hasPawns]];
+			rest /= kingSquareCount[hasPawns];
+		}
+		else if (pieces[k] == PAWN) {
+			square = static_cast<int>(rest % 48) + 8;
+			rest /= 48;
+		}
+		else {
+			square = static_cast<int>(rest % 64);
+			rest /= 64;
+		}
+
+		Square s = Square(static_cast<uint64_t>(square));
+		if (ret.getSquare(s).isOccupied())
+			return false;
+
+		ret.setSquare(s, colors[k], pieces[k]);
+	}
+
+	// Only one of the symmetric positions and orders of identical pieces is used
+	uint64_t check;
+	return getIndex(ret, check) && check == idx;
+}
+
+DtmTable::DtmTable()
+{
+}
+
+DtmTable::~DtmTable()
+{
+	if (map)
+		munmap(map, mapSize);
+}
+
+// NOTE: values are read and written in host byte order, which is little endian on supported CPUs.
+template <typename T>
+static T readValue(const uint8_t *data)
+{
+	T ret;
+	memcpy(&ret, data, sizeof(T));
+	return ret;
+}
+
+template <typename T>
+static void writeValue(std::ostream &stream, const T &value)
+{
+	stream.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+bool DtmTable::load(const std::string &path)
+{
+	if (map) {
+		munmap(map, mapSize);
+		map = nullptr;
+	}
+
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < headerSize) {
+		close(fd);
+		return false;
+	}
+
+	size_t size = st.st_size;
+	void *tmp = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (tmp == MAP_FAILED)
+		return false;
+
+	const uint8_t *header = static_cast<const uint8_t *>(tmp);
+
+	char name[fileNameSize];
+	memcpy(name, header + headerSize - fileNameSize, fileNameSize);
+	name[fileNameSize - 1] = 0;
+
+	uint32_t entries = readValue<uint32_t>(header + 12);
+	uint64_t count = readValue<uint64_t>(header + 16);
+	uint64_t blocks = readValue<uint64_t>(header + 24);
+
+	bool valid = memcmp(header, fileMagic, sizeof(fileMagic)) == 0
+		&& readValue<uint32_t>(header + 8) == fileVersion
+		&& entries > 0
+		&& index.parse(name)
+		&& count == index.getSize()
+		&& blocks == (count + entries - 1) / entries
+		&& size >= headerSize + (blocks + 1) * 8;
+
+	if (valid) {
+		uint64_t dataSize = readValue<uint64_t>(header + headerSize + blocks * 8);
+		valid = size >= headerSize + (blocks + 1) * 8 + dataSize;
+	}
+
+	if (!valid) {
+		logError("Invalid DTM table: " + path);
+		munmap(tmp, size);
+		return false;
+	}
+
+	map = tmp;
+	mapSize = size;
+	blockEntries = entries;
+	offsets = header + headerSize;
+	data = offsets + (blocks + 1) * 8;
+
+	return true;
+}
+
+uint8_t DtmTable::getValue(uint64_t idx) const
+{
+	uint64_t block = idx / blockEntries;
+	uint64_t offset = idx % blockEntries;
+
+	uint64_t start = readValue<uint64_t>(offsets + block * 8);
+	int encoding = static_cast<int>(start >> blockEncodingShift);
+	const uint8_t *run = data + (start & blockOffsetMask);
+
+	if (encoding == 0) {
+		// Pairs of value and run length minus one
+		while (offset > run[1]) {
+			offset -= run[1] + 1;
+			run += 2;
+		}
+
+		return run[0];
+	}
+
+	// Values packed after the smallest one, which full bytes don't need
+	int bits = encoding - 1;
+	if (bits == 0)
+		return run[0];
+
+	uint8_t base = 0;
+	if (bits < 8)
+		base = *run++;
+
+	uint64_t pos = offset * bits;
+	unsigned packed = run[pos / 8] >> (pos % 8);
+
+	if (pos % 8 + bits > 8)
+		packed |= static_cast<unsigned>(run[pos / 8 + 1]) << (8 - pos % 8);
+
+	return static_cast<uint8_t>(base + (packed & ((1u << bits) - 1)));
+}
+
+bool DtmTable::probe(const Board &board, uint8_t &ret) const
+{
+	uint64_t idx;
+	if (!map || !index.getIndex(board, idx))
+		return false;
+
+	ret = getValue(idx);
+	return true;
+}
+
+DtmGenerator::DtmGenerator(int threads_):
+	threads(std::max(threads_, 1))
+{
+}
+
+DtmGenerator::~DtmGenerator()
+{
+}
+
+bool DtmGenerator::generate(const std::string &name)
+{
+	std::unique_ptr<Table> table(new Table());
+
+	Board material;
+	// Bare kings are always drawn and have no table
+	if (!table->index.parse(name) || !parseMaterial(name, material) || material.getPieces().count() < 3)
+		return false;
+
+	if (keys.count(table->index.getKey()))
+		return true;
+
+	// Captures and promotions lead to smaller tables
+	Bitboard pieces = material.getPieces() & ~material.getPieces(KING);
+
+	while (pieces) {
+		Square square = pieces.popFirstSquare();
+		SquareState state = material.getSquare(square);
+
+		Board next = material;
+		next.setSquare(square, SquareState());
+
+		if (next.getPieces().count() > 2 && !generate(DtmIndex::getName(next)))
+			return false;
+
+		if (state.getPiece() != PAWN)
+			continue;
+
+		for (Piece promote : { QUEEN, ROOK, BISHOP, KNIGHT }) {
+			next.setSquare(square, SquareState(state.getColor(), promote));
+
+			if (!generate(DtmIndex::getName(next)))
+				return false;
+		}
+	}
+
+	auto start = std::chrono::steady_clock::now();
+
+	if (!analyze(*table)) {
+		logError("Mate takes too many plies to store in table " + name);
+		return false;
+	}
+
+	auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+	logInfo("Generated " + name + " with " + std::to_string(table->index.getSize()) + " indices in " + std::to_string(elapsed.count()) + " ms");
+
+	keys[table->index.getKey()] = table.get();
+	keys[table->index.getFlippedKey()] = table.get();
+	tables.push_back(std::move(table));
+
+	return true;
+}
+
+std::vector<std::string> DtmGenerator::getNames() const
+{
+	std::vector<std::string> ret;
+
+	for (const std::unique_ptr<Table> &it : tables)
+		ret.push_back(it->index.getName());
+
+	return ret;
+}
+
+const DtmGenerator::Table * DtmGenerator::findTable(const Board &board) const
+{
+	auto it = keys.find(board.getMaterialKey());
+	return it == keys.end() ? nullptr : it->second;
+}
+
+bool DtmGenerator::probe(const Board &board, uint8_t &ret) const
+{
+	// Bare kings
+	if (board.getPieces().count() == 2) {
+		ret = DTM_DRAW;
+		return true;
+	}
+
+	const Table *table = findTable(board);
+	if (!table)
+		return false;
+
+	uint64_t idx;
+	table->index.getIndex(board, idx);
+	ret = table->values[idx].load(std::memory_order_relaxed);
+
+	return true;
+}
+
+bool DtmGenerator::analyze(Table &table)
+{
+	const DtmIndex &index = table.index;
+	uint64_t size = index.getSize();
+
+	std::atomic<uint8_t> *values = new std::atomic<uint8_t>[size];
+	table.values.reset(values);
+
+	// Number of distinct positions reachable by moves staying in the table, and the best
+	// result of captures and promotions
+	std::unique_ptr<std::atomic<uint8_t>[]> counts(new std::atomic<uint8_t>[size]);
+	std::unique_ptr<uint8_t[]> exits(new uint8_t[size]);
+
+	std::atomic<int> maxPlies(0);
+	std::atomic<bool> overflow(false);
+
+	parallelFor(size, threads, [&](uint64_t idx) {
+		Board board;
+
+		counts[idx].store(0, std::memory_order_relaxed);
+		exits[idx] = DTM_DRAW;
+
+		if (!index.getBoard(idx, board) || isInCheck(board, flipColor(board.getCurrent()))) {
+			values[idx].store(DTM_INVALID, std::memory_order_relaxed);
+			return;
+		}
+
+		Move moves[maxMoves];
+		int movesCount = getLegalMoves(board, moves);
+
+		if (movesCount == 0) {
+			// Mated or stalemate
+			values[idx].store(isInCheck(board, board.getCurrent()) ? 1 : DTM_DRAW, std::memory_order_relaxed);
+			return;
+		}
+
+		uint64_t children[maxMoves];
+		int childrenCount = 0;
+
+		int win = -1;
+		int loss = -1;
+		bool draw = false;
+
+		for (int i = 0; i < movesCount; ++i) {
+			Move move = moves[i];
+
+			Board next = board;
+			bool exit = move.hasPromotion() || next.getSquare(move.getDestination()).isOccupied();
+
+			next.movePiece(move.getSource(), move.getDestination(), move.getPromotion());
+			next.flipCurrent();
+
+			if (!exit) {
+				index.getIndex(next, children[childrenCount++]);
+				continue;
+			}
+
+			uint8_t value;
+			bool found = probe(next, value);
+			assert(found && "smaller tables are generated first");
+			(void)found;
+
+			if (value == DTM_DRAW)
+				draw = true;
+			else if (isDtmWin(value))
+				loss = std::max(loss, getDtmPlies(value) + 1);
+			else if (win < 0 || getDtmPlies(value) + 1 < win)
+				win = getDtmPlies(value) + 1;
+		}
+
+		std::sort(children, children + childrenCount);
+		childrenCount = static_cast<int>(std::unique(children, children + childrenCount) - children);
+
+		assert(childrenCount < drawExitFlag);
+
+		int exit = win >= 0 ? win : loss;
+		if (exit + 1 >= DTM_INVALID) {
+			overflow = true;
+			return;
+		}
+
+		uint8_t value = DTM_DRAW;
+
+		// Nothing but losing captures and promotions
+		if (childrenCount == 0 && win < 0 && !draw)
+			value = static_cast<uint8_t>(loss + 1);
+
+		if (exit >= 0) {
+			exits[idx] = static_cast<uint8_t>(exit + 1);
+			updateMax(maxPlies, exit);
+		}
+
+		values[idx].store(value, std::memory_order_relaxed);
+		counts[idx].store(static_cast<uint8_t>(childrenCount | (draw ? drawExitFlag : 0)), std::memory_order_relaxed);
+	});
+
+	for (int plies = 0; !overflow; ++plies) {
+		uint8_t code = static_cast<uint8_t>(plies + 1);
+		std::atomic<uint64_t> resolved(0);
+
+		if (plies + 2 >= DTM_INVALID) {
+			overflow = true;
+			break;
+		}
+
+		parallelFor(size, threads, [&](uint64_t idx) {
+			uint8_t value = values[idx].load(std::memory_order_relaxed);
+
+			// Winning capture or promotion, unless something faster was found
+			if ((plies & 1) && value == DTM_DRAW && exits[idx] == code) {
+				values[idx].compare_exchange_strong(value, code, std::memory_order_relaxed);
+				value = values[idx].load(std::memory_order_relaxed);
+			}
+
+			if (value != code)
+				return;
+
+			resolved.fetch_add(1, std::memory_order_relaxed);
+
+			Board board;
+			index.getBoard(idx, board);
+
+			uint64_t predecessors[maxMoves];
+			int count = getPredecessors(index, board, predecessors);
+
+			for (int i = 0; i < count; ++i) {
+				uint64_t prev = predecessors[i];
+				uint8_t expected = DTM_DRAW;
+
+				if (values[prev].load(std::memory_order_relaxed) == DTM_INVALID)
+					continue;
+
+				if (!(plies & 1)) {
+					// Moving into a lost position wins
+					values[prev].compare_exchange_strong(expected, code + 1, std::memory_order_relaxed);
+					continue;
+				}
+
+				// Lost once all moves lead to positions won by the opponent
+				uint8_t moves = counts[prev].fetch_sub(1, std::memory_order_relaxed);
+				assert(moves & ~drawExitFlag);
+
+				if ((moves & ~drawExitFlag) != 1 || (moves & drawExitFlag))
+					continue;
+
+				uint8_t exit = exits[prev];
+				if (exit != DTM_DRAW && isDtmWin(exit))
+					continue;
+
+				int loss = std::max(plies + 1, exit != DTM_DRAW ? getDtmPlies(exit) : 0);
+				if (loss + 1 >= DTM_INVALID) {
+					overflow = true;
+					continue;
+				}
+
+				values[prev].compare_exchange_strong(expected, static_cast<uint8_t>(loss + 1), std::memory_order_relaxed);
+				updateMax(maxPlies, loss);
+			}
+		});
+
+		// Nothing new can be found once past all the scheduled results
+		if (resolved == 0 && plies >= maxPlies)
+			break;
+	}
+
+	return !overflow;
+}
+
+bool DtmGenerator::save(const std::string &name, const std::string &path) const
+{
+	const Table *table = nullptr;
+
+	for (const std::unique_ptr<Table> &it : tables) {
+		if (it->index.getName() == name)
+			table = it.get();
+	}
+
+	if (!table || name.size() >= fileNameSize)
+		return false;
+
+	uint64_t size = table->index.getSize();
+	uint64_t blocks = (size + blockEntries - 1) / blockEntries;
+
+	std::vector<uint64_t> offsets;
+	std::vector<uint8_t> data;
+
+	std::vector<uint8_t> runs;
+	std::vector<uint8_t> packed;
+
+	for (uint64_t block = 0; block < blocks; ++block) {
+		uint64_t begin = block * blockEntries;
+		uint64_t end = std::min(begin + blockEntries, size);
+
+		uint8_t low = DTM_INVALID;
+		uint8_t high = DTM_DRAW;
+
+		for (uint64_t i = begin; i < end; ++i) {
+			uint8_t value = table->values[i].load(std::memory_order_relaxed);
+
+			if (value != DTM_INVALID) {
+				low = std::min(low, value);
+				high = std::max(high, value);
+			}
+		}
+
+		if (low > high)
+			low = high = DTM_DRAW;
+
+		runs.clear();
+
+		for (uint64_t i = begin; i < end; ++i) {
+			uint8_t value = table->values[i].load(std::memory_order_relaxed);
+
+			// Invalid positions are never probed, continue the current run
+			if (value == DTM_INVALID)
+				value = i > begin ? runs[runs.size() - 2] : low;
+
+			if (i > begin && runs[runs.size() - 2] == value && runs.back() < 0xFF)
+				runs.back()++;
+			else {
+				runs.push_back(value);
+				runs.push_back(0);
+			}
+		}
+
+		// Values differing from the smallest one packed into as few bits as they need,
+		// at most a byte each so that the block is never larger than uncompressed
+		int bits = 0;
+		while ((high - low) >> bits)
+			bits++;
+
+		uint8_t base = bits < 8 ? low : 0;
+
+		packed.assign(bits == 0 ? 1 : bits < 8 ? 1 + ((end - begin) * bits + 7) / 8 : end - begin, 0);
+		packed[0] = base;
+
+		uint8_t *values = bits > 0 && bits < 8 ? packed.data() + 1 : packed.data();
+
+		for (uint64_t i = begin; bits > 0 && i < end; ++i) {
+			uint8_t value = table->values[i].load(std::memory_order_relaxed);
+			unsigned delta = (value == DTM_INVALID ? low : value) - base;
+			uint64_t pos = (i - begin) * bits;
+
+			values[pos / 8] |= static_cast<uint8_t>(delta << (pos % 8));
+
+			if (pos % 8 + bits > 8)
+				values[pos / 8 + 1] |= static_cast<uint8_t>(delta >> (8 - pos % 8));
+		}
+
+		uint64_t encoding = runs.size() <= packed.size() ? 0 : bits + 1;
+		const std::vector<uint8_t> &chosen = encoding == 0 ? runs : packed;
+
+		offsets.push_back(data.size() | encoding << blockEncodingShift);
+		data.insert(data.end(), chosen.begin(), chosen.end());
+	}
+
+	offsets.push_back(data.size());
+
+	std::ofstream stream(path, std::ios::binary);
+	if (!stream)
+		return false;
+
+	char fileName[fileNameSize] = {};
+	memcpy(fileName, name.c_str(), name.size());
+
+	stream.write(fileMagic, sizeof(fileMagic));
+	writeValue(stream, fileVersion);
+	writeValue(stream, blockEntries);
+	writeValue(stream, size);
+	writeValue(stream, blocks);
+	stream.write(fileName, sizeof(fileName));
+
+	for (uint64_t offset : offsets)
+		writeValue(stream, offset);
+
+	stream.write(reinterpret_cast<const char *>(data.data()), data.size());
+
+	return static_cast<bool>(stream);
+}
+
+} // namespace vimlock
@@ -0,0 +1,173 @@
+#pragma once
+#include "Board.h"
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace vimlock
+{
+
+/// Value of a position in a distance to mate table: zero for a draw, otherwise one more
+/// than the number of plies to mate. Odd number of plies is a win for the side to move.
+constexpr uint8_t DTM_DRAW = 0;
+
+/// Value of an index which is not a legal position.
+constexpr uint8_t DTM_INVALID = 0xFF;
+
+/// Returns true if the side to move wins, given a value which is not a draw.
+inline bool isDtmWin(uint8_t value)
+{
+	return (value - 1) & 1;
+}
+
+/// Return number of plies to mate, given a value which is not a draw.
+inline int getDtmPlies(uint8_t value)
+{
+	return value - 1;
+}
+
+/// Mapping between positions of a single material and indices of a table.
+///
+/// Pieces are ordered as white king, black king, rest of white pieces and rest of black
+/// pieces. The index is built from side to move and the square of each piece, with
+/// symmetries removed by mirroring the white king to files A-D, and without pawns also
+/// to the A1-D1-D4 triangle. Identical pieces are stored in the order of their squares.
+/// Indices which are not produced by any position are simply unused.
+class DtmIndex
+{
+public:
+	/// Parse material such as "KRPvKR", white having the pieces before 'v'.
+	/// Returns false if the name is invalid.
+	bool parse(const std::string &name);
+
+	/// Return name of the material of given position, stronger side as white.
+	static std::string getName(const Board &board);
+
+	const std::string & getName() const { return name; }
+
+	/// Return number of indices.
+	uint64_t getSize() const { return size; }
+
+	/// Return material key of the table and with colors swapped, see `Board::getMaterialKey()`.
+	uint64_t getKey() const { return key; }
+	uint64_t getFlippedKey() const { return flippedKey; }
+
+	/// Return index of given position. Returns false if the material doesn't match,
+	/// positions with colors swapped are accepted.
+	bool getIndex(const Board &board, uint64_t &ret) const;
+
+	/// Set up position of given index. Returns false if the index is unused.
+	/// The position may still be illegal, with the side not to move in check.
+	bool getBoard(uint64_t index, Board &ret) const;
+
+private:
+	/// Index of the position, with colors swapped if `flip` is set, after transforming
+	/// the squares: bit 0 mirrors files, bit 1 mirrors ranks, bit 2 swaps files and ranks.
+	uint64_t encode(const Board &board, bool flip, int transform) const;
+
+	std::string name;
+
+	/// Color and type of each piece.
+	std::vector<Color> colors;
+	std::vector<Piece> pieces;
+
+	bool hasPawns = false;
+
+	uint64_t size = 0;
+
+	uint64_t key = 0;
+	uint64_t flippedKey = 0;
+};
+
+/// Distance to mate table, memory mapped from a file written by `DtmGenerator`.
+///
+/// Values are stored in blocks, each either run length encoded as pairs of value and
+/// length or packed into the fewest bits above the smallest value, whichever is smaller.
+/// Probing decodes a single block.
+class DtmTable
+{
+public:
+	DtmTable();
+	~DtmTable();
+
+	DtmTable(const DtmTable &) = delete;
+	DtmTable & operator = (const DtmTable &) = delete;
+
+	/// Map the table from a file. Returns false if the file is missing or invalid.
+	bool load(const std::string &path);
+
+	const DtmIndex & getIndex() const { return index; }
+
+	/// Return value at given index. Unspecified if the index is not a legal position.
+	uint8_t getValue(uint64_t idx) const;
+
+	/// Probe value of a legal position. Returns false if the material doesn't match.
+	bool probe(const Board &board, uint8_t &ret) const;
+
+private:
+	DtmIndex index;
+
+	void *map = nullptr;
+	size_t mapSize = 0;
+
+	uint32_t blockEntries = 0;
+	const uint8_t *offsets = nullptr;
+	const uint8_t *data = nullptr;
+};
+
+/// Generates distance to mate tables by retrograde analysis.
+///
+/// Positions are first classified by looking at the moves: captures and promotions
+/// lead to smaller tables which are generated first, other moves are counted. Then,
+/// one ply at a time, predecessors of positions lost in `n` plies are won in `n + 1`,
+/// and predecessors whose all moves lead to positions won by the opponent are lost.
+/// Positions which are never reached this way are drawn. Each ply is processed by
+/// all the threads in parallel.
+///
+/// En passant captures are not considered, and neither is castling.
+class DtmGenerator
+{
+public:
+	/// Generate using given number of threads.
+	explicit DtmGenerator(int threads);
+	~DtmGenerator();
+
+	/// Generate table of given material and all the tables it depends on, unless
+	/// already generated. Returns false if the material is invalid or takes too long to mate.
+	bool generate(const std::string &name);
+
+	/// Return names of all generated tables.
+	std::vector<std::string> getNames() const;
+
+	/// Probe value of a legal position. Returns false if the table has not been generated.
+	bool probe(const Board &board, uint8_t &ret) const;
+
+	/// Write a generated table into a file, see `DtmTable`.
+	bool save(const std::string &name, const std::string &path) const;
+
+private:
+	struct Table
+	{
+		DtmIndex index;
+		std::unique_ptr<std::atomic<uint8_t>[]> values;
+	};
+
+	/// Return table with the material of given position, null if not generated.
+	const Table * findTable(const Board &board) const;
+
+	/// Fill values of the table. Returns false if some mate takes too many plies to store.
+	bool analyze(Table &table);
+
+	int threads;
+
+	/// Tables by material key of both colors.
+	std::map<uint64_t, Table *> keys;
+
+	std::vector<std::unique_ptr<Table>> tables;
+};
+
+} // namespace vimlock
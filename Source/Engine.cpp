@@ -1,33 +1,323 @@
 #include "Engine.h"
+#include "Attacks.h"
+#include "Bitbase.h"
+#include "Log.h"
 #include "Move.h"
 #include "Moves.h"
 
 #include <cassert>
 #include <cstddef>
+#include <cstring>
 #include <limits>
 #include <algorithm>
+#include <thread>
 
 namespace vimlock
 {
 
-// 4x4 region in center
+// Files C-F of ranks 4 and 5
 static Bitboard centerSquares = Bitboard(0x3c3c000000LL);
 
 // A and H file
 static Bitboard edges = Bitboard(0x20c0c18181818181);
 
-static Bitboard topAndBottomRanks = Bitboard::rank(RANK_8) | Bitboard::rank(RANK_1);
-
-constexpr int PAWN_VALUE   = 1000;
-constexpr int ROOK_VALUE   = 5000;
-constexpr int KNIGHT_VALUE = 3000;
-constexpr int BISHOP_VALUE = 3000;
-constexpr int QUEEN_VALUE  = 9000;
+// Evaluation terms as midgame and endgame scores, in centipawns.
+// King safety and center control matter less once pieces get traded.
+constexpr Score checkedScore         = Score(-50, -20);
+constexpr Score mobilityScore        = Score(1, 1);
+constexpr Score threatScore          = Score(10, 10);
+constexpr Score centerControlScore   = Score(5, 0);
+constexpr Score freePassedScore      = Score(0, 15);
+constexpr Score kingGuardedScore     = Score(10, 0);
+constexpr Score kingSingleGuardScore = Score(5, 0);
 
 /// Maximum number of moves a player can choose from during a single turn.
 /// Theoretical maximum is 218 based on web search.
 constexpr int maxMoves = 256;
 
+/// Maximum length of a searched path, including extensions.
+constexpr int maxPly = 128;
+
+/// Evaluation of checkmating the opponent on the root position, reduced by the distance to mate.
+constexpr int MATE_EVAL = 1000000000;
+
+/// Evaluation of a position won according to the tablebases, reduced by the distance
+/// from the root so that shorter paths into a won endgame are preferred.
+constexpr int TABLEBASE_WIN_EVAL = MATE_EVAL / 2;
+
+/// Evaluation reported for a tablebase win on the root, as centipawns beyond any
+/// evaluation of material but clearly not a checkmate.
+constexpr int TABLEBASE_WIN_REPORT = 20000;
+
+/// Bounds for alpha-beta window, beyond any reachable evaluation.
+constexpr int INFINITE_EVAL = std::numeric_limits<int>::max();
+
+/// Singular extensions are tried only if there's at least this many plies left to search.
+constexpr int singularMinDepth = 4;
+
+/// How much worse than the remembered best move other moves must be per remaining ply,
+/// for the best move to be considered singular.
+constexpr int singularMargin = 20;
+
+/// Results of positions searched at least this many plies deep are kept in the analysis file.
+constexpr int analysisMinDepth = 4;
+
+/// Number of entries of a new analysis file.
+constexpr size_t analysisEntries = 1 << 20;
+
+/// Late quiet moves are pruned only this many plies from the horizon.
+constexpr int lateMoveMaxDepth = 3;
+
+/// Quiet moves with history score below this per remaining ply are pruned near the horizon.
+constexpr int historyPruneMargin = -32;
+
+/// Quiet moves are pruned by their history only this many plies from the horizon.
+constexpr int historyPruneMaxDepth = 2;
+
+/// Static evaluation of a node in check, which isn't computed.
+constexpr int NO_EVAL = std::numeric_limits<int>::min();
+
+/// History scores are halved when any of them grows past this, so that recent
+/// cutoffs weigh more than old ones.
+constexpr int maxHistoryScore = 1 << 20;
+
+static bool isMateEval(int eval)
+{
+	return eval >= MATE_EVAL - maxPly || eval <= -MATE_EVAL + maxPly;
+}
+
+/// Number of moves until checkmate for evaluation of the root, negative if the side to
+/// move gets checkmated. Zero if the evaluation is not a checkmate.
+static int getMateMoves(int eval)
+{
+	if (eval >= MATE_EVAL - maxPly)
+		return (MATE_EVAL - eval + 1) / 2;
+	else if (eval <= -MATE_EVAL + maxPly)
+		return -(MATE_EVAL + eval) / 2;
+
+	return 0;
+}
+
+/// Evaluation of the root as reported in `SearchInfo`, with the distance of a tablebase
+/// win kept but the value bounded to centipawns.
+static int getReportedEval(int eval)
+{
+	if (isMateEval(eval))
+		return eval;
+	else if (eval >= TABLEBASE_WIN_EVAL - maxPly)
+		return TABLEBASE_WIN_REPORT - (TABLEBASE_WIN_EVAL - eval);
+	else if (eval <= -TABLEBASE_WIN_EVAL + maxPly)
+		return -TABLEBASE_WIN_REPORT + (TABLEBASE_WIN_EVAL + eval);
+
+	return eval;
+}
+
+/// Evaluation of a tablebase result from the perspective of the side to move.
+/// Cursed wins and blessed losses are draws, but slightly better or worse than one.
+static int getTablebaseEval(Wdl wdl, int depth)
+{
+	switch (wdl) {
+		case WDL_WIN:          return TABLEBASE_WIN_EVAL - depth;
+		case WDL_CURSED_WIN:   return 1;
+		case WDL_BLESSED_LOSS: return -1;
+		case WDL_LOSS:         return -TABLEBASE_WIN_EVAL + depth;
+		default:               return 0;
+	}
+}
+
+/// Convert evaluation relative to the root into a value stored in the transposition table.
+/// Stored values are from the perspective of the side to move and mate distances are
+/// counted from the node instead of the root.
+static int toTableEval(int eval, int depth, bool maximize)
+{
+	if (eval >= MATE_EVAL - maxPly)
+		eval += depth;
+	else if (eval <= -MATE_EVAL + maxPly)
+		eval -= depth;
+
+	return maximize ? eval : -eval;
+}
+
+/// Inverse of `toTableEval()`.
+static int fromTableEval(int eval, int depth, bool maximize)
+{
+	if (!maximize)
+		eval = -eval;
+
+	if (eval >= MATE_EVAL - maxPly)
+		eval -= depth;
+	else if (eval <= -MATE_EVAL + maxPly)
+		eval += depth;
+
+	return eval;
+}
+
+/// Add pawn moves to each of `targets`, source square being `offset` squares behind the target.
+template <Color C>
+static int addPawnMoves(MoveCandidate *ret, int count, Bitboard targets, int offset, MoveOrder order)
+{
+	constexpr Bitboard promotionRank = Bitboard::rank(PawnTraits<C>::promotionRank);
+
+	while (targets) {
+		Square dst = targets.popFirstSquare();
+		Square src = Square(static_cast<uint64_t>(static_cast<int>(dst.getIndex()) - offset));
+
+		if (Bitboard(dst) & promotionRank) {
+			// Add possible promotions
+			ret[count++] = MoveCandidate({src, dst, ROOK}, MOVE_PROMOTE);
+			ret[count++] = MoveCandidate({src, dst, KNIGHT}, MOVE_PROMOTE);
+			ret[count++] = MoveCandidate({src, dst, BISHOP}, MOVE_PROMOTE);
+			ret[count++] = MoveCandidate({src, dst, QUEEN}, MOVE_PROMOTE);
+		}
+		else {
+			ret[count++] = MoveCandidate({src, dst}, order);
+		}
+	}
+
+	return count;
+}
+
+/// Generate pseudo-legal moves for the side to move, which must be `C`.
+/// Returns number of moves stored in `ret`.
+template <Color C>
+static int generateMoves(const Node *node, MoveCandidate *ret)
+{
+	constexpr Bitboard enpassantRank = Bitboard::rank(PawnTraits<C>::enpassantRank);
+	constexpr int forward = PawnTraits<C>::forward;
+
+	Bitboard allPieces = node->allPieces;
+	Bitboard ownPieces = node->ownPieces;
+	Bitboard oppPieces = node->oppPieces;
+	Bitboard enpassant = node->board.getEnPassantSquares() & enpassantRank;
+
+	int count = 0;
+
+	// All pawns at once
+	Bitboard pawns = ownPieces & node->board.getPieces(PAWN);
+	Bitboard targets = oppPieces | enpassant;
+
+	count = addPawnMoves<C>(ret, count, getPawnAttacksWest<C>(pawns) & targets, forward - 1, MOVE_CAPTURE);
+	count = addPawnMoves<C>(ret, count, getPawnAttacksEast<C>(pawns) & targets, forward + 1, MOVE_CAPTURE);
+	count = addPawnMoves<C>(ret, count, getPawnPushes<C>(pawns, allPieces), forward, MOVE_REGULAR);
+	count = addPawnMoves<C>(ret, count, getPawnDoublePushes<C>(pawns, allPieces), forward * 2, MOVE_REGULAR);
+
+	// Rest of the pieces one by one
+	Bitboard pieces = ownPieces & ~pawns;
+
+	while (pieces) {
+
+		assert(count < maxMoves - 32 && "more moves than theoretically possible?");
+
+		Square src = pieces.popFirstSquare();
+		SquareState square = node->board.getSquare(src);
+
+		Bitboard moves = getAvailableMoves<C>(square.getPiece(), src, allPieces, ownPieces);
+
+		while (moves) {
+			Square dst = moves.popFirstSquare();
+
+			MoveOrder order = MOVE_REGULAR;
+			if (Bitboard(dst) & oppPieces)
+				order = MOVE_CAPTURE;
+
+			ret[count++] = MoveCandidate({src, dst}, order);
+		}
+
+		if (square.getPiece() == KING) {
+			// TODO: consider castling
+		}
+	}
+
+	return count;
+}
+
+/// Number of legal moves searched before the remaining quiet moves are pruned.
+/// Positions getting better for the side to move are worth searching wider.
+static int getLateMoveCount(int remaining, bool improving)
+{
+	return improving ? 3 + remaining * remaining : (3 + remaining * remaining) / 2;
+}
+
+/// Number of threads used for clearing large tables.
+static int getClearThreads()
+{
+	return std::max<int>(std::thread::hardware_concurrency(), 1);
+}
+
+/// Returns true if `move` neither captures nor promotes.
+static bool isQuiet(const Node *node, Move move)
+{
+	if (move.getPromotion() != PAWN || (Bitboard(move.getDestination()) & node->oppPieces))
+		return false;
+
+	// En passant captures land on an empty square
+	return node->board.getSquare(move.getSource()).getPiece() != PAWN
+		|| move.getSource().getFile() == move.getDestination().getFile();
+}
+
+/// Halve all history scores, keeping their order.
+static void halveScores(int (&scores)[2][64][64])
+{
+	for (auto &color : scores) {
+		for (auto &src : color) {
+			for (int &it : src)
+				it /= 2;
+		}
+	}
+}
+
+/// Returns true if `move` doesn't leave own king in check.
+/// Uses check and pin information of the position before the move, so that only
+/// king moves and en passant need to look at the resulting position.
+static bool isLegal(Node *node, Move move)
+{
+	const Board &board = node->board;
+
+	Bitboard ownKing = board.getPieces(board.getCurrent(), KING);
+	if (!ownKing)
+		return true;
+
+	Square king = ownKing.findFirstSquare();
+	Square src = move.getSource();
+	Square dst = move.getDestination();
+
+	// Sliders keep attacking through the square the king moves away from
+	if (src == king) {
+		Bitboard allPieces = node->allPieces & ~Bitboard(src);
+		return !getAttackers(board, dst, allPieces, node->oppPieces & ~Bitboard(dst));
+	}
+
+	// En passant removes two pieces from the rank, check the resulting position
+	if (board.getSquare(src).getPiece() == PAWN
+			&& src.getFile() != dst.getFile()
+			&& !board.getSquare(dst).isOccupied()) {
+		Board next = board;
+		next.movePiece(src, dst, move.getPromotion());
+
+		Bitboard allPieces = next.getPieces();
+		return !getAttackers(next, king, allPieces, allPieces & ~next.getPieces(board.getCurrent()));
+	}
+
+	Bitboard checkers = node->inCheck ? node->attacks.getCheckers(board) : Bitboard();
+
+	if (checkers) {
+		// Only the king can escape a double check
+		if (checkers.count() > 1)
+			return false;
+
+		// Capture the checker or block it
+		Square checker = checkers.findFirstSquare();
+		if (!(Bitboard(dst) & (checkers | getBetween(king, checker))))
+			return false;
+	}
+
+	// Pinned pieces may move only along the pin
+	if (node->attacks.getPinned(board) & Bitboard(src))
+		return bool(getLine(king, src) & Bitboard(dst));
+
+	return true;
+}
+
 Move Node::getMove() const
 {
 	return Move(src, dst, promote);
@@ -44,14 +334,30 @@ MoveList Node::getMoves() const
 }
 
 Engine::Engine(int maxDepth_):
-	maxDepth(maxDepth_)
+	maxDepth(maxDepth_),
+	maxExtensions(maxDepth_ / 2)
 {
+	pathKeys.resize(maxPly + 1);
+	pathEvals.resize(maxPly + 1, NO_EVAL);
+	killers.resize(maxPly + 1);
+	std::memset(quietHistory, 0, sizeof(quietHistory));
+
 	board.setStandardPosition();
+
+	// Generate once on startup instead of during the first search reaching an endgame
+	initBitbases();
 }
 
 void Engine::setPosition(const Board &board_)
 {
 	board = board_;
+	history.clear();
+}
+
+void Engine::setPosition(const Board &board_, const std::vector<uint64_t> &history_)
+{
+	board = board_;
+	history = history_;
 }
 
 Board Engine::getPosition() const
@@ -59,6 +365,73 @@ Board Engine::getPosition() const
 	return board;
 }
 
+void Engine::newGame()
+{
+	// Other processes may still be using a shared table
+	if (!table.isShared())
+		table.clear(getClearThreads());
+
+	std::memset(quietHistory, 0, sizeof(quietHistory));
+	std::fill(killers.begin(), killers.end(), std::array<Move, 2>());
+	searchedPlies = 0;
+}
+
+void Engine::prepareSearch()
+{
+	table.newSearch();
+
+	// Older cutoffs are less likely to matter in the new position
+	halveScores(quietHistory);
+
+	// Killers are indexed by the distance from the root, which moved forward by the
+	// plies played since the previous search
+	size_t plies = history.size();
+
+	if (plies >= searchedPlies && plies - searchedPlies < killers.size()) {
+		size_t shift = plies - searchedPlies;
+		std::move(killers.begin() + shift, killers.end(), killers.begin());
+		std::fill(killers.end() - shift, killers.end(), std::array<Move, 2>());
+	}
+	else {
+		std::fill(killers.begin(), killers.end(), std::array<Move, 2>());
+	}
+
+	searchedPlies = plies;
+}
+
+void Engine::addCutoff(const Node *node, Move move, const Move *tried, int triedCount)
+{
+	if (node->depth < static_cast<int>(killers.size())) {
+		std::array<Move, 2> &slots = killers[node->depth];
+
+		if (slots[0] != move) {
+			slots[1] = slots[0];
+			slots[0] = move;
+		}
+	}
+
+	// Cutoffs far from the horizon save more work
+	int remaining = node->horizon - node->depth;
+	int bonus = remaining * remaining;
+
+	auto &scores = quietHistory[colorIndex(node->board.getCurrent())];
+	bool overflow = false;
+
+	int &score = scores[move.getSource().getIndex()][move.getDestination().getIndex()];
+	score += bonus;
+	overflow |= score > maxHistoryScore;
+
+	// Quiet moves searched before it failed to cause a cutoff
+	for (int i = 0; i < triedCount; ++i) {
+		int &it = scores[tried[i].getSource().getIndex()][tried[i].getDestination().getIndex()];
+		it -= bonus;
+		overflow |= it < -maxHistoryScore;
+	}
+
+	if (overflow)
+		halveScores(quietHistory);
+}
+
 void Engine::start()
 {
 	// Nothing to do now as we're still single threaded
@@ -66,17 +439,118 @@ void Engine::start()
 
 bool Engine::poll(Evaluation &ret)
 {
-	Node *root = allocNode();
-	root->depth = 0;
-	root->board = board;
-	root->allPieces = root->board.getPieces();
-	root->ownPieces = root->board.getPieces(root->board.getCurrent());
-	root->oppPieces = root->board.getPieces(flipColor(root->board.getCurrent()));
+	// Book moves are known to be good, no need to search
+	Move bookMove;
+	if (book.probe(board, bookMove)) {
+		ret.best = bookMove;
+		ret.eval = 0;
+		ret.total = 0;
+		ret.continuation.clear();
+		ret.continuation.push_back(bookMove);
+		return true;
+	}
+
+	// Analysed this deep before? The stored result doesn't know about the current game,
+	// so it's not used if the move repeats a position played before.
+	TableEntry entry;
+	if (analysis
+			&& analysis->probe(board.getKey(), entry)
+			&& entry.depth >= maxDepth
+			&& entry.bound == BOUND_EXACT) {
+		Move move = TranspositionTable::unpackMove(entry.move);
+
+		Node *child = allocNode();
+		child->depth = 1;
+		child->board = board;
+
+		bool playable = isLegalMove(board, move)
+			&& child->board.applyMoves({move})
+			&& !isRepetition(child, child->board.getKey());
+
+		freeNode(child);
+
+		if (playable) {
+			ret.best = move;
+			ret.eval = fromTableEval(entry.eval, 0, true);
+			ret.total = 0;
+			ret.continuation.clear();
+			ret.continuation.push_back(move);
+
+			if (iterationHandler) {
+				SearchInfo info;
+				info.depth = entry.depth;
+				info.selDepth = entry.depth;
+				info.eval = getReportedEval(ret.eval);
+				info.mate = getMateMoves(ret.eval);
+				info.nodes = 0;
+				info.tbHits = 0;
+				info.time = 0;
+				info.nps = 0;
+				info.hashfull = table.getHashfull();
+				info.continuation = ret.continuation;
+
+				iterationHandler(info);
+			}
+
+			return true;
+		}
+	}
 
 	total = 0;
+	tbHits = 0;
+	selDepth = 0;
+	searchStart = std::chrono::steady_clock::now();
+
+	prepareSearch();
+
+	Node *root = nullptr;
+
+	// Iterative deepening, shallower iterations leave best moves into the table
+	// which makes deeper iterations faster and enables singular extensions.
+	for (int depth = 1; depth <= maxDepth; ++depth) {
+		if (root)
+			freeNode(root);
+
+		root = allocNode();
+		root->depth = 0;
+		root->horizon = depth;
+		root->board = board;
+		root->allPieces = root->board.getPieces();
+		root->ownPieces = root->board.getPieces(root->board.getCurrent());
+		root->oppPieces = root->board.getPieces(flipColor(root->board.getCurrent()));
+
+		if (network) {
+			network->refresh(root->board, WHITE, root->accumulator);
+			network->refresh(root->board, BLACK, root->accumulator);
+		}
+
+		Bitboard ownKing = root->board.getPieces(root->board.getCurrent(), KING);
+		root->inCheck = ownKing && getAttackers(root->board, ownKing.findFirstSquare(), root->allPieces, root->oppPieces);
 
-	// traverse(root);
-	traverse(root, std::numeric_limits<int>::min(), std::numeric_limits<int>::max());
+		search<NODE_ROOT>(root, -INFINITE_EVAL, INFINITE_EVAL);
+
+		// Checkmate or stalemate, searching deeper won't change anything.
+		if (root->movesCount == 0)
+			break;
+
+		if (iterationHandler) {
+			SearchInfo info;
+			info.depth = depth;
+			info.selDepth = std::max(selDepth, depth);
+			info.eval = getReportedEval(root->eval);
+			info.mate = getMateMoves(root->eval);
+			info.nodes = total;
+			info.tbHits = tbHits;
+
+			uint64_t micros = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - searchStart).count();
+			info.time = micros / 1000;
+			info.nps = micros > 0 ? total * 1000000 / micros : 0;
+			info.hashfull = table.getHashfull();
+			info.continuation = root->getMoves();
+
+			iterationHandler(info);
+		}
+	}
 
 	if (root->movesCount == 0) {
 		freeNode(root);
@@ -91,6 +565,21 @@ bool Engine::poll(Evaluation &ret)
 		ret.continuation.push_back(root->moves[i]);
 	}
 
+	// Search sees all tablebase wins as equal, pick the one making progress
+	Wdl wdl;
+	Move best = ret.best;
+
+	if (tablebases.canProbe(board) && tablebases.probeRoot(board, best, wdl)) {
+		if (best != ret.best) {
+			ret.best = best;
+			ret.continuation.clear();
+			ret.continuation.push_back(best);
+		}
+
+		if (!isMateEval(ret.eval))
+			ret.eval = getTablebaseEval(wdl, 0);
+	}
+
 	freeNode(root);
 
 	return true;
@@ -101,87 +590,305 @@ void Engine::stop()
 	// Nothing to do now as we're still single threaded
 }
 
-void Engine::traverse(Node *node, int alpha, int beta)
+void Engine::setIterationHandler(std::function<void (const SearchInfo &)> handler)
 {
-	if (node->depth >= maxDepth) {
+	iterationHandler = handler;
+}
+
+void Engine::setCurrentMoveHandler(std::function<void (Move, int)> handler, std::chrono::milliseconds delay)
+{
+	currentMoveHandler = handler;
+	currentMoveDelay = delay;
+}
+
+bool Engine::setEvalFile(const std::string &path)
+{
+	if (path.empty()) {
+		network.reset();
+	}
+	else {
+		std::unique_ptr<Network> tmp(new Network());
+		if (!tmp->load(path))
+			return false;
+
+		network = std::move(tmp);
+	}
+
+	// Cached evaluations came from the previous evaluator
+	evalCache.clear();
+
+	return true;
+}
+
+int Engine::setSyzygyPath(const std::string &path)
+{
+	return tablebases.setPath(path);
+}
+
+bool Engine::setHashSize(size_t megabytes)
+{
+	// Size of a shared table is decided by whoever creates it
+	if (table.isShared()) {
+		logError("Can't resize a shared hash");
+		return false;
+	}
+
+	return table.resizeMegabytes(megabytes, getClearThreads());
+}
+
+bool Engine::setSharedHash(const std::string &name)
+{
+	if (name.empty())
+		return !table.isShared() || table.resize(table.getSize(), getClearThreads());
+
+	return table.attach(name, table.getSize());
+}
+
+bool Engine::setAnalysisFile(const std::string &path)
+{
+	if (path.empty()) {
+		analysis.reset();
+		return true;
+	}
+
+	std::unique_ptr<TranspositionTable> tmp(new TranspositionTable(1));
+	if (!tmp->openFile(path, analysisEntries)) {
+		analysis.reset();
+		return false;
+	}
+
+	analysis = std::move(tmp);
+	return true;
+}
+
+int Engine::getHashfull() const
+{
+	return table.getHashfull();
+}
+
+void Engine::setPruning(bool enabled)
+{
+	pruning = enabled;
+}
+
+bool Engine::setBookFile(const std::string &path)
+{
+	return book.load(path);
+}
+
+bool Engine::isRepetition(const Node *node, uint64_t key) const
+{
+	// Positions before the last capture or pawn move can't repeat, and the same side
+	// must be to move
+	int reversible = node->board.getHalfmoveClock();
+
+	for (int plies = 2; plies <= reversible; plies += 2) {
+		int depth = node->depth - plies;
+
+		if (depth >= static_cast<int>(pathKeys.size()))
+			continue;
+
+		if (depth >= 0) {
+			if (pathKeys[depth] == key)
+				return true;
+		}
+		else {
+			int idx = static_cast<int>(history.size()) + depth;
+			if (idx < 0)
+				break;
+
+			if (history[idx] == key)
+				return true;
+		}
+	}
+
+	return false;
+}
+
+template <NodeType type>
+void Engine::search(Node *node, int alpha, int beta)
+{
+	if (node->depth >= node->horizon) {
 		evaluate(node);
 		return;
 	}
 
-	Bitboard allPieces = node->allPieces;
-	Bitboard ownPieces = node->ownPieces;
-	Bitboard oppPieces = node->oppPieces;
+	if (node->inCheck)
+		traverse<type, true>(node, alpha, beta);
+	else
+		traverse<type, false>(node, alpha, beta);
+}
 
-	// Generate possible moves from current position
-	
-	int possibleMovesCount = 0;
-	MoveCandidate possibleMoves[256];
-	
-	for (uint64_t i = 0; i < 64; ++i) {
+template <NodeType type, bool inCheck>
+void Engine::traverse(Node *node, int alpha, int beta)
+{
+	constexpr bool pvNode = type != NODE_NONPV;
 
-		assert(possibleMovesCount < maxMoves && "more moves than theoretically possible?");
+	bool maximize = node->board.getCurrent() == board.getCurrent();
+	bool excluding = node->excluded != Move();
+	int remaining = node->horizon - node->depth;
+	int alphaOrig = alpha;
+	int betaOrig = beta;
 
-		if (!(ownPieces & Bitboard(Square(i))))
-			continue;
+	uint64_t key = node->board.getKey();
 
-		SquareState square = node->board.getSquare(Square(i));
+	// Repeating a position is a draw, as the side which is worse off could keep repeating it
+	if (type != NODE_ROOT && isRepetition(node, key)) {
+		node->eval = 0;
+		return;
+	}
 
-		Bitboard moves = getAvailableMoves(
-			square.getColor(), square.getPiece(), Square(i), allPieces, ownPieces);
+	if (node->depth < static_cast<int>(pathKeys.size()))
+		pathKeys[node->depth] = key;
 
-		// Create a subnode for each possible move
-		for (uint64_t k = 0; k < 64; ++k) {
+	TableEntry entry;
+	bool hasEntry = !excluding && table.probe(key, entry);
 
-			Bitboard dstBitboard = Bitboard(Square(k));
+	// Deep results of earlier runs, unless this run already searched deeper
+	if (analysis && !excluding && remaining >= analysisMinDepth) {
+		TableEntry stored;
 
-			// Not a valid move?
-			if (!(moves & dstBitboard))
-				continue;
+		if (analysis->probe(key, stored) && (!hasEntry || stored.depth > entry.depth)) {
+			entry = stored;
+			hasEntry = true;
+		}
+	}
+	Move tableMove = hasEntry ? TranspositionTable::unpackMove(entry.move) : Move();
+	bool hasTableMove = false;
+
+	// Good enough result from an earlier search? Not trusted on PV nodes
+	// as the continuation would get cut short.
+	if (!pvNode && hasEntry && entry.depth >= remaining) {
+		int eval = fromTableEval(entry.eval, node->depth, maximize);
+
+		// Bounds are stored from perspective of the side to move
+		int bound = entry.bound;
+		if (!maximize && bound != BOUND_EXACT)
+			bound ^= BOUND_EXACT;
+
+		if (bound == BOUND_EXACT
+				|| ((bound & BOUND_LOWER) && eval >= beta)
+				|| ((bound & BOUND_UPPER) && eval <= alpha)) {
+			node->eval = eval;
+			return;
+		}
+	}
 
-			Square srcSquare = Square(i);
-			Square dstSquare = Square(k);
+	// Exact result of the endgame is known, no need to search any deeper
+	if (type != NODE_ROOT && !excluding && tablebases.canProbe(node->board)) {
+		Wdl wdl;
 
-			if (square.getPiece() == PAWN && (dstBitboard & (topAndBottomRanks))) {
-				// Add possible promotions
-				
-				possibleMoves[possibleMovesCount++] = MoveCandidate({srcSquare, dstSquare, ROOK}, MOVE_PROMOTE);
-				possibleMoves[possibleMovesCount++] = MoveCandidate({srcSquare, dstSquare, KNIGHT}, MOVE_PROMOTE);
-				possibleMoves[possibleMovesCount++] = MoveCandidate({srcSquare, dstSquare, BISHOP}, MOVE_PROMOTE);
-				possibleMoves[possibleMovesCount++] = MoveCandidate({srcSquare, dstSquare, QUEEN}, MOVE_PROMOTE);
-			}
-			else {
-				// Regular move
+		if (tablebases.probeWdl(node->board, wdl)) {
+			tbHits++;
+			int eval = getTablebaseEval(wdl, node->depth);
+			node->eval = maximize ? eval : -eval;
 
-				MoveOrder order = MOVE_REGULAR;
-				if (dstBitboard & oppPieces)
-					order = MOVE_CAPTURE;
+			table.store(key, Move(), toTableEval(node->eval, node->depth, maximize), remaining, BOUND_EXACT);
+			return;
+		}
+	}
 
-				possibleMoves[possibleMovesCount++] = MoveCandidate({srcSquare, dstSquare}, order);
+	// Generate possible moves from current position
+	MoveCandidate possibleMoves[maxMoves];
+	int possibleMovesCount = node->board.getCurrent() == WHITE
+		? generateMoves<WHITE>(node, possibleMoves)
+		: generateMoves<BLACK>(node, possibleMoves);
 
-				if (square.getPiece() == KING) {
-					// TODO: consider castling
-				}
-			}
+	const std::array<Move, 2> noKillers;
+	const std::array<Move, 2> &nodeKillers = node->depth < static_cast<int>(killers.size()) ? killers[node->depth] : noKillers;
+	const auto &nodeHistory = quietHistory[colorIndex(node->board.getCurrent())];
+
+	for (int i = 0; i < possibleMovesCount; ++i) {
+		MoveCandidate &candidate = possibleMoves[i];
+
+		if (excluding && candidate.move == node->excluded) {
+			possibleMoves[i] = possibleMoves[--possibleMovesCount];
+			--i;
+		}
+		else if (hasEntry && candidate.move == tableMove) {
+			// Best move from previous search is most likely still the best.
+			candidate.order = MOVE_TABLE;
+			hasTableMove = true;
+		}
+		else if (candidate.order == MOVE_REGULAR) {
+			if (candidate.move == nodeKillers[0] || candidate.move == nodeKillers[1])
+				candidate.order = MOVE_KILLER;
+			else
+				candidate.score = nodeHistory[candidate.move.getSource().getIndex()][candidate.move.getDestination().getIndex()];
 		}
 	}
 
 	// TODO: sorting bucket based approach would be faster
 	std::sort(possibleMoves, possibleMoves + possibleMovesCount, [](const MoveCandidate &a, const MoveCandidate &b) {
-			return static_cast<int>(a.order) < static_cast<int>(b.order);
+			if (a.order != b.order)
+				return static_cast<int>(a.order) < static_cast<int>(b.order);
+
+			return a.score > b.score;
 	});
 
-	bool maximize = node->board.getCurrent() == board.getCurrent();
-	node->eval = maximize ? std::numeric_limits<int>::min() : std::numeric_limits<int>::max();
+	// Is the remembered best move much better than the alternatives? If so, it's
+	// worth searching deeper.
+	bool singular = false;
+	if (type != NODE_ROOT
+			&& hasTableMove
+			&& remaining >= singularMinDepth
+			&& node->extensions < maxExtensions
+			&& entry.depth >= remaining - 3
+			&& (entry.bound & BOUND_LOWER)
+			&& !isMateEval(entry.eval)) {
+		singular = isSingular(node, tableMove, fromTableEval(entry.eval, node->depth, maximize));
+	}
+
+	// Is the position better for the side to move than on its previous turn? Static
+	// evaluation is from the side to move's perspective, like on the earlier turn.
+	// Needed only near the horizon, where moves get pruned.
+	int staticEval = NO_EVAL;
+	if (!inCheck && remaining <= lateMoveMaxDepth + 2) {
+		staticEval = getStaticEval(node);
+		if (!maximize)
+			staticEval = -staticEval;
+	}
+
+	if (node->depth < static_cast<int>(pathEvals.size()))
+		pathEvals[node->depth] = staticEval;
 
-	Move bestMoves[32];
+	bool improving = staticEval != NO_EVAL
+		&& node->depth >= 2
+		&& node->depth - 2 < static_cast<int>(pathEvals.size())
+		&& pathEvals[node->depth - 2] != NO_EVAL
+		&& staticEval > pathEvals[node->depth - 2];
+
+	// Prune late quiet moves near the horizon, zero window nodes only as moves of
+	// the principal variation must all be searched
+	bool canPrune = pruning && type == NODE_NONPV && !inCheck && remaining <= std::max(lateMoveMaxDepth, historyPruneMaxDepth);
+	int lateMoveCount = getLateMoveCount(remaining, improving);
+
+	node->eval = maximize ? -INFINITE_EVAL : INFINITE_EVAL;
+
+	Move bestMove;
+	Move bestMoves[maxPly];
 	int bestMovesCount = 0;
 
 	int legalMoves = 0;
 
+	// Quiet moves searched without a cutoff, penalized if a later move causes one
+	Move quietMoves[maxMoves];
+	int quietMovesCount = 0;
+
 	for (int i = 0; i < possibleMovesCount; ++i) {
 
 		Move move = possibleMoves[i].move;
 
+		// Don't move into check
+		if (!isLegal(node, move))
+			continue;
+
+		legalMoves++;
+
+		// Clock is checked only on the root, where it's cheap compared to the search
+		if (type == NODE_ROOT && currentMoveHandler && std::chrono::steady_clock::now() - searchStart >= currentMoveDelay)
+			currentMoveHandler(move, legalMoves);
+
 		Node *child = allocNode();
 		child->src = move.getSource();
 		child->dst = move.getDestination();
@@ -189,9 +896,11 @@ void Engine::traverse(Node *node, int alpha, int beta)
 		child->promote = move.getPromotion();
 		child->depth = node->depth + 1;
 
-		std::copy(node->moves, node->moves + node->movesCount, child->moves);
-		child->movesCount = node->movesCount;
-		child->moves[child->movesCount++] = child->getMove();
+		if (pvNode) {
+			std::copy(node->moves, node->moves + node->movesCount, child->moves);
+			child->movesCount = node->movesCount;
+			child->moves[child->movesCount++] = child->getMove();
+		}
 
 		if (!child->board.movePiece(child->src, child->dst, child->promote)) {
 			assert(false && "invalid move when traversing");
@@ -200,16 +909,37 @@ void Engine::traverse(Node *node, int alpha, int beta)
 		Bitboard allPieces = child->board.getPieces();
 		Bitboard ownPieces = child->board.getPieces(child->board.getCurrent());
 		Bitboard oppPieces = allPieces & ~ownPieces;
-		Bitboard ownKing = child->board.getPieces(child->board.getCurrent(), KING);
-		Bitboard oppAttacks = getAvailableCaptures(child->board, allPieces, oppPieces);
+		Bitboard oppKing = child->board.getPieces(flipColor(child->board.getCurrent()), KING);
+		child->inCheck = oppKing && getAttackers(child->board, oppKing.findFirstSquare(), allPieces, ownPieces);
 
-		// Don't move into check
-		if (oppAttacks & ownKing) {
-			freeNode(child);
-			continue;
+		bool quiet = isQuiet(node, move);
+
+		// Checks may be forcing even if quiet. Pruning starts only once a move has been
+		// searched and isn't getting mated, as one of the pruned moves might be the defence.
+		if (canPrune && quiet && !child->inCheck && legalMoves > 1 && !isMateEval(node->eval)) {
+			int history = nodeHistory[move.getSource().getIndex()][move.getDestination().getIndex()];
+
+			if ((remaining <= lateMoveMaxDepth && legalMoves > lateMoveCount)
+					|| (remaining <= historyPruneMaxDepth && history < historyPruneMargin * remaining)) {
+				freeNode(child);
+				continue;
+			}
 		}
 
-		legalMoves++;
+		if (network)
+			network->update(node->board, child->board, node->accumulator, child->accumulator);
+
+		// Extend forcing moves, as long as the path has extensions left.
+		int extension = 0;
+		if (node->extensions < maxExtensions && child->depth < maxPly - 1) {
+			if (child->inCheck)
+				extension = 1;
+			else if (singular && move == tableMove)
+				extension = 1;
+		}
+
+		child->horizon = node->horizon + extension;
+		child->extensions = node->extensions + extension;
 
 		// Flipped around as the turn changed
 		child->allPieces = allPieces;
@@ -218,75 +948,180 @@ void Engine::traverse(Node *node, int alpha, int beta)
 
 		child->board.flipCurrent();
 
-		traverse(child, alpha, beta);
-
-		if (maximize) {
-			if (child->eval > node->eval) {
-
-				node->eval = child->eval;
-
-				std::copy(child->moves, child->moves + child->movesCount, bestMoves);
-				bestMovesCount = child->movesCount;
+		if (!pvNode || legalMoves == 1) {
+			search<pvNode ? NODE_PV : NODE_NONPV>(child, alpha, beta);
+		}
+		else {
+			// Try to prove with a zero window that the move is no better than the current best,
+			// search again with the full window if that fails.
+			bool leaf = child->depth >= child->horizon;
+
+			if (maximize) {
+				search<NODE_NONPV>(child, alpha, alpha + 1);
+				if (!leaf && child->eval > alpha && child->eval < beta)
+					search<NODE_PV>(child, alpha, beta);
 			}
-			if (child->eval > alpha) {
-				alpha = child->eval;
+			else {
+				search<NODE_NONPV>(child, beta - 1, beta);
+				if (!leaf && child->eval < beta && child->eval > alpha)
+					search<NODE_PV>(child, alpha, beta);
 			}
 		}
-		else {
-			if (child->eval < node->eval) {
-				node->eval = child->eval;
 
+		bool improved = maximize ? child->eval > node->eval : child->eval < node->eval;
+
+		if (improved) {
+			node->eval = child->eval;
+			bestMove = move;
+
+			if (pvNode) {
 				std::copy(child->moves, child->moves + child->movesCount, bestMoves);
 				bestMovesCount = child->movesCount;
 			}
-			if (child->eval < beta) {
-				beta = child->eval;
-			}
 		}
 
+		if (maximize && child->eval > alpha)
+			alpha = child->eval;
+		else if (!maximize && child->eval < beta)
+			beta = child->eval;
+
 		freeNode(child);
 
 		// Prune remaining branches
 		if (alpha >= beta) {
+			if (quiet)
+				addCutoff(node, move, quietMoves, quietMovesCount);
+
 			break;
 		}
+
+		if (quiet)
+			quietMoves[quietMovesCount++] = move;
 	}
 
 	if (legalMoves == 0) {
-		Bitboard attackedSquares = getAvailableCaptures(node->board, node->allPieces, node->oppPieces);
-		Bitboard ownKing = node->board.getPieces(node->board.getCurrent(), KING);
+		// Only the excluded move was legal, which makes it singular
+		if (excluding) {
+			return;
+		}
 
 		// Stalemate?
-		if (!(ownKing & attackedSquares)) {
+		if (!inCheck) {
 			node->eval = 0;
 			return;
 		}
-		else if (board.getCurrent() == node->board.getCurrent()) {
+		else if (maximize) {
 			// Opponent checkmated us, try to struggle until the end
-			node->eval = std::numeric_limits<int>::min() + node->depth;
+			node->eval = -MATE_EVAL + node->depth;
 		}
 		else {
 			// Opponent got checkmated, prefer shorter checkmates
-			node->eval = std::numeric_limits<int>::max() - node->depth;
+			node->eval = MATE_EVAL - node->depth;
 		}
 	}
 	else {
-		std::copy(bestMoves, bestMoves + bestMovesCount, node->moves);
-		node->movesCount = bestMovesCount;
+		if (pvNode) {
+			std::copy(bestMoves, bestMoves + bestMovesCount, node->moves);
+			node->movesCount = bestMovesCount;
+		}
+
+		if (!excluding) {
+			// Bound from the perspective of the side to move
+			Bound bound = BOUND_EXACT;
+			if (node->eval <= alphaOrig)
+				bound = maximize ? BOUND_UPPER : BOUND_LOWER;
+			else if (node->eval >= betaOrig)
+				bound = maximize ? BOUND_LOWER : BOUND_UPPER;
+
+			int eval = toTableEval(node->eval, node->depth, maximize);
+			table.store(key, bestMove, eval, remaining, bound);
+
+			if (analysis && remaining >= analysisMinDepth)
+				analysis->store(key, bestMove, eval, remaining, bound);
+		}
 	}
 }
 
-void Engine::evaluate(Node *node)
+bool Engine::isSingular(Node *node, Move move, int eval)
 {
-	int own = getScore(node->board, board.getCurrent());
-	int opp = getScore(node->board, flipColor(board.getCurrent()));
+	bool maximize = node->board.getCurrent() == board.getCurrent();
+	int remaining = node->horizon - node->depth;
+	int margin = singularMargin * remaining;
+
+	// Search the same position with the move excluded and a reduced depth,
+	// using a zero window just below (or above for the minimizing side) the margin.
+	Node *probe = allocNode();
+	*probe = *node;
+	probe->horizon = node->depth + remaining / 2;
+	probe->excluded = move;
+
+	bool ret;
+
+	if (maximize) {
+		int singularBeta = eval - margin;
+		search<NODE_NONPV>(probe, singularBeta - 1, singularBeta);
+		ret = probe->eval < singularBeta;
+	}
+	else {
+		int singularAlpha = eval + margin;
+		search<NODE_NONPV>(probe, singularAlpha, singularAlpha + 1);
+		ret = probe->eval > singularAlpha;
+	}
 
-	node->eval = own - opp;
+	freeNode(probe);
 
+	return ret;
+}
+
+void Engine::evaluate(Node *node)
+{
 	total++;
+	selDepth = std::max(selDepth, node->depth);
+	node->eval = getStaticEval(node);
+}
+
+int Engine::getStaticEval(Node *node)
+{
+	// Cached from white's point of view, so that it doesn't depend on the root position
+	bool flip = board.getCurrent() != WHITE;
+	uint64_t key = node->board.getKey();
+
+	int eval;
+	if (!evalCache.probe(key, eval)) {
+		const MaterialEntry &material = materialTable.probe(node->board);
+
+		if (material.hasEndgame(node->board)) {
+			eval = material.evaluate(node->board);
+		}
+		else if (network) {
+			// Network evaluates from the perspective of the side to move
+			Color current = node->board.getCurrent();
+			eval = network->evaluate(node->accumulator, current);
+
+			if (current != WHITE)
+				eval = -eval;
+
+			eval = eval * material.getScale(node->board, eval > 0 ? WHITE : BLACK) / SCALE_NORMAL;
+		}
+		else {
+			Score white = getScore(node->board, node->attacks, WHITE);
+			Score black = getScore(node->board, node->attacks, BLACK);
+			Score total = white - black + material.imbalance;
+
+			// Hard to win endgames count less for the side which is ahead
+			int endgame = total.getEndgame();
+			endgame = endgame * material.getScale(node->board, endgame > 0 ? WHITE : BLACK) / SCALE_NORMAL;
+
+			eval = Score(total.getMidgame(), endgame).taper(node->board.getPhase(), MAX_PHASE);
+		}
+
+		evalCache.store(key, eval);
+	}
+
+	return flip ? -eval : eval;
 }
 
-int Engine::getScore(const Board &board, Color color) const
+Score Engine::getScore(const Board &board, AttackInfo &attacks, Color color)
 {
 	Color ownColor = color;
 	Color oppColor = flipColor(ownColor);
@@ -297,77 +1132,60 @@ int Engine::getScore(const Board &board, Color color) const
 
 	Bitboard ownKing = board.getPieces(color, KING);
 
-	Bitboard attackedSquares = getAvailableCaptures(board, allPieces, oppPieces);
-	Bitboard attackingSquares = getAvailableCaptures(board, allPieces, ownPieces);
-
-	int ret = 0;
+	Bitboard attackedSquares = attacks.getAttacks(board, oppColor);
+	Bitboard attackingSquares = attacks.getAttacks(board, ownColor);
 
-	// Sum raw piece values
-	for (uint64_t i = 0; i <  64; ++i) {
-		SquareState square = board.getSquare(Square(i));
-
-		if (!square.isOccupied() || square.getColor() != color)
-			continue;
-
-		ret += getPieceValue(square.getPiece());
-	}
+	// Raw piece values and piece-square scores
+	Score ret = board.getPositional(color);
 
 	// Getting checked is bad.
 	if (attackedSquares & ownKing) {
-		ret -= 500;
+		ret += checkedScore;
 	}
 
 	// Holding control of more squares is good.
-	ret += (attackingSquares).count() * 10;
+	ret += mobilityScore * attackingSquares.count();
 
 	// Threathening opponent is good.
-	ret += (oppPieces & attackingSquares).count() * 100;
+	ret += threatScore * (oppPieces & attackingSquares).count();
 
-	// Holding center is good.
-	ret += (centerSquares & attackingSquares).count() * 50;
-	ret += (centerSquares & ownPieces).count() * 50;
+	// Controlling center is good.
+	ret += centerControlScore * (centerSquares & attackingSquares).count();
 
-	// Doubled pawns are bad.
-	for (int i = FILE_A; i <= FILE_H; ++i) {
-		if ((ownPieces & Bitboard::file(i)).count() > 1) {
-			ret -= 100;
-		}
-	}
+	// Pawn structure rarely changes, use cached evaluation.
+	const PawnEntry &pawns = pawnTable.probe(board);
+	ret += pawns.scores[colorIndex(color)];
+
+	// Passed pawns which can advance freely are dangerous.
+	Bitboard passed = pawns.passed[colorIndex(color)];
+	Bitboard stops = color == WHITE
+		? PawnTraits<WHITE>::push(passed)
+		: PawnTraits<BLACK>::push(passed);
+
+	ret += freePassedScore * (stops & ~allPieces & ~attackedSquares).count();
 
 	// Guarded king is good
-	Square king = ownKing.findFirstSquare();
-	int guards = (ownPieces & Bitboard::adjacent(king)).count();
+	int guards = (ownPieces & ~ownKing & attacks.getKingZone(board, color)).count();
 	if (guards > 2)
-		ret += 100;
+		ret += kingGuardedScore;
 	else if (guards == 1)
-		ret += 50;
+		ret += kingSingleGuardScore;
 
 	return ret;
 }
 
-int Engine::getPieceValue(Piece piece) const
-{
-	switch (piece) {
-		case PAWN:   return PAWN_VALUE;
-		case ROOK:   return ROOK_VALUE;
-		case KNIGHT: return KNIGHT_VALUE;
-		case BISHOP: return BISHOP_VALUE;
-		case QUEEN:  return QUEEN_VALUE;
-		case KING:   return 0; // Worth nothing, yet everything.
-	}
-
-	assert(false && "Should be unreachable");
-	return 0;
-}
-
 Node * Engine::allocNode()
 {
 	Node *node = new Node();
 
 	node->depth = 0;
+	node->horizon = 0;
+	node->extensions = 0;
+	node->inCheck = false;
 	node->movesCount = 0;
 	node->promote = PAWN;
 	node->eval = 0;
+	node->attacks.reset();
 
 	return node;
 }
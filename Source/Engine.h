@@ -1,5 +1,20 @@
 #pragma once
+#include "Attacks.h"
 #include "Board.h"
+#include "Book.h"
+#include "EvalCache.h"
+#include "Material.h"
+#include "Nnue.h"
+#include "PawnTable.h"
+#include "Syzygy.h"
+#include "Transposition.h"
+
+#include <array>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
 
 namespace vimlock
 {
@@ -23,6 +38,42 @@ struct Evaluation
 	uint64_t total;
 };
 
+/// Progress of a search, reported after each completed iteration.
+struct SearchInfo
+{
+	/// Depth of the iteration.
+	int depth;
+
+	/// Length of the longest path searched, including extensions.
+	int selDepth;
+
+	/// Evaluation from the perspective of the side to move. Tablebase wins are bounded
+	/// to 20000 minus the plies to reach the tablebase position, and losses likewise.
+	int eval;
+
+	/// Number of moves until checkmate, negative if the side to move gets checkmated.
+	/// Zero if the evaluation is not a checkmate.
+	int mate;
+
+	/// Number of positions evaluated so far.
+	uint64_t nodes;
+
+	/// Number of successful tablebase probes so far.
+	uint64_t tbHits;
+
+	/// Milliseconds since the search started.
+	uint64_t time;
+
+	/// Positions evaluated per second, measured in microseconds. Zero if no time has passed.
+	uint64_t nps;
+
+	/// How full the transposition table is in permille.
+	int hashfull;
+
+	/// Best continuation found by the iteration.
+	MoveList continuation;
+};
+
 struct Node
 {
 	Move getMove() const;
@@ -48,6 +99,20 @@ struct Node
 	/// Evaluation depth at this node
 	int depth;
 
+	/// Depth at which the position is evaluated statically instead of searching further.
+	/// Starts at the search depth and grows by one for each extension on the path.
+	int horizon;
+
+	/// Number of plies the path leading to this node has been extended by.
+	int extensions;
+
+	/// Move skipped when searching this node, used for singular extension search.
+	/// Default constructed move if nothing should be skipped.
+	Move excluded;
+
+	/// Set if the side to move is in check.
+	bool inCheck;
+
 	/// Squares occupied by any piece.
 	Bitboard allPieces;
 
@@ -60,14 +125,39 @@ struct Node
 	/// Bitmask of our own king.
 	Bitboard ownKing;
 
+	/// Attack maps, checkers and pins of this position, shared by legality checks
+	/// of the moves and the static evaluation.
+	AttackInfo attacks;
+
+	/// Feature transformer output of this position, valid only when a network is in use.
+	Accumulator accumulator;
+
 	int movesCount;
 	Move moves[256];
 };
 
+/// Kind of node in the search tree, search is specialized for each type.
+enum NodeType
+{
+	/// Starting position of the search.
+	NODE_ROOT,
+
+	/// Node on the principal variation, searched with an open window.
+	NODE_PV,
+
+	/// Node searched with a zero window only to prove it's worse than the current best.
+	NODE_NONPV
+};
+
 enum MoveOrder
 {
+	MOVE_TABLE,
 	MOVE_CAPTURE,
 	MOVE_PROMOTE,
+
+	/// Quiet move which caused a cutoff in another position at the same depth.
+	MOVE_KILLER,
+
 	MOVE_REGULAR
 };
 
@@ -85,6 +175,9 @@ struct MoveCandidate
 
 	Move move;
 	MoveOrder order;
+
+	/// Orders moves of the same kind, higher first.
+	int score = 0;
 };
 
 class Engine
@@ -95,9 +188,18 @@ public:
 	/// Set current board position.
 	void setPosition(const Board &board);
 
+	/// Set current board position and keys of the positions played before it, oldest
+	/// first, so that the search can tell when a move repeats an earlier position.
+	void setPosition(const Board &board, const std::vector<uint64_t> &history);
+
 	/// Get current board position.
 	Board getPosition() const;
 
+	/// Forget what was learned by searches during the previous game. Searches within
+	/// a game start from the transposition table, history and killer moves left by
+	/// the previous one.
+	void newGame();
+
 	/// Start searching for a best move from current position.
 	void start();
 
@@ -108,25 +210,152 @@ public:
 	/// Stop searching for the best move.
 	void stop();
 
+	/// Call `handler` after each completed iteration of the search.
+	void setIterationHandler(std::function<void (const SearchInfo &)> handler);
+
+	/// Call `handler` with each root move about to be searched, and its number starting
+	/// from one, once the search has been running for given time.
+	void setCurrentMoveHandler(std::function<void (Move, int)> handler,
+		std::chrono::milliseconds delay=std::chrono::milliseconds(1000));
+
+	/// Evaluate positions with the network stored in given file instead of the
+	/// hand written evaluation. Empty path switches back to the hand written one.
+	/// Returns false and keeps the current evaluation if the file can't be loaded.
+	bool setEvalFile(const std::string &path);
+
+	/// Probe Syzygy tablebases found in given directories, separated by ':'.
+	/// Empty path disables probing. Returns number of tables found.
+	int setSyzygyPath(const std::string &path);
+
+	/// Resize the transposition table to given number of megabytes, rounded down to a
+	/// power of two, forgetting its contents.
+	/// Returns false and keeps the current table if the memory can't be allocated.
+	bool setHashSize(size_t megabytes);
+
+	/// Share the transposition table with other processes through the named POSIX shared
+	/// memory segment, created with the current table size if it doesn't exist yet.
+	/// Empty name switches back to a table of this process.
+	/// Returns false and keeps the current table if the segment can't be used.
+	bool setSharedHash(const std::string &name);
+
+	/// Keep results of deep searches in given file, so that they are found again by later
+	/// runs. The file is created if it doesn't exist. Empty path disables the file.
+	/// Returns false and disables the file if it can't be used.
+	bool setAnalysisFile(const std::string &path);
+
+	/// Return how full the transposition table is in permille.
+	int getHashfull() const;
+
+	/// Prune late quiet moves and quiet moves with poor history near the horizon.
+	/// Enabled by default, disabling searches every move.
+	void setPruning(bool enabled);
+
+	/// Play moves from the Polyglot book in given file when the position is found in it,
+	/// without searching. Empty path disables the book.
+	/// Returns false and disables the book if the file can't be loaded.
+	bool setBookFile(const std::string &path);
+
 private:
+	/// Search node which is not past the horizon.
+	/// Continuation leading to the best evaluation is stored only on root and PV nodes.
+	template <NodeType type, bool inCheck>
 	void traverse(Node *node, int alpha, int beta);
 
+	/// Search child node, or evaluate it directly if it's past the horizon.
+	template <NodeType type>
+	void search(Node *node, int alpha, int beta);
+
+	/// Returns true if all moves other than `move` are worse than `eval` by a margin
+	/// when searched to a reduced depth.
+	bool isSingular(Node *node, Move move, int eval);
+
+	/// Returns true if the position of the node has occurred before, on the searched path
+	/// or in the game history, with only reversible moves played since.
+	bool isRepetition(const Node *node, uint64_t key) const;
+
+	/// Age what was learned by the previous search before starting a new one.
+	void prepareSearch();
+
+	/// Remember a quiet move which caused a cutoff, so that it's tried early in other
+	/// positions. Quiet moves tried before it, which didn't, are tried later.
+	void addCutoff(const Node *node, Move move, const Move *tried, int triedCount);
+
 	/// Evaluate current nodes position, taking into account piece value, king safety, etc.
 	void evaluate(Node *node);
 
-	int getScore(const Board &board, Color color) const;
+	/// Return static evaluation of the node relative to the root, without counting it
+	/// as an evaluated position.
+	int getStaticEval(Node *node);
+
+	Score getScore(const Board &board, AttackInfo &attacks, Color color);
 
 	Node * allocNode();
 	void freeNode(Node *node);
 
-	int getPieceValue(Piece piece) const;
-
 	Board board;
-	
+
+	/// Keys of the positions played before `board`, oldest first.
+	std::vector<uint64_t> history;
+
+	/// Keys of the positions on the searched path, indexed by depth.
+	std::vector<uint64_t> pathKeys;
+
+	/// Static evaluations on the searched path from the perspective of the side to move,
+	/// indexed by depth. Set only near the horizon and not for positions in check.
+	std::vector<int> pathEvals;
+
 	int maxDepth;
 
-	/// Statistics
+	/// How many plies a single path can be extended beyond `maxDepth`.
+	int maxExtensions;
+
+	/// See `setPruning()`.
+	bool pruning = true;
+
+	/// Results of previously searched positions.
+	TranspositionTable table;
+
+	/// Results of deep searches of this and earlier runs, if enabled.
+	std::unique_ptr<TranspositionTable> analysis;
+
+	/// How much quiet moves have caused cutoffs, by color, source and destination.
+	int quietHistory[2][64][64];
+
+	/// Two most recent quiet moves which caused a cutoff, by depth.
+	std::vector<std::array<Move, 2>> killers;
+
+	/// Size of `history` when the previous search started, killers are shifted by
+	/// the number of plies played since.
+	size_t searchedPlies = 0;
+
+	/// Network used for evaluation, if set.
+	std::unique_ptr<Network> network;
+
+	/// Static evaluations of previously seen positions.
+	EvalCache evalCache;
+
+	/// Material imbalances and endgames, kept between searches as they don't depend on the search.
+	MaterialTable materialTable;
+
+	/// Pawn structure evaluations, kept between searches as they don't depend on the search.
+	PawnTable pawnTable;
+
+	/// Exact results of endgames with few pieces.
+	Tablebases tablebases;
+
+	/// Opening moves played without searching.
+	Book book;
+
+	/// Statistics of the current search, kept by the searching thread.
 	uint64_t total = 0;
+	uint64_t tbHits = 0;
+	int selDepth = 0;
+
+	std::chrono::steady_clock::time_point searchStart;
+
+	std::function<void (const SearchInfo &)> iterationHandler;
+	std::function<void (Move, int)> currentMoveHandler;
+	std::chrono::milliseconds currentMoveDelay = std::chrono::milliseconds(0);
 };
 
 } // namespace vimlock
@@ -81,4 +81,24 @@ inline Color flipColor(Color c)
 	return c == WHITE ? BLACK : WHITE;
 }
 
+/// Return color as an index between 0 and 1, usable for indexing tables.
+inline int colorIndex(Color c)
+{
+	return c == WHITE ? 0 : 1;
+}
+
+/// Return piece type as an index between 0 and 5, usable for indexing tables.
+inline int pieceIndex(Piece p)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctz(p);
+#else
+#warning "no optimized function for ctz"
+	int ret = 0;
+	while (!(p & (1 << ret)))
+		ret++;
+	return ret;
+#endif
+}
+
 } // namespace vimlock
@@ -0,0 +1,248 @@
+#include "Epd.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <functional>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace vimlock
+{
+
+/// Return start of the line following `ptr`, or `end`.
+static const char *nextLine(const char *ptr, const char *end)
+{
+	const char *ret = static_cast<const char *>(memchr(ptr, '\n', end - ptr));
+	return ret ? ret + 1 : end;
+}
+
+static bool isBlank(const char *begin, const char *end)
+{
+	for (const char *ptr = begin; ptr < end; ++ptr) {
+		if (!isspace(static_cast<unsigned char>(*ptr)))
+			return false;
+	}
+
+	return true;
+}
+
+/// Trim spaces, and the line ending, from both ends of a range.
+static void trim(const char *&begin, const char *&end)
+{
+	while (begin < end && isspace(static_cast<unsigned char>(*begin)))
+		begin++;
+
+	while (end > begin && isspace(static_cast<unsigned char>(end[-1])))
+		end--;
+}
+
+EpdFile::EpdFile()
+{
+}
+
+EpdFile::~EpdFile()
+{
+	unmap();
+}
+
+void EpdFile::unmap()
+{
+	if (map)
+		munmap(map, mapSize);
+
+	map = nullptr;
+	mapSize = 0;
+}
+
+bool EpdFile::load(const std::string &path, int threads)
+{
+	unmap();
+	boards.clear();
+	operations.clear();
+	skipped = 0;
+
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		logError("Can't open EPD file: " + path);
+		return false;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		close(fd);
+		return false;
+	}
+
+	// Nothing to map
+	if (st.st_size == 0) {
+		close(fd);
+		return true;
+	}
+
+	void *tmp = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (tmp == MAP_FAILED) {
+		logError("Can't map EPD file: " + path);
+		return false;
+	}
+
+	madvise(tmp, st.st_size, MADV_SEQUENTIAL);
+
+	map = tmp;
+	mapSize = st.st_size;
+
+	const char *data = static_cast<const char *>(map);
+	const char *end = data + mapSize;
+
+	// Split into chunks at line boundaries, one per thread
+	threads = std::max(threads, 1);
+
+	std::vector<const char *> chunks;
+	chunks.push_back(data);
+
+	for (int i = 1; i < threads; ++i) {
+		const char *split = std::max(chunks.back(), data + mapSize * i / threads);
+		chunks.push_back(split == data ? data : nextLine(split - 1, end));
+	}
+
+	chunks.push_back(end);
+
+	auto parallel = [threads](std::function<void (int)> fn) {
+		std::vector<std::thread> pool;
+		for (int i = 1; i < threads; ++i)
+			pool.emplace_back(fn, i);
+
+		fn(0);
+
+		for (std::thread &it : pool)
+			it.join();
+	};
+
+	// Count lines of each chunk to know where its positions go
+	std::vector<size_t> offsets(threads + 1, 0);
+
+	parallel([&](int chunk) {
+		size_t count = 0;
+
+		for (const char *line = chunks[chunk]; line < chunks[chunk + 1]; ) {
+			const char *next = nextLine(line, end);
+			if (!isBlank(line, next))
+				count++;
+
+			line = next;
+		}
+
+		offsets[chunk + 1] = count;
+	});
+
+	for (int i = 0; i < threads; ++i)
+		offsets[i + 1] += offsets[i];
+
+	boards.resize(offsets.back());
+	operations.resize(offsets.back());
+
+	std::vector<uint8_t> valid(offsets.back(), 0);
+
+	parallel([&](int chunk) {
+		size_t idx = offsets[chunk];
+
+		for (const char *line = chunks[chunk]; line < chunks[chunk + 1]; ) {
+			const char *next = nextLine(line, end);
+
+			if (!isBlank(line, next)) {
+				const char *rest;
+				valid[idx] = boards[idx].fromFen(line, next, rest);
+
+				if (valid[idx]) {
+					trim(rest, next);
+					operations[idx] = Span{rest, next};
+				}
+
+				idx++;
+			}
+
+			line = next;
+		}
+	});
+
+	// Drop invalid lines, keeping the order
+	size_t count = 0;
+
+	for (size_t i = 0; i < valid.size(); ++i) {
+		if (!valid[i])
+			continue;
+
+		if (count != i) {
+			boards[count] = boards[i];
+			operations[count] = operations[i];
+		}
+
+		count++;
+	}
+
+	skipped = valid.size() - count;
+	boards.resize(count);
+	operations.resize(count);
+
+	if (skipped)
+		logError("Skipped " + std::to_string(skipped) + " invalid lines in EPD file: " + path);
+
+	return true;
+}
+
+std::string EpdFile::getOperations(size_t idx) const
+{
+	return std::string(operations[idx].begin, operations[idx].end);
+}
+
+bool EpdFile::getOperation(size_t idx, const std::string &opcode, std::string &ret) const
+{
+	const char *ptr = operations[idx].begin;
+	const char *end = operations[idx].end;
+
+	while (ptr < end) {
+		// Operations end at a semicolon outside quotes
+		const char *op = ptr;
+		bool quoted = false;
+
+		while (ptr < end && (quoted || *ptr != ';')) {
+			if (*ptr == '"')
+				quoted = !quoted;
+			ptr++;
+		}
+
+		const char *opEnd = ptr;
+		if (ptr < end)
+			ptr++;
+
+		trim(op, opEnd);
+
+		const char *name = op;
+		while (op < opEnd && !isspace(static_cast<unsigned char>(*op)))
+			op++;
+
+		if (static_cast<size_t>(op - name) != opcode.size() || strncmp(name, opcode.data(), opcode.size()) != 0)
+			continue;
+
+		trim(op, opEnd);
+
+		ret.clear();
+		for (; op < opEnd; ++op) {
+			if (*op != '"')
+				ret += *op;
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
+} // namespace vimlock
@@ -0,0 +1,67 @@
+#pragma once
+#include "Board.h"
+
+#include <string>
+#include <vector>
+
+namespace vimlock
+{
+
+/// Positions of an EPD file, such as a test suite or tuning data, memory mapped and
+/// parsed in parallel into a contiguous array.
+///
+/// Each line is a position in FEN, clocks optional, followed by operations such as
+/// `bm Nf3; id "WAC.001";`. Operations are kept as text in the mapped file and parsed
+/// only when asked for.
+class EpdFile
+{
+public:
+	EpdFile();
+	~EpdFile();
+
+	EpdFile(const EpdFile &) = delete;
+	EpdFile & operator = (const EpdFile &) = delete;
+
+	/// Load positions from a file using given number of threads. Lines which are not
+	/// valid positions are skipped. Returns false if the file can't be read.
+	bool load(const std::string &path, int threads=1);
+
+	/// Return number of positions loaded.
+	size_t size() const { return boards.size(); }
+
+	/// Return number of lines skipped by the last load.
+	size_t getSkipped() const { return skipped; }
+
+	const Board & getBoard(size_t idx) const { return boards[idx]; }
+
+	/// Return all positions, in the order of the file.
+	const std::vector<Board> & getBoards() const { return boards; }
+
+	/// Return operations of a position as they appear in the file.
+	std::string getOperations(size_t idx) const;
+
+	/// Find operation with given opcode, e.g. "bm" or "id", and store its operands into
+	/// `ret` with quotes removed. Returns false if the position has no such operation.
+	bool getOperation(size_t idx, const std::string &opcode, std::string &ret) const;
+
+private:
+	struct Span
+	{
+		const char *begin;
+		const char *end;
+	};
+
+	void unmap();
+
+	void *map = nullptr;
+	size_t mapSize = 0;
+
+	std::vector<Board> boards;
+
+	/// Operations of each position, pointing into the mapped file.
+	std::vector<Span> operations;
+
+	size_t skipped = 0;
+};
+
+} // namespace vimlock
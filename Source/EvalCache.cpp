@@ -0,0 +1,57 @@
+#include "EvalCache.h"
+#include "Memory.h"
+
+#include <cassert>
+
+namespace vimlock
+{
+
+constexpr size_t EvalCache::defaultEntries;
+constexpr uint64_t EvalCache::validBit;
+
+EvalCache::EvalCache(size_t count)
+{
+	assert(count > 0);
+
+	size_t size = roundDownToPowerOfTwo(count);
+
+	entries.reset(new Entry[size]);
+	mask = size - 1;
+
+	clear();
+}
+
+void EvalCache::clear()
+{
+	for (uint64_t i = 0; i <= mask; ++i) {
+		entries[i].check.store(0, std::memory_order_relaxed);
+		entries[i].data.store(0, std::memory_order_relaxed);
+	}
+}
+
+bool EvalCache::probe(uint64_t key, int &ret) const
+{
+	const Entry &entry = entries[key & mask];
+
+	uint64_t data = entry.data.load(std::memory_order_relaxed);
+	uint64_t check = entry.check.load(std::memory_order_relaxed);
+
+	// Either a different position or the halves come from different writes
+	if (!(data & validBit) || (check ^ data) != key)
+		return false;
+
+	ret = static_cast<int32_t>(static_cast<uint32_t>(data));
+	return true;
+}
+
+void EvalCache::store(uint64_t key, int eval)
+{
+	Entry &entry = entries[key & mask];
+
+	uint64_t data = static_cast<uint32_t>(eval) | validBit;
+
+	entry.check.store(key ^ data, std::memory_order_relaxed);
+	entry.data.store(data, std::memory_order_relaxed);
+}
+
+} // namespace vimlock
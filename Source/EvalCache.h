@@ -0,0 +1,51 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+namespace vimlock
+{
+
+/// Position keyed cache of static evaluations.
+///
+/// Direct mapped, each key has only a single slot and newer results always replace
+/// older ones. Entries store the key XOR'ed with the data, so that a torn entry
+/// written concurrently by another thread fails verification instead of returning
+/// a wrong evaluation. This makes the cache safe to share between threads without locks.
+class EvalCache
+{
+public:
+	/// Construct a cache with given number of entries, rounded down to a power of two.
+	explicit EvalCache(size_t entries=defaultEntries);
+
+	/// Forget all stored evaluations.
+	void clear();
+
+	/// If the position has been stored, copies its evaluation to `ret` and returns true.
+	bool probe(uint64_t key, int &ret) const;
+
+	/// Remember evaluation of a position.
+	void store(uint64_t key, int eval);
+
+	static constexpr size_t defaultEntries = 1 << 16;
+
+private:
+	struct Entry
+	{
+		/// Key of the position XOR `data`.
+		std::atomic<uint64_t> check;
+
+		/// Evaluation in the lower 32 bits, `validBit` set once stored.
+		std::atomic<uint64_t> data;
+	};
+
+	static constexpr uint64_t validBit = 1ULL << 32;
+
+	std::unique_ptr<Entry[]> entries;
+
+	/// Number of entries - 1, used for masking the key into an index.
+	uint64_t mask;
+};
+
+} // namespace vimlock
@@ -0,0 +1,299 @@
+#include "Material.h"
+#include "Bitbase.h"
+#include "Memory.h"
+#include "Psqt.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+
+namespace vimlock
+{
+
+constexpr size_t MaterialTable::defaultEntries;
+
+// Imbalance terms as midgame and endgame scores, in centipawns.
+constexpr Score bishopPairScore = Score(30, 50);
+
+/// Knights get better with more pawns on the board, per pawn above five.
+constexpr Score knightPawnScore = Score(3, 3);
+
+/// Rooks get better as pawns get traded, per pawn below five.
+constexpr Score rookPawnScore = Score(6, 6);
+
+/// Scale of an endgame with only opposite colored bishops and pawns.
+constexpr int oppositeBishopsScale = 18;
+
+/// Scale of an endgame with opposite colored bishops and other pieces.
+constexpr int oppositeBishopsPiecesScale = 46;
+
+/// Scale when a side without pawns is ahead by a rook against a minor piece or so.
+constexpr int hardToWinScale = 16;
+
+/// Return number of king moves between the squares.
+static int getDistance(Square a, Square b)
+{
+	return std::max(std::abs(a.getFile() - b.getFile()), std::abs(a.getRank() - b.getRank()));
+}
+
+/// Bonus for having the king on given square pushed towards the edge.
+static int getPushToEdge(Square square)
+{
+	int file = std::max(FILE_D - square.getFile(), square.getFile() - FILE_E);
+	int rank = std::max(RANK_4 - square.getRank(), square.getRank() - RANK_5);
+
+	return 20 * (file + rank);
+}
+
+/// Bonus for having the kings close to each other.
+static int getPushClose(Square a, Square b)
+{
+	return 20 * (7 - getDistance(a, b));
+}
+
+static bool isDarkSquare(Square square)
+{
+	return (square.getFile() + square.getRank()) % 2 == 0;
+}
+
+/// Return non-pawn material of given color.
+static int getPieceMaterial(const Board &board, Color color)
+{
+	return board.getMaterial(color) - board.getPieces(color, PAWN).count() * PAWN_VALUE;
+}
+
+/// Returns true if given color has at most a minor piece or two knights, which can't force mate.
+static bool isInsufficient(const Board &board, Color color)
+{
+	int minors = board.getPieces(color, KNIGHT).count() + board.getPieces(color, BISHOP).count();
+	int majors = board.getPieces(color, ROOK).count() + board.getPieces(color, QUEEN).count();
+
+	if (board.getPieces(color, PAWN) || majors > 0)
+		return false;
+
+	return minors <= 1 || (minors == 2 && board.getPieces(color, KNIGHT).count() == 2);
+}
+
+/// Imbalance of given color.
+static Score getImbalance(const Board &board, Color color)
+{
+	int pawns = board.getPieces(color, PAWN).count();
+
+	Score ret;
+
+	if (board.getPieces(color, BISHOP).count() >= 2)
+		ret += bishopPairScore;
+
+	ret += knightPawnScore * (board.getPieces(color, KNIGHT).count() * (pawns - 5));
+	ret += rookPawnScore * (board.getPieces(color, ROOK).count() * (5 - pawns));
+
+	return ret;
+}
+
+/// Lone king against mating material: push the king to the edge and get close to it.
+static int evaluateKXK(const Board &board, Color strong)
+{
+	Square strongKing = board.getPieces(strong, KING).findFirstSquare();
+	Square weakKing = board.getPieces(flipColor(strong), KING).findFirstSquare();
+
+	return KNOWN_WIN_EVAL + board.getMaterial(strong)
+		+ getPushToEdge(weakKing)
+		+ getPushClose(strongKing, weakKing);
+}
+
+/// Bishop and knight: the king must be driven to a corner of the bishop's color.
+static int evaluateKBNK(const Board &board, Color strong)
+{
+	Square strongKing = board.getPieces(strong, KING).findFirstSquare();
+	Square weakKing = board.getPieces(flipColor(strong), KING).findFirstSquare();
+	Square bishop = board.getPieces(strong, BISHOP).findFirstSquare();
+
+	int corner = isDarkSquare(bishop)
+		? std::min(getDistance(weakKing, Square(A1)), getDistance(weakKing, Square(H8)))
+		: std::min(getDistance(weakKing, Square(A8)), getDistance(weakKing, Square(H1)));
+
+	return KNOWN_WIN_EVAL + board.getMaterial(strong)
+		+ 40 * (7 - corner)
+		+ getPushClose(strongKing, weakKing);
+}
+
+/// King and pawn: exact result from the bitbase, winning faster the further the pawn is.
+static int evaluateKPK(const Board &board, Color strong)
+{
+	Color weak = flipColor(strong);
+
+	Square strongKing = board.getPieces(strong, KING).findFirstSquare();
+	Square weakKing = board.getPieces(weak, KING).findFirstSquare();
+	Square pawn = board.getPieces(strong, PAWN).findFirstSquare();
+
+	if (!probeKPK(strong, strongKing, pawn, weakKing, board.getCurrent()))
+		return 0;
+
+	int relativeRank = strong == WHITE ? pawn.getRank() : RANK_8 - pawn.getRank();
+
+	return KNOWN_WIN_EVAL + PAWN_VALUE + 10 * relativeRank;
+}
+
+bool MaterialEntry::hasEndgame(const Board &board) const
+{
+	if (endgame == ENDGAME_NONE)
+		return false;
+
+	// Bishops can mate only if there are bishops on both colors, or a knight to help
+	if (endgame == ENDGAME_KXK
+			&& !board.getPieces(strongSide, ROOK)
+			&& !board.getPieces(strongSide, QUEEN)
+			&& !board.getPieces(strongSide, KNIGHT)) {
+		bool dark = false;
+		bool light = false;
+
+		for (Bitboard bishops = board.getPieces(strongSide, BISHOP); bishops; ) {
+			if (isDarkSquare(bishops.popFirstSquare()))
+				dark = true;
+			else
+				light = true;
+		}
+
+		return dark && light;
+	}
+
+	return true;
+}
+
+int MaterialEntry::evaluate(const Board &board) const
+{
+	int eval = 0;
+
+	switch (endgame) {
+		case ENDGAME_NONE:
+			assert(false && "no specialized evaluation");
+			break;
+		case ENDGAME_DRAW:
+			eval = 0;
+			break;
+		case ENDGAME_KXK:
+			eval = evaluateKXK(board, strongSide);
+			break;
+		case ENDGAME_KBNK:
+			eval = evaluateKBNK(board, strongSide);
+			break;
+		case ENDGAME_KPK:
+			eval = evaluateKPK(board, strongSide);
+			break;
+	}
+
+	return strongSide == WHITE ? eval : -eval;
+}
+
+int MaterialEntry::getScale(const Board &board, Color color) const
+{
+	int ret = scale[colorIndex(color)];
+
+	// Bishop colors are not part of the material key, check them here
+	if (singleBishops) {
+		Square white = board.getPieces(WHITE, BISHOP).findFirstSquare();
+		Square black = board.getPieces(BLACK, BISHOP).findFirstSquare();
+
+		if (isDarkSquare(white) != isDarkSquare(black))
+			ret = std::min(ret, onlyBishops ? oppositeBishopsScale : oppositeBishopsPiecesScale);
+	}
+
+	return ret;
+}
+
+MaterialTable::MaterialTable(size_t count)
+{
+	assert(count > 0);
+
+	size_t size = roundDownToPowerOfTwo(count);
+
+	entries.resize(size);
+	mask = size - 1;
+
+	clear();
+}
+
+void MaterialTable::clear()
+{
+	for (MaterialEntry &it : entries)
+		it.valid = false;
+}
+
+const MaterialEntry & MaterialTable::probe(const Board &board)
+{
+	uint64_t key = board.getMaterialKey();
+	MaterialEntry &entry = entries[key & mask];
+
+	if (!entry.valid || entry.key != key) {
+		evaluate(board, entry);
+		entry.key = key;
+		entry.valid = true;
+	}
+
+	return entry;
+}
+
+void MaterialTable::evaluate(const Board &board, MaterialEntry &ret)
+{
+	ret.imbalance = getImbalance(board, WHITE) - getImbalance(board, BLACK);
+	ret.endgame = ENDGAME_NONE;
+	ret.strongSide = WHITE;
+	ret.scale[0] = ret.scale[1] = SCALE_NORMAL;
+
+	ret.singleBishops = board.getPieces(WHITE, BISHOP).count() == 1 && board.getPieces(BLACK, BISHOP).count() == 1;
+	ret.onlyBishops = ret.singleBishops
+		&& getPieceMaterial(board, WHITE) == BISHOP_VALUE
+		&& getPieceMaterial(board, BLACK) == BISHOP_VALUE;
+
+	if (isInsufficient(board, WHITE) && isInsufficient(board, BLACK)) {
+		ret.endgame = ENDGAME_DRAW;
+		return;
+	}
+
+	// Specialized endgames, all of them without kings make no sense
+	for (Color strong : { WHITE, BLACK }) {
+		Color weak = flipColor(strong);
+
+		if (!board.getPieces(strong, KING) || !board.getPieces(weak, KING))
+			break;
+
+		// Lone king on the weak side
+		if (board.getPieces(weak) != board.getPieces(weak, KING))
+			continue;
+
+		Bitboard pieces = board.getPieces(strong) & ~board.getPieces(strong, KING);
+
+		int pawns = board.getPieces(strong, PAWN).count();
+		int knights = board.getPieces(strong, KNIGHT).count();
+		int bishops = board.getPieces(strong, BISHOP).count();
+		int majors = board.getPieces(strong, ROOK).count() + board.getPieces(strong, QUEEN).count();
+
+		ret.strongSide = strong;
+
+		if (pieces.count() == 1 && pawns == 1)
+			ret.endgame = ENDGAME_KPK;
+		else if (pawns == 0 && majors == 0 && knights == 1 && bishops == 1)
+			ret.endgame = ENDGAME_KBNK;
+		else if (pawns == 0 && (majors > 0 || bishops >= 2 || (bishops >= 1 && knights >= 2)))
+			ret.endgame = ENDGAME_KXK;
+
+		if (ret.endgame != ENDGAME_NONE)
+			return;
+	}
+
+	// Being ahead without pawns is often not enough
+	for (Color color : { WHITE, BLACK }) {
+		if (board.getPieces(color, PAWN))
+			continue;
+
+		int own = getPieceMaterial(board, color);
+		int opp = getPieceMaterial(board, flipColor(color));
+
+		if (isInsufficient(board, color))
+			ret.scale[colorIndex(color)] = 0;
+		else if (own - opp <= BISHOP_VALUE)
+			ret.scale[colorIndex(color)] = own < ROOK_VALUE ? 0 : hardToWinScale;
+	}
+}
+
+} // namespace vimlock
@@ -0,0 +1,107 @@
+#pragma once
+#include "Board.h"
+#include "Score.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace vimlock
+{
+
+/// Scale factor which leaves the endgame evaluation as is.
+constexpr int SCALE_NORMAL = 64;
+
+/// Evaluation of a won endgame, above anything the regular evaluation reaches
+/// but below checkmate.
+constexpr int KNOWN_WIN_EVAL = 10000;
+
+/// Endgames which have a specialized evaluation function.
+enum Endgame
+{
+	ENDGAME_NONE,
+
+	/// Nothing but kings and minor pieces which can't force mate.
+	ENDGAME_DRAW,
+
+	/// Lone king against mating material, e.g. KRK and KQK.
+	ENDGAME_KXK,
+
+	/// King, bishop and knight against lone king.
+	ENDGAME_KBNK,
+
+	/// King and pawn against lone king, exact result from the KPK bitbase.
+	ENDGAME_KPK,
+};
+
+/// Evaluation terms which depend only on the number of pieces of each type.
+struct MaterialEntry
+{
+	/// Return true if the specialized evaluation applies to the board. The endgame is
+	/// chosen by material alone, this checks what the material key can't see, such as
+	/// the colors of the bishops.
+	bool hasEndgame(const Board &board) const;
+
+	/// Return evaluation of the board from white's point of view,
+	/// must be called only if `hasEndgame()` returns true.
+	int evaluate(const Board &board) const;
+
+	/// Return factor for the endgame evaluation when given side is ahead, out of `SCALE_NORMAL`.
+	/// Combines `scale` with the terms which depend on the squares of the bishops.
+	int getScale(const Board &board, Color color) const;
+
+	/// Material key of the position, see `Board::getMaterialKey()`.
+	uint64_t key;
+
+	/// Set once the entry holds an evaluated material configuration.
+	bool valid;
+
+	/// Bonuses for combinations of pieces from white's point of view, e.g. bishop pair.
+	Score imbalance;
+
+	/// Specialized evaluation replacing the regular one, if any.
+	Endgame endgame;
+
+	/// Side which is trying to win the specialized endgame.
+	Color strongSide;
+
+	/// Factor for the endgame evaluation when given side is ahead, out of `SCALE_NORMAL`.
+	/// Less than normal for endgames which are hard to win, indexed by `colorIndex()`.
+	int scale[2];
+
+	/// Set if both sides have a single bishop, which may be of opposite colors.
+	bool singleBishops;
+
+	/// Set if the single bishops are the only pieces besides kings and pawns.
+	bool onlyBishops;
+};
+
+/// Material key indexed cache of `MaterialEntry`.
+///
+/// There are only a handful of material configurations in a single search, so
+/// nearly all lookups hit. Not thread safe, each searching thread should have its own table.
+class MaterialTable
+{
+public:
+	/// Construct a table with given number of entries, rounded down to a power of two.
+	explicit MaterialTable(size_t entries=defaultEntries);
+
+	/// Forget all stored entries.
+	void clear();
+
+	/// Return material evaluation of the board, evaluating it if not yet cached.
+	const MaterialEntry & probe(const Board &board);
+
+	/// Evaluate material configuration of the board without caching.
+	static void evaluate(const Board &board, MaterialEntry &ret);
+
+	static constexpr size_t defaultEntries = 1 << 13;
+
+private:
+	std::vector<MaterialEntry> entries;
+
+	/// Number of entries - 1, used for masking the key into an index.
+	uint64_t mask;
+};
+
+} // namespace vimlock
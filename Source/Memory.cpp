@@ -0,0 +1,87 @@
+#include "Memory.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <sys/mman.h>
+
+namespace vimlock
+{
+
+constexpr size_t LargeBuffer::pageSize;
+
+LargeBuffer::LargeBuffer()
+{
+}
+
+LargeBuffer::~LargeBuffer()
+{
+	release();
+}
+
+bool LargeBuffer::allocate(size_t size_, int threads)
+{
+	// Whole pages, as a partial huge page can't be backed by one
+	size_t rounded = (size_ + pageSize - 1) / pageSize * pageSize;
+
+	void *tmp = nullptr;
+	if (rounded == 0 || posix_memalign(&tmp, pageSize, rounded) != 0) {
+		logError("Can't allocate " + std::to_string(rounded) + " bytes for a table");
+		return false;
+	}
+
+#ifdef MADV_HUGEPAGE
+	// Only a hint, regular pages are used if huge pages are not available
+	madvise(tmp, rounded, MADV_HUGEPAGE);
+#endif
+
+	release();
+
+	data = tmp;
+	size = rounded;
+
+	clear(threads);
+
+	return true;
+}
+
+void LargeBuffer::release()
+{
+	free(data);
+
+	data = nullptr;
+	size = 0;
+}
+
+void LargeBuffer::clear(int threads)
+{
+	if (!data)
+		return;
+
+	// Pages are backed by memory on first touch, which happens here for new memory.
+	// Threads clear whole pages each, so that the pages are spread over the threads.
+	size_t pages = size / pageSize;
+	threads = std::max(1, std::min<int>(threads, static_cast<int>(pages)));
+
+	auto work = [this, pages, threads](int idx) {
+		size_t begin = pages * idx / threads * pageSize;
+		size_t end = pages * (idx + 1) / threads * pageSize;
+
+		std::memset(static_cast<char *>(data) + begin, 0, end - begin);
+	};
+
+	std::vector<std::thread> pool;
+	for (int i = 1; i < threads; ++i)
+		pool.emplace_back(work, i);
+
+	work(0);
+
+	for (std::thread &it : pool)
+		it.join();
+}
+
+} // namespace vimlock
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+
+namespace vimlock
+{
+
+/// Round a number of table entries down to a power of two, so that an index is a mask of
+/// the key. Count must be positive.
+inline size_t roundDownToPowerOfTwo(size_t count)
+{
+	size_t size = 1;
+	while (size * 2 <= count)
+		size *= 2;
+
+	return size;
+}
+
+/// Memory for large tables such as the transposition table.
+///
+/// Allocated aligned to 2 MB and, where supported, advised to be backed by huge pages.
+/// Tables are accessed at random, and with regular pages most of the accesses of a
+/// table much larger than the TLB coverage would miss the TLB.
+class LargeBuffer
+{
+public:
+	LargeBuffer();
+	~LargeBuffer();
+
+	LargeBuffer(const LargeBuffer &) = delete;
+	LargeBuffer & operator = (const LargeBuffer &) = delete;
+
+	/// Replace the memory with `size` bytes of new memory, zeroed.
+	/// Returns false and keeps the current memory if it can't be allocated.
+	bool allocate(size_t size, int threads=1);
+
+	/// Free the memory.
+	void release();
+
+	/// Zero the memory, splitting the work between given number of threads.
+	void clear(int threads=1);
+
+	void * getData() const { return data; }
+	size_t getSize() const { return size; }
+
+	/// Size of a huge page, the memory is aligned to this.
+	static constexpr size_t pageSize = 2 * 1024 * 1024;
+
+private:
+	void *data = nullptr;
+	size_t size = 0;
+};
+
+} // namespace vimlock
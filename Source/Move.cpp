@@ -120,7 +120,7 @@ bool Move::operator != (Move rhs) const
 	return false;
 }
 
-std::string MoveList::toLan()
+std::string MoveList::toLan() const
 {
 	std::string ret;
 
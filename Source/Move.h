@@ -47,7 +47,7 @@ public:
 	using std::vector<Move>::vector;
 
 	/// Return string representing this move list in long algebraic notation, e.g. "e2e4 e7e5 f2f5"
-	std::string toLan();
+	std::string toLan() const;
 };
 
 } // namespace vimlock
@@ -5,12 +5,51 @@
 namespace vimlock
 {
 
+/// Compile time properties of pawns for given color.
+template <Color C>
+struct PawnTraits;
+
+template <>
+struct PawnTraits<WHITE>
+{
+	/// Rank the pawns start from and can perform a double move.
+	static constexpr int doubleMoveRank = RANK_2;
+
+	/// Rank where pawns get promoted.
+	static constexpr int promotionRank = RANK_8;
+
+	/// Rank of the square passed over by an opponent double move, where en passant captures land.
+	static constexpr int enpassantRank = RANK_6;
+
+	/// Difference in square index when moving one rank forward.
+	static constexpr int forward = 8;
+
+	/// Move all bits one rank forward.
+	static constexpr Bitboard push(Bitboard b) { return b << 8; }
+};
+
+template <>
+struct PawnTraits<BLACK>
+{
+	static constexpr int doubleMoveRank = RANK_7;
+	static constexpr int promotionRank = RANK_1;
+	static constexpr int enpassantRank = RANK_3;
+	static constexpr int forward = -8;
+
+	static constexpr Bitboard push(Bitboard b) { return b >> 8; }
+};
+
 /// The function return bitboard of all positions given piece can be moved to
 ///
 /// NOTE: none of these functions test for check or castling, that must be handled
 /// by comparing the new position against opponents `getAvailableCaptures()` bitboard.
 Bitboard getAvailableMoves(Color color, Piece piece, Square idx, Bitboard allPieces, Bitboard ownPieces);
 
+/// Same as above but specialized for the color, for use in move generation where
+/// side to move is known once per position.
+template <Color C>
+Bitboard getAvailableMoves(Piece piece, Square idx, Bitboard allPieces, Bitboard ownPieces);
+
 /// Return bitboard of positions which given piece can attack to
 /// Almost same as `getAvailableCaptures()` but differs in case of pawns
 /// which can capture only diagonally.
@@ -19,14 +58,50 @@ Bitboard getAvailableCaptures(Color color, Piece piece, Square idx, Bitboard all
 /// For given board, return bitboard of the squares given color can capture
 Bitboard getAvailableCaptures(const Board &board, Bitboard allPieces, Bitboard ownPieces);
 
+/// For given board, return bitboard of pieces in `attackers` which can capture on given square.
+/// Cheaper than `getAvailableCaptures()` when only a single square is of interest, e.g. for check detection.
+Bitboard getAttackers(const Board &board, Square idx, Bitboard allPieces, Bitboard attackers);
+
+/// Returns true if the move is legal for the side to move, including castling and en passant.
+/// Slow compared to move generation, meant for checking moves coming from outside the search.
+bool isLegalMove(const Board &board, Move move);
+
 Bitboard getPawnMoves(Color color, Square idx, Bitboard allPieces);
 Bitboard getPawnAttacks(Color color, Square idx);
+template <Color C> Bitboard getPawnMoves(Square idx, Bitboard allPieces);
+template <Color C> Bitboard getPawnAttacks(Square idx);
 Bitboard getRookMoves(Square idx, Bitboard allPieces);
 Bitboard getKnightMoves(Square idx);
 Bitboard getBishopMoves(Square idx, Bitboard allPieces);
 Bitboard getQueenMoves(Square idx, Bitboard allPieces);
 Bitboard getKingMoves(Square idx);
 
+/// Set-wise versions of the above, computing moves of all given pieces at once.
+///
+/// Pawn pushes and captures are split by direction, so that the source square of each
+/// destination can be recovered by subtracting a fixed offset.
+
+/// Squares where given pawns can move one step forward.
+template <Color C> Bitboard getPawnPushes(Bitboard pawns, Bitboard allPieces);
+
+/// Squares where given pawns can perform a double move.
+template <Color C> Bitboard getPawnDoublePushes(Bitboard pawns, Bitboard allPieces);
+
+/// Squares attacked by given pawns towards file A, offset `forward - 1`.
+template <Color C> Bitboard getPawnAttacksWest(Bitboard pawns);
+
+/// Squares attacked by given pawns towards file H, offset `forward + 1`.
+template <Color C> Bitboard getPawnAttacksEast(Bitboard pawns);
+
+/// Squares attacked by any of given pawns.
+template <Color C> Bitboard getPawnAttacks(Bitboard pawns);
+
+/// Squares attacked by any of given knights.
+Bitboard getKnightAttacks(Bitboard knights);
+
+/// Squares attacked by any of given kings.
+Bitboard getKingAttacks(Bitboard kings);
+
 } // namespace vimlock
 
 #include "Moves.inl"
@@ -1,20 +1,73 @@
 #pragma once
 
 #include "Moves.h"
+#include "Sliders.h"
+#include <algorithm>
 #include <cassert>
 
 namespace vimlock
 {
 
+/// Squares attacked by a knight, indexed by square.
+constexpr uint64_t knightAttackTable[64] =
+{
+	0x0000000000020400ULL, 0x0000000000050800ULL, 0x00000000000A1100ULL, 0x0000000000142200ULL,
+	0x0000000000284400ULL, 0x0000000000508800ULL, 0x0000000000A01000ULL, 0x0000000000402000ULL,
+	0x0000000002040004ULL, 0x0000000005080008ULL, 0x000000000A110011ULL, 0x0000000014220022ULL,
+	0x0000000028440044ULL, 0x0000000050880088ULL, 0x00000000A0100010ULL, 0x0000000040200020ULL,
+	0x0000000204000402ULL, 0x0000000508000805ULL, 0x0000000A1100110AULL, 0x0000001422002214ULL,
+	0x0000002844004428ULL, 0x0000005088008850ULL, 0x000000A0100010A0ULL, 0x0000004020002040ULL,
+	0x0000020400040200ULL, 0x0000050800080500ULL, 0x00000A1100110A00ULL, 0x0000142200221400ULL,
+	0x0000284400442800ULL, 0x0000508800885000ULL, 0x0000A0100010A000ULL, 0x0000402000204000ULL,
+	0x0002040004020000ULL, 0x0005080008050000ULL, 0x000A1100110A0000ULL, 0x0014220022140000ULL,
+	0x0028440044280000ULL, 0x0050880088500000ULL, 0x00A0100010A00000ULL, 0x0040200020400000ULL,
+	0x0204000402000000ULL, 0x0508000805000000ULL, 0x0A1100110A000000ULL, 0x1422002214000000ULL,
+	0x2844004428000000ULL, 0x5088008850000000ULL, 0xA0100010A0000000ULL, 0x4020002040000000ULL,
+	0x0400040200000000ULL, 0x0800080500000000ULL, 0x1100110A00000000ULL, 0x2200221400000000ULL,
+	0x4400442800000000ULL, 0x8800885000000000ULL, 0x100010A000000000ULL, 0x2000204000000000ULL,
+	0x0004020000000000ULL, 0x0008050000000000ULL, 0x00110A0000000000ULL, 0x0022140000000000ULL,
+	0x0044280000000000ULL, 0x0088500000000000ULL, 0x0010A00000000000ULL, 0x0020400000000000ULL,
+};
+
+/// Squares attacked by a king, indexed by square.
+constexpr uint64_t kingAttackTable[64] =
+{
+	0x0000000000000302ULL, 0x0000000000000705ULL, 0x0000000000000E0AULL, 0x0000000000001C14ULL,
+	0x0000000000003828ULL, 0x0000000000007050ULL, 0x000000000000E0A0ULL, 0x000000000000C040ULL,
+	0x0000000000030203ULL, 0x0000000000070507ULL, 0x00000000000E0A0EULL, 0x00000000001C141CULL,
+	0x0000000000382838ULL, 0x0000000000705070ULL, 0x0000000000E0A0E0ULL, 0x0000000000C040C0ULL,
+	0x0000000003020300ULL, 0x0000000007050700ULL, 0x000000000E0A0E00ULL, 0x000000001C141C00ULL,
+	0x0000000038283800ULL, 0x0000000070507000ULL, 0x00000000E0A0E000ULL, 0x00000000C040C000ULL,
+	0x0000000302030000ULL, 0x0000000705070000ULL, 0x0000000E0A0E0000ULL, 0x0000001C141C0000ULL,
+	0x0000003828380000ULL, 0x0000007050700000ULL, 0x000000E0A0E00000ULL, 0x000000C040C00000ULL,
+	0x0000030203000000ULL, 0x0000070507000000ULL, 0x00000E0A0E000000ULL, 0x00001C141C000000ULL,
+	0x0000382838000000ULL, 0x0000705070000000ULL, 0x0000E0A0E0000000ULL, 0x0000C040C0000000ULL,
+	0x0003020300000000ULL, 0x0007050700000000ULL, 0x000E0A0E00000000ULL, 0x001C141C00000000ULL,
+	0x0038283800000000ULL, 0x0070507000000000ULL, 0x00E0A0E000000000ULL, 0x00C040C000000000ULL,
+	0x0302030000000000ULL, 0x0705070000000000ULL, 0x0E0A0E0000000000ULL, 0x1C141C0000000000ULL,
+	0x3828380000000000ULL, 0x7050700000000000ULL, 0xE0A0E00000000000ULL, 0xC040C00000000000ULL,
+	0x0203000000000000ULL, 0x0507000000000000ULL, 0x0A0E000000000000ULL, 0x141C000000000000ULL,
+	0x2838000000000000ULL, 0x5070000000000000ULL, 0xA0E0000000000000ULL, 0x40C0000000000000ULL,
+};
+
 inline Bitboard getAvailableMoves(Color color, Piece piece, Square idx, Bitboard allPieces, Bitboard ownPieces)
+{
+	if (color == WHITE)
+		return getAvailableMoves<WHITE>(piece, idx, allPieces, ownPieces);
+	else
+		return getAvailableMoves<BLACK>(piece, idx, allPieces, ownPieces);
+}
+
+template <Color C>
+inline Bitboard getAvailableMoves(Piece piece, Square idx, Bitboard allPieces, Bitboard ownPieces)
 {
 	Bitboard ret;
 
 	switch (piece) {
 		case PAWN:
-			ret = getPawnMoves(color, idx, allPieces);
+			ret = getPawnMoves<C>(idx, allPieces);
 			// Attack only opponent pieces
-			ret = ret | (getPawnAttacks(color, idx) & (~ownPieces & allPieces));
+			ret = ret | (getPawnAttacks<C>(idx) & (~ownPieces & allPieces));
 			break;
 		case ROOK:
 			ret = getRookMoves(idx, allPieces);
@@ -67,66 +120,130 @@ inline Bitboard getAvailableCaptures(const Board &board, Bitboard allPieces, Bit
 {
 	Bitboard ret;
 
-	for (uint64_t i = 0; i < 64; ++i) {
-		if (ownPieces & (Bitboard(Square(i)))) {
-			SquareState square = board.getSquare(Square(i));
-			ret |= getAvailableCaptures(square.getColor(), square.getPiece(), Square(i), allPieces);
-		}
-	}
+	Bitboard pawns = board.getPieces(PAWN) & ownPieces;
+	ret |= getPawnAttacks<WHITE>(pawns & board.getPieces(WHITE));
+	ret |= getPawnAttacks<BLACK>(pawns & board.getPieces(BLACK));
+
+	ret |= getKnightAttacks(board.getPieces(KNIGHT) & ownPieces);
+	ret |= getKingAttacks(board.getPieces(KING) & ownPieces);
+
+	Bitboard queens = board.getPieces(QUEEN);
+	Bitboard rooks = (board.getPieces(ROOK) | queens) & ownPieces;
+	Bitboard bishops = (board.getPieces(BISHOP) | queens) & ownPieces;
+
+	ret |= getSliderAttacks(rooks, bishops, allPieces);
 
 	return ret;
 }
 
-inline Bitboard getPawnMoves(Color color, Square idx, Bitboard allPieces)
+inline Bitboard getAttackers(const Board &board, Square idx, Bitboard allPieces, Bitboard attackers)
 {
-	Bitboard ret;
+	// Only pieces reachable from the target square by a queen or a knight can be attacking it,
+	// queen rays also cover adjacent kings and pawns.
+	Bitboard candidates = attackers & (getQueenMoves(idx, allPieces) | getKnightMoves(idx));
 
-	int rank = idx.getRank();
-	int file = idx.getFile();
-	int dir = color == WHITE ? +1 : -1;
-
-	// Can move forward one step?
-	if (!allPieces.contains(file, rank + dir)) {
-		ret |= Bitboard(Square(file, rank + dir));
-
-		// Can perform double move? Only valid if we can move at least one step
+	Bitboard ret;
+	Bitboard target(idx);
 
-		if (color == WHITE && rank == RANK_2) {
-			if (!allPieces.contains(file, rank + 2)) {
-				ret |= Bitboard(Square(file, rank + 2));
-			}
-		}
+	while (candidates) {
+		Square src = candidates.popFirstSquare();
+		SquareState square = board.getSquare(src);
 
-		if (color == BLACK && rank == RANK_7) {
-			if (!allPieces.contains(file, rank - 2)) {
-				ret |= Bitboard(Square(file, rank - 2));
-			}
-		}
+		if (getAvailableCaptures(square.getColor(), square.getPiece(), src, allPieces) & target)
+			ret |= Bitboard(src);
 	}
 
 	return ret;
 }
 
-// TODO: en-passant
-inline Bitboard getPawnAttacks(Color color, Square idx)
+inline bool isLegalMove(const Board &board, Move move)
 {
-	Bitboard ret;
+	Color own = board.getCurrent();
+	Color opp = flipColor(own);
 
-	int rank = idx.getRank();
-	int file = idx.getFile();
-	int dir = color == WHITE ? +1 : -1;
+	Square src = move.getSource();
+	Square dst = move.getDestination();
+	SquareState state = board.getSquare(src);
+
+	if (!state.isOccupied() || state.getColor() != own)
+		return false;
+
+	Bitboard allPieces = board.getPieces();
+	Bitboard ownPieces = board.getPieces(own);
+
+	bool castling = state.getPiece() == KING && (dst.getFile() == src.getFile() + 2 || dst.getFile() + 2 == src.getFile());
+
+	if (castling) {
+		Square passed = Square((src.getFile() + dst.getFile()) / 2, src.getRank());
+		Square rook = Square(dst.getFile() > src.getFile() ? FILE_H : FILE_A, src.getRank());
 
-	// Can capture a left diagonal piece?
-	if (file > FILE_A) {
-		ret |= Bitboard(Square(file - 1, rank + dir));
+		if (src.getFile() != FILE_E || src.getRank() != (own == WHITE ? RANK_1 : RANK_8) || !board.canCastle(dst))
+			return false;
+
+		if (board.getSquare(rook).getBits() != SquareState(own, ROOK).getBits())
+			return false;
+
+		// Squares between the king and the rook must be empty
+		for (int file = std::min<int>(src.getFile(), rook.getFile()) + 1; file < std::max<int>(src.getFile(), rook.getFile()); ++file) {
+			if (board.getSquare(file, src.getRank()).isOccupied())
+				return false;
+		}
+
+		if (getAttackers(board, src, allPieces, board.getPieces(opp)) || getAttackers(board, passed, allPieces, board.getPieces(opp)))
+			return false;
 	}
+	else {
+		Bitboard moves = getAvailableMoves(own, state.getPiece(), src, allPieces, ownPieces);
+
+		if (state.getPiece() == PAWN)
+			moves |= getPawnAttacks(own, src) & board.getEnPassantSquares();
 
-	// Can capture a right diagonal piece?
-	if (file < FILE_H) {
-		ret |= Bitboard(Square(file + 1, rank + dir));
+		if (!(moves & Bitboard(dst)))
+			return false;
+
+		// Promotion is required on the last rank, and only there
+		bool lastRank = dst.getRank() == (own == WHITE ? RANK_8 : RANK_1);
+		if (state.getPiece() == PAWN && lastRank != move.hasPromotion())
+			return false;
+
+		if (state.getPiece() != PAWN && move.hasPromotion())
+			return false;
 	}
 
-	return ret;
+	Board next = board;
+	next.movePiece(src, dst, move.getPromotion());
+
+	Bitboard king = next.getPieces(own, KING);
+	return !king || !getAttackers(next, king.findFirstSquare(), next.getPieces(), next.getPieces(opp));
+}
+
+inline Bitboard getPawnMoves(Color color, Square idx, Bitboard allPieces)
+{
+	if (color == WHITE)
+		return getPawnMoves<WHITE>(idx, allPieces);
+	else
+		return getPawnMoves<BLACK>(idx, allPieces);
+}
+
+template <Color C>
+inline Bitboard getPawnMoves(Square idx, Bitboard allPieces)
+{
+	Bitboard pawn(idx);
+	return getPawnPushes<C>(pawn, allPieces) | getPawnDoublePushes<C>(pawn, allPieces);
+}
+
+inline Bitboard getPawnAttacks(Color color, Square idx)
+{
+	if (color == WHITE)
+		return getPawnAttacks<WHITE>(idx);
+	else
+		return getPawnAttacks<BLACK>(idx);
+}
+
+template <Color C>
+inline Bitboard getPawnAttacks(Square idx)
+{
+	return getPawnAttacks<C>(Bitboard(idx));
 }
 
 inline Bitboard getRookMoves(Square idx, Bitboard allPieces)
@@ -189,9 +306,14 @@ inline Bitboard getRookMoves(Square idx, Bitboard allPieces)
 }
 
 inline Bitboard getKnightMoves(Square idx)
+{
+	return Bitboard(knightAttackTable[idx.getIndex()]);
+}
+
+inline Bitboard getKnightAttacks(Bitboard knights)
 {
 	Bitboard ret;
-	Bitboard pos(idx);
+	Bitboard pos = knights;
 
 	// Up 2, right 1
 	ret |= (pos << (8*2+1)) & ~Bitboard::file(FILE_A);
@@ -272,9 +394,14 @@ inline Bitboard getQueenMoves(Square idx, Bitboard allPieces)
 }
 
 inline Bitboard getKingMoves(Square idx)
+{
+	return Bitboard(kingAttackTable[idx.getIndex()]);
+}
+
+inline Bitboard getKingAttacks(Bitboard kings)
 {
 	Bitboard ret;
-	Bitboard pos(idx);
+	Bitboard pos = kings;
 
 	// Up
 	ret |= (pos << 8); // will truncate if we're at top rank
@@ -296,4 +423,35 @@ inline Bitboard getKingMoves(Square idx)
 	return ret;
 }
 
+template <Color C>
+inline Bitboard getPawnPushes(Bitboard pawns, Bitboard allPieces)
+{
+	return PawnTraits<C>::push(pawns) & ~allPieces;
+}
+
+template <Color C>
+inline Bitboard getPawnDoublePushes(Bitboard pawns, Bitboard allPieces)
+{
+	Bitboard single = getPawnPushes<C>(pawns & Bitboard::rank(PawnTraits<C>::doubleMoveRank), allPieces);
+	return PawnTraits<C>::push(single) & ~allPieces;
+}
+
+template <Color C>
+inline Bitboard getPawnAttacksWest(Bitboard pawns)
+{
+	return PawnTraits<C>::push(pawns & ~Bitboard::file(FILE_A)) >> 1;
+}
+
+template <Color C>
+inline Bitboard getPawnAttacksEast(Bitboard pawns)
+{
+	return PawnTraits<C>::push(pawns & ~Bitboard::file(FILE_H)) << 1;
+}
+
+template <Color C>
+inline Bitboard getPawnAttacks(Bitboard pawns)
+{
+	return getPawnAttacksWest<C>(pawns) | getPawnAttacksEast<C>(pawns);
+}
+
 } // namespace vimlock
@@ -0,0 +1,458 @@
+#include "Nnue.h"
+#include "Log.h"
+#include "Sliders.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define NNUE_AVX2 1
+#include <immintrin.h>
+#else
+#define NNUE_AVX2 0
+#endif
+
+namespace vimlock
+{
+
+static const char magic[8] = { 'V', 'N', 'N', 'U', 'E', 0, 0, 0 };
+constexpr uint32_t version = 1;
+
+/// Clipped activations are in range [0, activationMax].
+constexpr int activationMax = 127;
+
+/// Hidden layer sums are scaled down by this many bits before clipping.
+constexpr int hiddenShift = 6;
+
+/// Output is divided by this to get centipawns.
+constexpr int outputScale = 16;
+
+constexpr int inputDims = NNUE_HALF_DIMS * 2;
+
+/// Most pieces which can change on a single move, e.g. capturing promotion
+/// or en passant removes two and adds one.
+constexpr int maxChanged = 32;
+
+/// Add and subtract feature columns from `src`, storing the result to `dst`.
+static void applyFeaturesScalar(const int16_t *src, int16_t *dst, const int16_t *weights,
+		const int *added, int addedCount, const int *removed, int removedCount)
+{
+	std::memcpy(dst, src, sizeof(int16_t) * NNUE_HALF_DIMS);
+
+	for (int i = 0; i < addedCount; ++i) {
+		const int16_t *column = weights + added[i] * NNUE_HALF_DIMS;
+		for (int j = 0; j < NNUE_HALF_DIMS; ++j)
+			dst[j] = static_cast<int16_t>(dst[j] + column[j]);
+	}
+
+	for (int i = 0; i < removedCount; ++i) {
+		const int16_t *column = weights + removed[i] * NNUE_HALF_DIMS;
+		for (int j = 0; j < NNUE_HALF_DIMS; ++j)
+			dst[j] = static_cast<int16_t>(dst[j] - column[j]);
+	}
+}
+
+/// Clip accumulated features of both perspectives into network input, side to move first.
+static void clipInputScalar(const int16_t *own, const int16_t *opp, int16_t *ret)
+{
+	for (int i = 0; i < NNUE_HALF_DIMS; ++i) {
+		ret[i] = static_cast<int16_t>(std::min(std::max(static_cast<int>(own[i]), 0), activationMax));
+		ret[i + NNUE_HALF_DIMS] = static_cast<int16_t>(std::min(std::max(static_cast<int>(opp[i]), 0), activationMax));
+	}
+}
+
+/// Scale and clip hidden layer sum into activation.
+static int32_t activateHidden(int32_t sum)
+{
+	return std::min(std::max(sum >> hiddenShift, 0), activationMax);
+}
+
+#if NNUE_AVX2
+
+constexpr int lanes16 = 16;
+constexpr int registers = NNUE_HALF_DIMS / lanes16;
+
+static_assert(NNUE_HALF_DIMS % lanes16 == 0, "accumulator must fill whole registers");
+
+__attribute__((target("avx2")))
+static void applyFeaturesAvx2(const int16_t *src, int16_t *dst, const int16_t *weights,
+		const int *added, int addedCount, const int *removed, int removedCount)
+{
+	// Keep the whole accumulator in registers while applying the columns
+	__m256i acc[registers];
+
+	for (int j = 0; j < registers; ++j)
+		acc[j] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src) + j);
+
+	for (int i = 0; i < addedCount; ++i) {
+		const __m256i *column = reinterpret_cast<const __m256i *>(weights + added[i] * NNUE_HALF_DIMS);
+		for (int j = 0; j < registers; ++j)
+			acc[j] = _mm256_add_epi16(acc[j], _mm256_loadu_si256(column + j));
+	}
+
+	for (int i = 0; i < removedCount; ++i) {
+		const __m256i *column = reinterpret_cast<const __m256i *>(weights + removed[i] * NNUE_HALF_DIMS);
+		for (int j = 0; j < registers; ++j)
+			acc[j] = _mm256_sub_epi16(acc[j], _mm256_loadu_si256(column + j));
+	}
+
+	for (int j = 0; j < registers; ++j)
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst) + j, acc[j]);
+}
+
+__attribute__((target("avx2")))
+static void clipInputAvx2(const int16_t *own, const int16_t *opp, int16_t *ret)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i max = _mm256_set1_epi16(activationMax);
+
+	for (int j = 0; j < registers; ++j) {
+		__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(own) + j);
+		__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(opp) + j);
+
+		a = _mm256_min_epi16(_mm256_max_epi16(a, zero), max);
+		b = _mm256_min_epi16(_mm256_max_epi16(b, zero), max);
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(ret) + j, a);
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(ret + NNUE_HALF_DIMS) + j, b);
+	}
+}
+
+/// Dot product of 16-bit inputs and 8-bit weights. Products and their pairwise sums
+/// fit in 32 bits, so the result is exact and matches the scalar loop.
+__attribute__((target("avx2")))
+static int32_t dotAvx2(const int16_t *input, const int8_t *weights)
+{
+	__m256i sum = _mm256_setzero_si256();
+
+	for (int i = 0; i < inputDims; i += lanes16) {
+		__m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(input + i));
+		__m256i w = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(weights + i)));
+		sum = _mm256_add_epi32(sum, _mm256_madd_epi16(in, w));
+	}
+
+	__m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+	half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+	half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+
+	return _mm_cvtsi128_si32(half);
+}
+
+#else
+
+static void applyFeaturesAvx2(const int16_t *src, int16_t *dst, const int16_t *weights,
+		const int *added, int addedCount, const int *removed, int removedCount)
+{
+	assert(false && "AVX2 not supported");
+	applyFeaturesScalar(src, dst, weights, added, addedCount, removed, removedCount);
+}
+
+#endif
+
+Network::Network():
+	featureBiases(NNUE_HALF_DIMS),
+	featureWeights(static_cast<size_t>(NNUE_FEATURES) * NNUE_HALF_DIMS),
+	hiddenBiases(NNUE_HIDDEN),
+	hiddenWeights(NNUE_HIDDEN * inputDims),
+	outputBias(0),
+	outputWeights(NNUE_HIDDEN),
+	useAvx2(hasAvx2())
+{
+}
+
+template <typename T>
+static bool readValues(std::istream &stream, std::vector<T> &ret)
+{
+	return static_cast<bool>(stream.read(reinterpret_cast<char *>(ret.data()), ret.size() * sizeof(T)));
+}
+
+template <typename T>
+static bool readValue(std::istream &stream, T &ret)
+{
+	return static_cast<bool>(stream.read(reinterpret_cast<char *>(&ret), sizeof(T)));
+}
+
+template <typename T>
+static void writeValues(std::ostream &stream, const std::vector<T> &values)
+{
+	stream.write(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(T));
+}
+
+template <typename T>
+static void writeValue(std::ostream &stream, const T &value)
+{
+	stream.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+// NOTE: values are read and written in host byte order, which is little endian on supported CPUs.
+
+bool Network::load(const std::string &path)
+{
+	std::ifstream stream(path, std::ios::binary);
+	if (!stream) {
+		logError("Can't open network file: " + path);
+		return false;
+	}
+
+	char fileMagic[8];
+	uint32_t fileVersion, halfDims, hidden;
+
+	if (!stream.read(fileMagic, sizeof(fileMagic))
+			|| !readValue(stream, fileVersion)
+			|| !readValue(stream, halfDims)
+			|| !readValue(stream, hidden)) {
+		logError("Truncated network file: " + path);
+		return false;
+	}
+
+	if (std::memcmp(fileMagic, magic, sizeof(magic)) != 0 || fileVersion != version) {
+		logError("Not a supported network file: " + path);
+		return false;
+	}
+
+	if (halfDims != NNUE_HALF_DIMS || hidden != NNUE_HIDDEN) {
+		logError("Network architecture doesn't match: " + path);
+		return false;
+	}
+
+	Network tmp;
+
+	if (!readValues(stream, tmp.featureBiases)
+			|| !readValues(stream, tmp.featureWeights)
+			|| !readValues(stream, tmp.hiddenBiases)
+			|| !readValues(stream, tmp.hiddenWeights)
+			|| !readValue(stream, tmp.outputBias)
+			|| !readValues(stream, tmp.outputWeights)) {
+		logError("Truncated network file: " + path);
+		return false;
+	}
+
+	*this = std::move(tmp);
+
+	return true;
+}
+
+bool Network::save(const std::string &path) const
+{
+	std::ofstream stream(path, std::ios::binary);
+
+	stream.write(magic, sizeof(magic));
+	writeValue(stream, version);
+	writeValue(stream, static_cast<uint32_t>(NNUE_HALF_DIMS));
+	writeValue(stream, static_cast<uint32_t>(NNUE_HIDDEN));
+
+	writeValues(stream, featureBiases);
+	writeValues(stream, featureWeights);
+	writeValues(stream, hiddenBiases);
+	writeValues(stream, hiddenWeights);
+	writeValue(stream, outputBias);
+	writeValues(stream, outputWeights);
+
+	return static_cast<bool>(stream);
+}
+
+void Network::randomize(uint64_t seed)
+{
+	// SplitMix64
+	auto next = [&seed]() {
+		uint64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		return z ^ (z >> 31);
+	};
+
+	auto range = [&next](int lo, int hi) {
+		return lo + static_cast<int>(next() % static_cast<uint64_t>(hi - lo + 1));
+	};
+
+	for (int16_t &it : featureBiases)
+		it = static_cast<int16_t>(range(-64, 64));
+
+	for (int16_t &it : featureWeights)
+		it = static_cast<int16_t>(range(-32, 32));
+
+	for (int32_t &it : hiddenBiases)
+		it = range(-1000, 1000);
+
+	for (int8_t &it : hiddenWeights)
+		it = static_cast<int8_t>(range(-64, 63));
+
+	outputBias = range(-1000, 1000);
+
+	for (int8_t &it : outputWeights)
+		it = static_cast<int8_t>(range(-127, 127));
+}
+
+int Network::getFeature(Color perspective, Square king, Color color, Piece piece, Square square)
+{
+	// Mirror vertically for black
+	uint64_t orient = perspective == WHITE ? 0 : 56;
+
+	int k = static_cast<int>(king.getIndex() ^ orient);
+	int s = static_cast<int>(square.getIndex() ^ orient);
+	int p = pieceIndex(piece) + (color == perspective ? 0 : 5);
+
+	return (k * 10 + p) * 64 + s;
+}
+
+static const Piece featurePieces[] = { PAWN, ROOK, KNIGHT, BISHOP, QUEEN };
+
+void Network::refresh(const Board &board, Color perspective, Accumulator &ret) const
+{
+	int16_t *values = ret.values[colorIndex(perspective)];
+
+	Bitboard kingBits = board.getPieces(perspective, KING);
+	Square king = kingBits ? kingBits.findFirstSquare() : Square();
+
+	std::copy(featureBiases.begin(), featureBiases.end(), values);
+
+	int features[maxChanged];
+	int count = 0;
+
+	for (Color color : { WHITE, BLACK }) {
+		for (Piece piece : featurePieces) {
+			Bitboard pieces = board.getPieces(color, piece);
+
+			while (pieces) {
+				features[count++] = getFeature(perspective, king, color, piece, pieces.popFirstSquare());
+
+				// Apply in batches, the board may hold more pieces than the buffer
+				if (count == maxChanged) {
+					applyFeaturesScalar(values, values, featureWeights.data(), features, count, nullptr, 0);
+					count = 0;
+				}
+			}
+		}
+	}
+
+	applyFeaturesScalar(values, values, featureWeights.data(), features, count, nullptr, 0);
+}
+
+void Network::update(const Board &prev, const Board &next, const Accumulator &acc, Accumulator &ret) const
+{
+	if (useAvx2)
+		updateImpl<true>(prev, next, acc, ret);
+	else
+		updateImpl<false>(prev, next, acc, ret);
+}
+
+void Network::updateScalar(const Board &prev, const Board &next, const Accumulator &acc, Accumulator &ret) const
+{
+	updateImpl<false>(prev, next, acc, ret);
+}
+
+void Network::updateAvx2(const Board &prev, const Board &next, const Accumulator &acc, Accumulator &ret) const
+{
+	updateImpl<true>(prev, next, acc, ret);
+}
+
+template <bool avx2>
+void Network::updateImpl(const Board &prev, const Board &next, const Accumulator &acc, Accumulator &ret) const
+{
+	for (Color perspective : { WHITE, BLACK }) {
+		Bitboard kingBits = next.getPieces(perspective, KING);
+
+		// Every feature depends on the king square
+		if (kingBits != prev.getPieces(perspective, KING)) {
+			refresh(next, perspective, ret);
+			continue;
+		}
+
+		Square king = kingBits ? kingBits.findFirstSquare() : Square();
+
+		int added[maxChanged];
+		int removed[maxChanged];
+		int addedCount = 0;
+		int removedCount = 0;
+		bool overflow = false;
+
+		for (Color color : { WHITE, BLACK }) {
+			for (Piece piece : featurePieces) {
+				Bitboard before = prev.getPieces(color, piece);
+				Bitboard after = next.getPieces(color, piece);
+
+				Bitboard gone = before & ~after;
+				Bitboard came = after & ~before;
+
+				while (gone && removedCount < maxChanged)
+					removed[removedCount++] = getFeature(perspective, king, color, piece, gone.popFirstSquare());
+
+				while (came && addedCount < maxChanged)
+					added[addedCount++] = getFeature(perspective, king, color, piece, came.popFirstSquare());
+
+				if (gone || came)
+					overflow = true;
+			}
+		}
+
+		// Positions are not related by a single move, start over
+		if (overflow) {
+			refresh(next, perspective, ret);
+		}
+		else if (avx2) {
+			applyFeaturesAvx2(acc.values[colorIndex(perspective)], ret.values[colorIndex(perspective)],
+					featureWeights.data(), added, addedCount, removed, removedCount);
+		}
+		else {
+			applyFeaturesScalar(acc.values[colorIndex(perspective)], ret.values[colorIndex(perspective)],
+					featureWeights.data(), added, addedCount, removed, removedCount);
+		}
+	}
+}
+
+int Network::evaluate(const Accumulator &acc, Color current) const
+{
+	return useAvx2 ? evaluateAvx2(acc, current) : evaluateScalar(acc, current);
+}
+
+int Network::evaluateScalar(const Accumulator &acc, Color current) const
+{
+	int16_t input[inputDims];
+	clipInputScalar(acc.values[colorIndex(current)], acc.values[colorIndex(flipColor(current))], input);
+
+	int32_t output = outputBias;
+
+	for (int j = 0; j < NNUE_HIDDEN; ++j) {
+		const int8_t *weights = hiddenWeights.data() + j * inputDims;
+
+		int32_t sum = 0;
+		for (int i = 0; i < inputDims; ++i)
+			sum += input[i] * weights[i];
+
+		output += activateHidden(hiddenBiases[j] + sum) * outputWeights[j];
+	}
+
+	return output / outputScale;
+}
+
+#if NNUE_AVX2
+
+__attribute__((target("avx2")))
+int Network::evaluateAvx2(const Accumulator &acc, Color current) const
+{
+	alignas(32) int16_t input[inputDims];
+	clipInputAvx2(acc.values[colorIndex(current)], acc.values[colorIndex(flipColor(current))], input);
+
+	int32_t output = outputBias;
+
+	for (int j = 0; j < NNUE_HIDDEN; ++j) {
+		int32_t sum = dotAvx2(input, hiddenWeights.data() + j * inputDims);
+		output += activateHidden(hiddenBiases[j] + sum) * outputWeights[j];
+	}
+
+	return output / outputScale;
+}
+
+#else
+
+int Network::evaluateAvx2(const Accumulator &acc, Color current) const
+{
+	assert(false && "AVX2 not supported");
+	return evaluateScalar(acc, current);
+}
+
+#endif
+
+} // namespace vimlock
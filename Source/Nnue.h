@@ -0,0 +1,97 @@
+#pragma once
+#include "Board.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vimlock
+{
+
+/// Size of the feature transformer output for a single perspective.
+constexpr int NNUE_HALF_DIMS = 128;
+
+/// Number of neurons in the hidden layer.
+constexpr int NNUE_HIDDEN = 32;
+
+/// Number of input features per perspective:
+/// king square x 10 non-king pieces x piece square.
+constexpr int NNUE_FEATURES = 64 * 10 * 64;
+
+/// First pass of the network for both perspectives, indexed by `colorIndex()`.
+///
+/// Sum of the feature transformer columns of all active features. Depends only on the
+/// position, so it can be computed from the parent position by adding and removing
+/// the columns of pieces which moved.
+struct Accumulator
+{
+	int16_t values[2][NNUE_HALF_DIMS];
+};
+
+/// Efficiently updatable neural network evaluating a position.
+///
+/// Inputs are HalfKP features: for each perspective, every non-king piece combined with
+/// the square of the perspective's own king. Squares are mirrored vertically for black
+/// so that both perspectives share the weights. The accumulated features are clipped
+/// into [0, 127], side to move first, and fed through a hidden layer of `NNUE_HIDDEN`
+/// clipped neurons into a single output.
+///
+/// Weights are quantized, 16-bit for the feature transformer and 8-bit for the rest,
+/// so that the AVX2 kernels produce exactly the same results as the scalar ones.
+class Network
+{
+public:
+	/// Construct a network with all weights zero.
+	Network();
+
+	/// Load weights from a file, see `save()` for the format.
+	/// Returns false and leaves the network untouched if loading fails.
+	bool load(const std::string &path);
+
+	/// Save weights to a file.
+	///
+	/// The format is a header of the magic "VNNUE\0\0\0", 32-bit version, half dims and
+	/// hidden size, followed by the feature biases and weights as int16, hidden biases
+	/// as int32, hidden weights as int8, output bias as int32 and output weights as int8.
+	/// All values are little endian.
+	bool save(const std::string &path) const;
+
+	/// Fill weights with pseudo random values, for testing.
+	void randomize(uint64_t seed);
+
+	/// Compute accumulator of given perspective from scratch.
+	void refresh(const Board &board, Color perspective, Accumulator &ret) const;
+
+	/// Compute accumulator of `next` from accumulator of `prev`, adding and removing
+	/// only the features of the pieces which differ. A perspective whose king moved
+	/// is computed from scratch.
+	void update(const Board &prev, const Board &next, const Accumulator &acc, Accumulator &ret) const;
+
+	/// Return evaluation in centipawns from the perspective of `current`.
+	int evaluate(const Accumulator &acc, Color current) const;
+
+	/// Portable and AVX2 versions of `update()` and `evaluate()`.
+	/// AVX2 versions must be called only if `hasAvx2()` returns true.
+	void updateScalar(const Board &prev, const Board &next, const Accumulator &acc, Accumulator &ret) const;
+	void updateAvx2(const Board &prev, const Board &next, const Accumulator &acc, Accumulator &ret) const;
+	int evaluateScalar(const Accumulator &acc, Color current) const;
+	int evaluateAvx2(const Accumulator &acc, Color current) const;
+
+private:
+	/// Return index of the feature of a piece from given perspective.
+	static int getFeature(Color perspective, Square king, Color color, Piece piece, Square square);
+
+	template <bool avx2>
+	void updateImpl(const Board &prev, const Board &next, const Accumulator &acc, Accumulator &ret) const;
+
+	std::vector<int16_t> featureBiases;
+	std::vector<int16_t> featureWeights;
+	std::vector<int32_t> hiddenBiases;
+	std::vector<int8_t> hiddenWeights;
+	int32_t outputBias;
+	std::vector<int8_t> outputWeights;
+
+	bool useAvx2;
+};
+
+} // namespace vimlock
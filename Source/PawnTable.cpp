@@ -0,0 +1,167 @@
+#include "PawnTable.h"
+#include "Memory.h"
+#include "Moves.h"
+
+#include <cassert>
+
+namespace vimlock
+{
+
+constexpr size_t PawnTable::defaultEntries;
+
+// Pawn structure terms as midgame and endgame scores, in centipawns.
+constexpr Score doubledScore  = Score(-10, -20);
+constexpr Score isolatedScore = Score(-10, -15);
+constexpr Score backwardScore = Score(-8, -10);
+
+/// Bonus for a passed pawn by rank, counted from the owner's side of the board.
+/// Comes on top of the pawn piece-square tables.
+static const Score passedScores[8] = {
+	Score(0, 0), Score(5, 10), Score(5, 15), Score(10, 25),
+	Score(20, 40), Score(35, 65), Score(55, 100), Score(0, 0),
+};
+
+/// Squares on the files next to given file.
+static Bitboard adjacentFiles[8];
+
+/// Squares in front of a pawn on its own and adjacent files,
+/// indexed by `colorIndex()` and square.
+static Bitboard passedMasks[2][64];
+
+/// Squares on adjacent files on the same rank or behind a pawn,
+/// where own pawns could defend its advance. Indexed by `colorIndex()` and square.
+static Bitboard supportMasks[2][64];
+
+namespace
+{
+
+struct MaskInit
+{
+	MaskInit()
+	{
+		for (int file = FILE_A; file <= FILE_H; ++file) {
+			if (file > FILE_A)
+				adjacentFiles[file] |= Bitboard::file(file - 1);
+			if (file < FILE_H)
+				adjacentFiles[file] |= Bitboard::file(file + 1);
+		}
+
+		for (int rank = RANK_1; rank <= RANK_8; ++rank) {
+			for (int file = FILE_A; file <= FILE_H; ++file) {
+				uint64_t idx = Square(file, rank).getIndex();
+				Bitboard span = adjacentFiles[file] | Bitboard::file(file);
+
+				for (int other = RANK_1; other <= RANK_8; ++other) {
+					if (other > rank) {
+						passedMasks[colorIndex(WHITE)][idx] |= span & Bitboard::rank(other);
+						supportMasks[colorIndex(BLACK)][idx] |= adjacentFiles[file] & Bitboard::rank(other);
+					}
+					else if (other < rank) {
+						passedMasks[colorIndex(BLACK)][idx] |= span & Bitboard::rank(other);
+						supportMasks[colorIndex(WHITE)][idx] |= adjacentFiles[file] & Bitboard::rank(other);
+					}
+					else {
+						supportMasks[colorIndex(WHITE)][idx] |= adjacentFiles[file] & Bitboard::rank(other);
+						supportMasks[colorIndex(BLACK)][idx] |= adjacentFiles[file] & Bitboard::rank(other);
+					}
+				}
+			}
+		}
+	}
+};
+
+MaskInit init;
+
+} // anonymous namespace
+
+/// Evaluate pawn structure of color `C`, storing the result to `ret`.
+template <Color C>
+static void evaluatePawns(const Board &board, PawnEntry &ret)
+{
+	constexpr Color O = C == WHITE ? BLACK : WHITE;
+	constexpr int c = C == WHITE ? 0 : 1;
+
+	Bitboard ownPawns = board.getPieces(C, PAWN);
+	Bitboard oppPawns = board.getPieces(O, PAWN);
+	Bitboard oppAttacks = getPawnAttacks<O>(oppPawns);
+
+	Score score;
+	Bitboard passed;
+
+	for (int file = FILE_A; file <= FILE_H; ++file) {
+		int count = (ownPawns & Bitboard::file(file)).count();
+		if (count > 1)
+			score += doubledScore * (count - 1);
+	}
+
+	Bitboard pawns = ownPawns;
+
+	while (pawns) {
+		Square square = pawns.popFirstSquare();
+		uint64_t idx = square.getIndex();
+		int file = square.getFile();
+
+		Bitboard ahead = passedMasks[c][idx] & Bitboard::file(file);
+		Bitboard stop = PawnTraits<C>::push(Bitboard(square));
+
+		bool isolated = !(ownPawns & adjacentFiles[file]);
+
+		if (!(oppPawns & passedMasks[c][idx]) && !(ownPawns & ahead)) {
+			// Only the frontmost of doubled pawns counts as passed
+			int rank = C == WHITE ? square.getRank() : RANK_8 - square.getRank();
+			score += passedScores[rank];
+			passed |= Bitboard(square);
+		}
+
+		if (isolated) {
+			score += isolatedScore;
+		}
+		else if (!(ownPawns & supportMasks[c][idx]) && (oppAttacks & stop)) {
+			// Can't advance safely and no pawn can come to help
+			score += backwardScore;
+		}
+	}
+
+	ret.scores[c] = score;
+	ret.passed[c] = passed;
+}
+
+PawnTable::PawnTable(size_t count)
+{
+	assert(count > 0);
+
+	size_t size = roundDownToPowerOfTwo(count);
+
+	entries.resize(size);
+	mask = size - 1;
+
+	clear();
+}
+
+void PawnTable::clear()
+{
+	for (PawnEntry &it : entries)
+		it.valid = false;
+}
+
+const PawnEntry & PawnTable::probe(const Board &board)
+{
+	uint64_t key = board.getPawnKey();
+	PawnEntry &entry = entries[key & mask];
+
+	if (!entry.valid || entry.key != key) {
+		evaluate(board, entry);
+		entry.key = key;
+		entry.valid = true;
+	}
+
+	return entry;
+}
+
+void PawnTable::evaluate(const Board &board, PawnEntry &ret)
+{
+	evaluatePawns<WHITE>(board, ret);
+	evaluatePawns<BLACK>(board, ret);
+}
+
+} // namespace vimlock
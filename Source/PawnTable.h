@@ -0,0 +1,56 @@
+#pragma once
+#include "Board.h"
+#include "Score.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace vimlock
+{
+
+/// Pawn structure evaluation of a single position, depends only on placement of the pawns.
+struct PawnEntry
+{
+	/// Pawn key of the position, see `Board::getPawnKey()`.
+	uint64_t key;
+
+	/// Set once the entry holds an evaluated position.
+	bool valid;
+
+	/// Doubled, isolated, backward and passed pawn scores, indexed by `colorIndex()`.
+	Score scores[2];
+
+	/// Pawns with no opposing pawns in front of them or on adjacent files, indexed by `colorIndex()`.
+	Bitboard passed[2];
+};
+
+/// Pawn key indexed cache of pawn structure evaluations.
+///
+/// Pawns move rarely compared to other pieces, so nearly all lookups hit.
+/// Not thread safe, each searching thread should have its own table.
+class PawnTable
+{
+public:
+	/// Construct a table with given number of entries, rounded down to a power of two.
+	explicit PawnTable(size_t entries=defaultEntries);
+
+	/// Forget all stored entries.
+	void clear();
+
+	/// Return pawn structure evaluation of the board, evaluating it if not yet cached.
+	const PawnEntry & probe(const Board &board);
+
+	/// Evaluate pawn structure of the board without caching.
+	static void evaluate(const Board &board, PawnEntry &ret);
+
+	static constexpr size_t defaultEntries = 1 << 14;
+
+private:
+	std::vector<PawnEntry> entries;
+
+	/// Number of entries - 1, used for masking the key into an index.
+	uint64_t mask;
+};
+
+} // namespace vimlock
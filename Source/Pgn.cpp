@@ -0,0 +1,223 @@
+#include "Pgn.h"
+#include "Moves.h"
+
+#include <cctype>
+#include <istream>
+
+namespace vimlock
+{
+
+static bool parsePiece(char c, Piece &ret)
+{
+	switch (c) {
+		case 'N': ret = KNIGHT; return true;
+		case 'B': ret = BISHOP; return true;
+		case 'R': ret = ROOK; return true;
+		case 'Q': ret = QUEEN; return true;
+		case 'K': ret = KING; return true;
+	}
+
+	return false;
+}
+
+bool parseSan(const Board &board, const std::string &san, Move &ret)
+{
+	std::string str = san;
+
+	// Check, mate and annotation suffixes
+	while (!str.empty() && (str.back() == '+' || str.back() == '#' || str.back() == '!' || str.back() == '?'))
+		str.pop_back();
+
+	Color own = board.getCurrent();
+	int backRank = own == WHITE ? RANK_1 : RANK_8;
+
+	if (str == "O-O" || str == "0-0") {
+		ret = Move(Square(FILE_E, backRank), Square(FILE_G, backRank));
+		return isLegalMove(board, ret);
+	}
+
+	if (str == "O-O-O" || str == "0-0-0") {
+		ret = Move(Square(FILE_E, backRank), Square(FILE_C, backRank));
+		return isLegalMove(board, ret);
+	}
+
+	Piece promote = PAWN;
+
+	if (str.size() >= 2 && parsePiece(str.back(), promote)) {
+		str.pop_back();
+		if (str.back() == '=')
+			str.pop_back();
+
+		if (promote == KING)
+			return false;
+	}
+
+	Piece piece = PAWN;
+	size_t pos = 0;
+
+	if (!str.empty() && parsePiece(str[0], piece))
+		pos++;
+
+	if (str.size() < pos + 2)
+		return false;
+
+	char dstFile = str[str.size() - 2];
+	char dstRank = str[str.size() - 1];
+
+	if (dstFile < 'a' || dstFile > 'h' || dstRank < '1' || dstRank > '8')
+		return false;
+
+	Square dst = Square(dstFile - 'a', dstRank - '1');
+
+	// Disambiguation by file, rank or both
+	int srcFile = -1;
+	int srcRank = -1;
+
+	for (size_t i = pos; i < str.size() - 2; ++i) {
+		char c = str[i];
+
+		if (c >= 'a' && c <= 'h')
+			srcFile = c - 'a';
+		else if (c >= '1' && c <= '8')
+			srcRank = c - '1';
+		else if (c != 'x' && c != ':')
+			return false;
+	}
+
+	Bitboard candidates = board.getPieces(own, piece);
+	int found = 0;
+
+	while (candidates) {
+		Square src = candidates.popFirstSquare();
+
+		if (srcFile >= 0 && static_cast<int>(src.getFile()) != srcFile)
+			continue;
+		if (srcRank >= 0 && static_cast<int>(src.getRank()) != srcRank)
+			continue;
+
+		Move move(src, dst, promote);
+		if (!isLegalMove(board, move))
+			continue;
+
+		ret = move;
+		found++;
+	}
+
+	return found == 1;
+}
+
+PgnReader::PgnReader(std::istream &input_):
+	input(input_)
+{
+}
+
+bool PgnReader::addToken(const std::string &token, PgnGame &game)
+{
+	if (token == "1-0")
+		game.result = RESULT_WHITE_WINS;
+	else if (token == "0-1")
+		game.result = RESULT_BLACK_WINS;
+	else if (token == "1/2-1/2")
+		game.result = RESULT_DRAW;
+	else if (token == "*")
+		game.result = RESULT_UNKNOWN;
+	else {
+		// Move numbers such as "12." or "12...", possibly followed by the move
+		size_t pos = 0;
+		while (pos < token.size() && isdigit(static_cast<unsigned char>(token[pos])))
+			pos++;
+
+		if (pos > 0 && pos < token.size() && token[pos] == '.') {
+			while (pos < token.size() && token[pos] == '.')
+				pos++;
+		}
+		else {
+			pos = 0;
+		}
+
+		// Numeric annotation glyphs
+		if (pos < token.size() && token[pos] != '$')
+			game.moves.push_back(token.substr(pos));
+
+		return false;
+	}
+
+	return true;
+}
+
+bool PgnReader::readGame(PgnGame &ret)
+{
+	ret.tags.clear();
+	ret.moves.clear();
+	ret.result = RESULT_UNKNOWN;
+
+	variationDepth = 0;
+	inComment = false;
+
+	bool started = false;
+	std::string line;
+
+	while (std::getline(input, line)) {
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+
+		// Escaped line
+		if (!inComment && !line.empty() && line[0] == '%')
+			continue;
+
+		if (!inComment && !line.empty() && line[0] == '[') {
+			// Tag pair: [Name "Value"]
+			size_t space = line.find(' ');
+			size_t open = line.find('"');
+			size_t close = line.rfind('"');
+
+			if (space != std::string::npos && open != std::string::npos && close > open)
+				ret.tags[line.substr(1, space - 1)] = line.substr(open + 1, close - open - 1);
+
+			started = true;
+			continue;
+		}
+
+		std::string token;
+
+		for (size_t i = 0; i <= line.size(); ++i) {
+			char c = i < line.size() ? line[i] : ' ';
+
+			if (inComment) {
+				if (c == '}')
+					inComment = false;
+				continue;
+			}
+
+			bool separator = isspace(static_cast<unsigned char>(c)) || c == '{' || c == '(' || c == ')' || c == ';';
+
+			if (!separator) {
+				token += c;
+				continue;
+			}
+
+			if (!token.empty()) {
+				started = true;
+
+				if (variationDepth == 0 && addToken(token, ret))
+					return true;
+
+				token.clear();
+			}
+
+			if (c == '{')
+				inComment = true;
+			else if (c == '(')
+				variationDepth++;
+			else if (c == ')' && variationDepth > 0)
+				variationDepth--;
+			else if (c == ';')
+				break;
+		}
+	}
+
+	// Game without a result at the end of the file
+	return started;
+}
+
+} // namespace vimlock
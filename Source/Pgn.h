@@ -0,0 +1,61 @@
+#pragma once
+#include "Board.h"
+#include "Move.h"
+
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace vimlock
+{
+
+/// Parse a move in standard algebraic notation, e.g. "Nbd7", "exd5", "e8=Q+" or "O-O".
+/// Returns false if the move is malformed, ambiguous or not legal in the position.
+bool parseSan(const Board &board, const std::string &san, Move &ret);
+
+/// Outcome of a game.
+enum GameResult
+{
+	RESULT_UNKNOWN,
+	RESULT_WHITE_WINS,
+	RESULT_BLACK_WINS,
+	RESULT_DRAW
+};
+
+/// Single game of a PGN file, with moves still in algebraic notation.
+struct PgnGame
+{
+	/// Tag pairs such as "White" or "FEN".
+	std::map<std::string, std::string> tags;
+
+	/// Moves of the main line, comments, variations and annotations removed.
+	std::vector<std::string> moves;
+
+	GameResult result = RESULT_UNKNOWN;
+};
+
+/// Reads games from a PGN stream one at a time, so that files of any size can be
+/// processed without loading them into memory.
+class PgnReader
+{
+public:
+	explicit PgnReader(std::istream &input);
+
+	/// Read the next game. Returns false at the end of the stream.
+	bool readGame(PgnGame &ret);
+
+private:
+	/// Add a token of the movetext to the game. Returns true if it ended the game.
+	bool addToken(const std::string &token, PgnGame &game);
+
+	std::istream &input;
+
+	/// Nesting depth of variations being skipped.
+	int variationDepth = 0;
+
+	/// Set while inside a brace comment, which may span lines.
+	bool inComment = false;
+};
+
+} // namespace vimlock
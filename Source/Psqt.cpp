@@ -0,0 +1,151 @@
+#include "Psqt.h"
+
+namespace vimlock
+{
+
+Score Psqt::table[2][6][64];
+
+/// Material values in midgame and endgame, in `pieceIndex()` order.
+static const Score pieceScores[6] = {
+	Score(PAWN_VALUE,   120), // PAWN
+	Score(ROOK_VALUE,   530), // ROOK
+	Score(KNIGHT_VALUE, 300), // KNIGHT
+	Score(BISHOP_VALUE, 320), // BISHOP
+	Score(QUEEN_VALUE,  950), // QUEEN
+	Score(0,              0), // KING
+};
+
+// All tables are laid out from white's point of view with rank 8 on top.
+
+static const int pawnMidgame[64] = {
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	 50,  50,  50,  50,  50,  50,  50,  50,
+	 10,  10,  20,  30,  30,  20,  10,  10,
+	  5,   5,  10,  25,  25,  10,   5,   5,
+	  0,   0,   0,  20,  20,   0,   0,   0,
+	  5,  -5, -10,   0,   0, -10,  -5,   5,
+	  5,  10,  10, -20, -20,  10,  10,   5,
+	  0,   0,   0,   0,   0,   0,   0,   0,
+};
+
+// Advanced pawns are close to promotion
+static const int pawnEndgame[64] = {
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	 80,  80,  80,  80,  80,  80,  80,  80,
+	 50,  50,  50,  50,  50,  50,  50,  50,
+	 30,  30,  30,  30,  30,  30,  30,  30,
+	 20,  20,  20,  20,  20,  20,  20,  20,
+	 10,  10,  10,  10,  10,  10,  10,  10,
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	  0,   0,   0,   0,   0,   0,   0,   0,
+};
+
+static const int knightTable[64] = {
+	-50, -40, -30, -30, -30, -30, -40, -50,
+	-40, -20,   0,   0,   0,   0, -20, -40,
+	-30,   0,  10,  15,  15,  10,   0, -30,
+	-30,   5,  15,  20,  20,  15,   5, -30,
+	-30,   0,  15,  20,  20,  15,   0, -30,
+	-30,   5,  10,  15,  15,  10,   5, -30,
+	-40, -20,   0,   5,   5,   0, -20, -40,
+	-50, -40, -30, -30, -30, -30, -40, -50,
+};
+
+static const int bishopTable[64] = {
+	-20, -10, -10, -10, -10, -10, -10, -20,
+	-10,   0,   0,   0,   0,   0,   0, -10,
+	-10,   0,   5,  10,  10,   5,   0, -10,
+	-10,   5,   5,  10,  10,   5,   5, -10,
+	-10,   0,  10,  10,  10,  10,   0, -10,
+	-10,  10,  10,  10,  10,  10,  10, -10,
+	-10,   5,   0,   0,   0,   0,   5, -10,
+	-20, -10, -10, -10, -10, -10, -10, -20,
+};
+
+static const int rookTable[64] = {
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	  5,  10,  10,  10,  10,  10,  10,   5,
+	 -5,   0,   0,   0,   0,   0,   0,  -5,
+	 -5,   0,   0,   0,   0,   0,   0,  -5,
+	 -5,   0,   0,   0,   0,   0,   0,  -5,
+	 -5,   0,   0,   0,   0,   0,   0,  -5,
+	 -5,   0,   0,   0,   0,   0,   0,  -5,
+	  0,   0,   0,   5,   5,   0,   0,   0,
+};
+
+static const int queenTable[64] = {
+	-20, -10, -10,  -5,  -5, -10, -10, -20,
+	-10,   0,   0,   0,   0,   0,   0, -10,
+	-10,   0,   5,   5,   5,   5,   0, -10,
+	 -5,   0,   5,   5,   5,   5,   0,  -5,
+	  0,   0,   5,   5,   5,   5,   0,  -5,
+	-10,   5,   5,   5,   5,   5,   0, -10,
+	-10,   0,   5,   0,   0,   0,   0, -10,
+	-20, -10, -10,  -5,  -5, -10, -10, -20,
+};
+
+// Stay sheltered behind the pawns
+static const int kingMidgame[64] = {
+	-30, -40, -40, -50, -50, -40, -40, -30,
+	-30, -40, -40, -50, -50, -40, -40, -30,
+	-30, -40, -40, -50, -50, -40, -40, -30,
+	-30, -40, -40, -50, -50, -40, -40, -30,
+	-20, -30, -30, -40, -40, -30, -30, -20,
+	-10, -20, -20, -20, -20, -20, -20, -10,
+	 20,  20,   0,   0,   0,   0,  20,  20,
+	 20,  30,  10,   0,   0,  10,  30,  20,
+};
+
+// Take part in the fight once the board clears up
+static const int kingEndgame[64] = {
+	-50, -40, -30, -20, -20, -30, -40, -50,
+	-30, -20, -10,   0,   0, -10, -20, -30,
+	-30, -10,  20,  30,  30,  20, -10, -30,
+	-30, -10,  30,  40,  40,  30, -10, -30,
+	-30, -10,  30,  40,  40,  30, -10, -30,
+	-30, -10,  20,  30,  30,  20, -10, -30,
+	-30, -30,   0,   0,   0,   0, -30, -30,
+	-50, -30, -30, -30, -30, -30, -30, -50,
+};
+
+/// Midgame and endgame tables in `pieceIndex()` order.
+static const int *midgameTables[6] = {
+	pawnMidgame, rookTable, knightTable, bishopTable, queenTable, kingMidgame
+};
+
+static const int *endgameTables[6] = {
+	pawnEndgame, rookTable, knightTable, bishopTable, queenTable, kingEndgame
+};
+
+namespace
+{
+
+struct PsqtInit
+{
+	PsqtInit()
+	{
+		for (int p = 0; p < 6; ++p) {
+			for (int rank = RANK_1; rank <= RANK_8; ++rank) {
+				for (int file = FILE_A; file <= FILE_H; ++file) {
+					// Source tables have rank 8 on the first row
+					int white = (RANK_8 - rank) * 8 + file;
+					int black = rank * 8 + file;
+
+					uint64_t square = Square(file, rank).getIndex();
+
+					Psqt::table[colorIndex(WHITE)][p][square] = pieceScores[p]
+						+ Score(midgameTables[p][white], endgameTables[p][white]);
+
+					Psqt::table[colorIndex(BLACK)][p][square] = pieceScores[p]
+						+ Score(midgameTables[p][black], endgameTables[p][black]);
+				}
+			}
+		}
+	}
+};
+
+PsqtInit init;
+
+} // anonymous namespace
+
+} // namespace vimlock
@@ -0,0 +1,67 @@
+#pragma once
+#include "Enums.h"
+#include "Score.h"
+#include "Square.h"
+
+#include <cassert>
+
+namespace vimlock
+{
+
+/// Piece values in centipawns.
+constexpr int PAWN_VALUE   = 100;
+constexpr int ROOK_VALUE   = 500;
+constexpr int KNIGHT_VALUE = 320;
+constexpr int BISHOP_VALUE = 330;
+constexpr int QUEEN_VALUE  = 900;
+
+/// Game phase when all pieces except pawns and kings are on the board.
+/// Phase goes down to 0 as the pieces get traded.
+constexpr int MAX_PHASE = 24;
+
+/// Return raw material value of given piece.
+inline int getPieceValue(Piece piece)
+{
+	switch (piece) {
+		case PAWN:   return PAWN_VALUE;
+		case ROOK:   return ROOK_VALUE;
+		case KNIGHT: return KNIGHT_VALUE;
+		case BISHOP: return BISHOP_VALUE;
+		case QUEEN:  return QUEEN_VALUE;
+		case KING:   return 0; // Worth nothing, yet everything.
+	}
+
+	assert(false && "Should be unreachable");
+	return 0;
+}
+
+/// Return how much given piece contributes to the game phase.
+inline int getPhaseWeight(Piece piece)
+{
+	switch (piece) {
+		case KNIGHT: return 1;
+		case BISHOP: return 1;
+		case ROOK:   return 2;
+		case QUEEN:  return 4;
+		default:     return 0;
+	}
+}
+
+/// Piece-square tables, score given for a piece standing on a square.
+/// Includes the midgame and endgame material value of the piece.
+struct Psqt
+{
+	/// Return score for given piece on given square.
+	static Score get(Color color, Piece piece, Square square);
+
+	/// Scores indexed by color, piece type and square.
+	/// Tables for black are mirrored from white.
+	static Score table[2][6][64];
+};
+
+inline Score Psqt::get(Color color, Piece piece, Square square)
+{
+	return table[colorIndex(color)][pieceIndex(piece)][square.getIndex()];
+}
+
+} // namespace vimlock
@@ -0,0 +1,108 @@
+#pragma once
+#include <cstdint>
+
+namespace vimlock
+{
+
+/// Midgame and endgame evaluation packed into a single 32-bit integer.
+///
+/// Endgame value is stored in the upper 16 bits and midgame value in the lower 16 bits,
+/// which allows adding and subtracting both with a single instruction.
+/// Both values must stay within 16-bit signed range.
+class Score
+{
+public:
+	/// Construct a score with both values 0.
+	constexpr Score();
+
+	/// Construct a score with given midgame and endgame values.
+	constexpr Score(int mg, int eg);
+
+	/// Return midgame value.
+	constexpr int getMidgame() const;
+
+	/// Return endgame value.
+	constexpr int getEndgame() const;
+
+	/// Blend midgame and endgame values, `phase` going from 0 in pure endgame to `maxPhase` in midgame.
+	int taper(int phase, int maxPhase) const;
+
+	constexpr bool operator == (Score rhs) const { return bits == rhs.bits; }
+	constexpr bool operator != (Score rhs) const { return bits != rhs.bits; }
+
+	constexpr Score operator + (Score rhs) const;
+	constexpr Score operator - (Score rhs) const;
+	constexpr Score operator - () const;
+	constexpr Score operator * (int rhs) const;
+
+	Score& operator += (Score rhs);
+	Score& operator -= (Score rhs);
+
+private:
+	/// Construct from raw bits.
+	struct Raw {};
+	constexpr Score(Raw, int32_t bits_) : bits(bits_) {}
+
+	int32_t bits;
+};
+
+inline constexpr Score::Score():
+	bits(0)
+{
+}
+
+inline constexpr Score::Score(int mg, int eg):
+	bits(static_cast<int32_t>(static_cast<uint32_t>(eg) << 16) + mg)
+{
+}
+
+inline constexpr int Score::getMidgame() const
+{
+	return static_cast<int16_t>(static_cast<uint16_t>(static_cast<uint32_t>(bits)));
+}
+
+inline constexpr int Score::getEndgame() const
+{
+	// Rounding compensates for borrow from a negative midgame value
+	return static_cast<int16_t>(static_cast<uint16_t>((static_cast<uint32_t>(bits) + 0x8000) >> 16));
+}
+
+inline int Score::taper(int phase, int maxPhase) const
+{
+	if (phase > maxPhase)
+		phase = maxPhase;
+
+	return (getMidgame() * phase + getEndgame() * (maxPhase - phase)) / maxPhase;
+}
+
+inline constexpr Score Score::operator + (Score rhs) const
+{
+	return Score(Raw(), bits + rhs.bits);
+}
+
+inline constexpr Score Score::operator - (Score rhs) const
+{
+	return Score(Raw(), bits - rhs.bits);
+}
+
+inline constexpr Score Score::operator - () const
+{
+	return Score(Raw(), -bits);
+}
+
+inline constexpr Score Score::operator * (int rhs) const
+{
+	return Score(Raw(), bits * rhs);
+}
+
+inline Score& Score::operator += (Score rhs)
+{
+	return *this = *this + rhs;
+}
+
+inline Score& Score::operator -= (Score rhs)
+{
+	return *this = *this - rhs;
+}
+
+} // namespace vimlock
@@ -0,0 +1,162 @@
+#include "Sliders.h"
+
+#include <cassert>
+#include <cstdint>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define SLIDERS_AVX2 1
+#include <immintrin.h>
+#else
+#define SLIDERS_AVX2 0
+#endif
+
+namespace vimlock
+{
+
+constexpr uint64_t allSquares = ~0ULL;
+constexpr uint64_t notFileA = ~0x0101010101010101ULL;
+constexpr uint64_t notFileH = ~0x8080808080808080ULL;
+
+/// Shift left for positive amounts and right for negative.
+static inline uint64_t shiftBits(uint64_t bits, int amount)
+{
+	return amount > 0 ? bits << amount : bits >> -amount;
+}
+
+/// Kogge-Stone occluded fill to one direction.
+///
+/// Generators are propagated over empty squares in three steps doubling the distance
+/// each time, then shifted once more to include the blocking piece.
+/// `mask` clears bits which would wrap around to the other edge of the board.
+static inline uint64_t fillAttacks(uint64_t gen, uint64_t empty, int amount, uint64_t mask)
+{
+	uint64_t pro = empty & mask;
+
+	gen |= pro & shiftBits(gen, amount);
+	pro &= shiftBits(pro, amount);
+	gen |= pro & shiftBits(gen, amount * 2);
+	pro &= shiftBits(pro, amount * 2);
+	gen |= pro & shiftBits(gen, amount * 4);
+
+	return shiftBits(gen, amount) & mask;
+}
+
+Bitboard getSliderAttacksScalar(Bitboard orthogonal, Bitboard diagonal, Bitboard allPieces)
+{
+	uint64_t empty = ~allPieces.rawBits();
+	uint64_t rooks = orthogonal.rawBits();
+	uint64_t bishops = diagonal.rawBits();
+
+	uint64_t ret = 0;
+
+	// Up, down, right, left
+	ret |= fillAttacks(rooks, empty, 8, allSquares);
+	ret |= fillAttacks(rooks, empty, -8, allSquares);
+	ret |= fillAttacks(rooks, empty, 1, notFileA);
+	ret |= fillAttacks(rooks, empty, -1, notFileH);
+
+	// Up right, up left, down right, down left
+	ret |= fillAttacks(bishops, empty, 9, notFileA);
+	ret |= fillAttacks(bishops, empty, 7, notFileH);
+	ret |= fillAttacks(bishops, empty, -7, notFileA);
+	ret |= fillAttacks(bishops, empty, -9, notFileH);
+
+	return Bitboard(ret);
+}
+
+#if SLIDERS_AVX2
+
+/// Shift each lane by its own amount, lanes which shift to the other direction
+/// have a count of 64 which shifts all bits out.
+__attribute__((target("avx2")))
+static inline __m256i shiftLanes(__m256i bits, __m256i left, __m256i right)
+{
+	return _mm256_or_si256(_mm256_sllv_epi64(bits, left), _mm256_srlv_epi64(bits, right));
+}
+
+/// Same as `fillAttacks()` but for four directions at once, one per 64-bit lane.
+__attribute__((target("avx2")))
+static inline __m256i fillAttacks(__m256i gen, __m256i empty, __m256i left, __m256i right, __m256i mask)
+{
+	__m256i left2 = _mm256_add_epi64(left, left);
+	__m256i right2 = _mm256_add_epi64(right, right);
+	__m256i left4 = _mm256_add_epi64(left2, left2);
+	__m256i right4 = _mm256_add_epi64(right2, right2);
+
+	__m256i pro = _mm256_and_si256(empty, mask);
+
+	gen = _mm256_or_si256(gen, _mm256_and_si256(pro, shiftLanes(gen, left, right)));
+	pro = _mm256_and_si256(pro, shiftLanes(pro, left, right));
+	gen = _mm256_or_si256(gen, _mm256_and_si256(pro, shiftLanes(gen, left2, right2)));
+	pro = _mm256_and_si256(pro, shiftLanes(pro, left2, right2));
+	gen = _mm256_or_si256(gen, _mm256_and_si256(pro, shiftLanes(gen, left4, right4)));
+
+	return _mm256_and_si256(shiftLanes(gen, left, right), mask);
+}
+
+__attribute__((target("avx2")))
+Bitboard getSliderAttacksAvx2(Bitboard orthogonal, Bitboard diagonal, Bitboard allPieces)
+{
+	const __m256i empty = _mm256_set1_epi64x(static_cast<long long>(~allPieces.rawBits()));
+
+	// Lanes: up, down, right, left
+	const __m256i orthoLeft  = _mm256_setr_epi64x(8, 64, 1, 64);
+	const __m256i orthoRight = _mm256_setr_epi64x(64, 8, 64, 1);
+	const __m256i orthoMask  = _mm256_setr_epi64x(
+		static_cast<long long>(allSquares), static_cast<long long>(allSquares),
+		static_cast<long long>(notFileA), static_cast<long long>(notFileH));
+
+	// Lanes: up right, up left, down right, down left
+	const __m256i diagLeft  = _mm256_setr_epi64x(9, 7, 64, 64);
+	const __m256i diagRight = _mm256_setr_epi64x(64, 64, 7, 9);
+	const __m256i diagMask  = _mm256_setr_epi64x(
+		static_cast<long long>(notFileA), static_cast<long long>(notFileH),
+		static_cast<long long>(notFileA), static_cast<long long>(notFileH));
+
+	__m256i rooks = _mm256_set1_epi64x(static_cast<long long>(orthogonal.rawBits()));
+	__m256i bishops = _mm256_set1_epi64x(static_cast<long long>(diagonal.rawBits()));
+
+	__m256i attacks = _mm256_or_si256(
+		fillAttacks(rooks, empty, orthoLeft, orthoRight, orthoMask),
+		fillAttacks(bishops, empty, diagLeft, diagRight, diagMask));
+
+	// Combine the lanes
+	__m128i half = _mm_or_si128(_mm256_castsi256_si128(attacks), _mm256_extracti128_si256(attacks, 1));
+	uint64_t ret = static_cast<uint64_t>(_mm_cvtsi128_si64(half)) | static_cast<uint64_t>(_mm_extract_epi64(half, 1));
+
+	return Bitboard(ret);
+}
+
+bool hasAvx2()
+{
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+}
+
+#else
+
+Bitboard getSliderAttacksAvx2(Bitboard orthogonal, Bitboard diagonal, Bitboard allPieces)
+{
+	assert(false && "AVX2 not supported");
+	return getSliderAttacksScalar(orthogonal, diagonal, allPieces);
+}
+
+bool hasAvx2()
+{
+	return false;
+}
+
+#endif
+
+typedef Bitboard (*SliderAttacksFunc)(Bitboard, Bitboard, Bitboard);
+
+Bitboard getSliderAttacks(Bitboard orthogonal, Bitboard diagonal, Bitboard allPieces)
+{
+	// Chosen based on the CPU on the first call instead of during static initialization,
+	// as static initializers of other files may already need slider attacks
+	static const SliderAttacksFunc sliderAttacks = hasAvx2() ? getSliderAttacksAvx2 : getSliderAttacksScalar;
+
+	return sliderAttacks(orthogonal, diagonal, allPieces);
+}
+
+} // namespace vimlock
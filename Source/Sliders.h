@@ -0,0 +1,26 @@
+#pragma once
+#include "Bitboard.h"
+
+namespace vimlock
+{
+
+/// Return bitboard of all squares attacked by given sliding pieces.
+///
+/// Unlike `getRookMoves()` and `getBishopMoves()`, these compute the attacks of a whole
+/// set of pieces at once using Kogge-Stone occluded fills, which doesn't depend on number
+/// of pieces. Useful for computing attack maps of a whole side.
+///
+/// `orthogonal` should contain rooks and queens, `diagonal` bishops and queens.
+Bitboard getSliderAttacks(Bitboard orthogonal, Bitboard diagonal, Bitboard allPieces);
+
+/// Portable implementation of `getSliderAttacks()`, filling one direction at a time.
+Bitboard getSliderAttacksScalar(Bitboard orthogonal, Bitboard diagonal, Bitboard allPieces);
+
+/// AVX2 implementation of `getSliderAttacks()`, filling all eight directions in parallel.
+/// Must be called only if `hasAvx2()` returns true.
+Bitboard getSliderAttacksAvx2(Bitboard orthogonal, Bitboard diagonal, Bitboard allPieces);
+
+/// Returns true if the CPU supports AVX2 and it's compiled in.
+bool hasAvx2();
+
+} // namespace vimlock
@@ -0,0 +1,1310 @@
+#include "Syzygy.h"
+#include "Log.h"
+#include "Moves.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace vimlock
+{
+
+constexpr uint8_t wdlMagic[4] = { 0xD7, 0x66, 0x0C, 0xA5 };
+constexpr uint8_t dtzMagic[4] = { 0x71, 0xE8, 0x23, 0x5D };
+
+/// Flags of a single subtable.
+enum TableFlag
+{
+	/// Side to move stored in a DTZ table.
+	FLAG_STM          = 1,
+
+	/// DTZ values are mapped through a per-file table.
+	FLAG_MAPPED       = 2,
+
+	/// DTZ of wins and losses are stored in plies instead of moves.
+	FLAG_WIN_PLIES    = 4,
+	FLAG_LOSS_PLIES   = 8,
+
+	/// DTZ map has 16-bit values.
+	FLAG_WIDE         = 16,
+
+	/// All positions have the same value, stored instead of any compressed data.
+	FLAG_SINGLE_VALUE = 128
+};
+
+/// Maximum number of moves a player can choose from during a single turn.
+constexpr int maxMoves = 256;
+
+/// Bound of DTZ based ranks of root moves.
+constexpr int maxDtz = 1 << 18;
+
+/// Compressed values of a table, for one side to move and one file of the leading pawn.
+///
+/// Values are compressed by replacing frequent pairs of symbols with new symbols, and
+/// storing the result with canonical Huffman codes in blocks of fixed size.
+struct PairsData
+{
+	uint8_t flags = 0;
+
+	/// Bytes per block and number of values between entries of the sparse index.
+	uint64_t blockSize = 0;
+	uint64_t span = 0;
+
+	uint32_t blocksCount = 0;
+	int maxSymLen = 0;
+
+	/// Length of the shortest code, or the value if `FLAG_SINGLE_VALUE` is set.
+	int minSymLen = 0;
+
+	/// Lowest symbol of each code length, 16-bit little endian.
+	const uint8_t *lowestSym = nullptr;
+
+	/// Left and right symbols each pair symbol expands to, 12 bits each.
+	const uint8_t *tree = nullptr;
+
+	/// Lowest code of each length, left aligned to 64 bits.
+	std::vector<uint64_t> base64;
+
+	/// Number of values each symbol expands to, minus one.
+	std::vector<uint8_t> symLen;
+
+	/// Block and offset within the block of every `span`th value, 6 bytes each.
+	const uint8_t *sparseIndex = nullptr;
+	uint64_t sparseIndexSize = 0;
+
+	/// Number of values in each block minus one, 16-bit little endian.
+	const uint8_t *blockLength = nullptr;
+	uint64_t blockLengthSize = 0;
+
+	const uint8_t *data = nullptr;
+
+	/// Pieces in the order they are encoded, see `getCode()`.
+	int pieces[SYZYGY_MAX_PIECES] = {};
+
+	/// Number of pieces in each group and the multiplier of its index, zero terminated.
+	int groupLen[SYZYGY_MAX_PIECES + 1] = {};
+	uint64_t groupIdx[SYZYGY_MAX_PIECES + 1] = {};
+
+	/// Offsets into the DTZ map for each result.
+	uint16_t mapIdx[4] = {};
+};
+
+/// A single memory mapped file.
+struct TableFile
+{
+	TableFile() = default;
+	TableFile(const TableFile &) = delete;
+	TableFile & operator = (const TableFile &) = delete;
+
+	~TableFile()
+	{
+		if (map)
+			munmap(map, mapSize);
+	}
+
+	/// Set once mapping has been attempted, so that a missing file is not retried.
+	bool tried = false;
+
+	void *map = nullptr;
+	size_t mapSize = 0;
+
+	/// DTZ values of mapped subtables.
+	const uint8_t *dtzMap = nullptr;
+
+	/// Subtables indexed by side to move and file of the leading pawn.
+	PairsData items[2][4];
+};
+
+struct SyzygyTable
+{
+	/// Path of the files without extension.
+	std::string path;
+
+	/// Material key with the stronger side as white, which the table is stored for,
+	/// and with colors swapped. Same if both sides have the same pieces.
+	uint64_t key;
+	uint64_t key2;
+
+	int pieceCount;
+	bool hasPawns;
+
+	/// Set if either side has exactly one piece of some type other than king.
+	bool hasUniquePieces;
+
+	/// Pawns of the leading color, which has fewer pawns, and of the other color.
+	int pawnCount[2];
+
+	TableFile wdl;
+	TableFile dtz;
+};
+
+// Tables mapping piece placements to indices, see `IndexInit`.
+static int mapB1H1H7[64];
+static int mapA1D1D4[64];
+static int mapKK[10][64];
+static uint64_t binomial[SYZYGY_MAX_PIECES + 1][64];
+static int mapPawns[64];
+static int leadPawnIdx[SYZYGY_MAX_PIECES][64];
+static int leadPawnsSize[SYZYGY_MAX_PIECES][4];
+
+static int getRank(int square)
+{
+	return square >> 3;
+}
+
+static int getFile(int square)
+{
+	return square & 7;
+}
+
+/// Zero on the A1-H8 diagonal, negative below it and positive above.
+static int offDiagonal(int square)
+{
+	return getRank(square) - getFile(square);
+}
+
+/// Leading pawn is the one closest to the edge, and on the lowest rank of those.
+static bool comparePawns(int a, int b)
+{
+	return mapPawns[a] < mapPawns[b];
+}
+
+namespace
+{
+
+struct IndexInit
+{
+	IndexInit()
+	{
+		int code = 0;
+		for (int s = 0; s < 64; ++s) {
+			if (offDiagonal(s) < 0)
+				mapB1H1H7[s] = code++;
+		}
+
+		// Triangle A1-D1-D4, squares on the diagonal last
+		int diagonal[4];
+		int diagonalCount = 0;
+
+		code = 0;
+		for (int s = 0; s <= D4; ++s) {
+			if (offDiagonal(s) < 0 && getFile(s) <= FILE_D)
+				mapA1D1D4[s] = code++;
+			else if (offDiagonal(s) == 0 && getFile(s) <= FILE_D)
+				diagonal[diagonalCount++] = s;
+		}
+
+		for (int i = 0; i < diagonalCount; ++i)
+			mapA1D1D4[diagonal[i]] = code++;
+
+		// Kings not next to each other with the first one in the triangle. If the first
+		// one is on the diagonal, the second one must not be above it. Both on the
+		// diagonal last.
+		int bothOnDiagonal[64][2];
+		int bothOnDiagonalCount = 0;
+
+		code = 0;
+		for (int idx = 0; idx < 10; ++idx) {
+			for (int s1 = 0; s1 <= D4; ++s1) {
+				if (mapA1D1D4[s1] != idx || (idx == 0 && s1 != B1))
+					continue;
+
+				for (int s2 = 0; s2 < 64; ++s2) {
+					int distance = std::max(std::abs(getFile(s1) - getFile(s2)), std::abs(getRank(s1) - getRank(s2)));
+
+					if (distance <= 1)
+						continue;
+					else if (offDiagonal(s1) == 0 && offDiagonal(s2) > 0)
+						continue;
+					else if (offDiagonal(s1) == 0 && offDiagonal(s2) == 0) {
+						bothOnDiagonal[bothOnDiagonalCount][0] = idx;
+						bothOnDiagonal[bothOnDiagonalCount++][1] = s2;
+					}
+					else
+						mapKK[idx][s2] = code++;
+				}
+			}
+		}
+
+		for (int i = 0; i < bothOnDiagonalCount; ++i)
+			mapKK[bothOnDiagonal[i][0]][bothOnDiagonal[i][1]] = code++;
+
+		assert(code == 462);
+
+		binomial[0][0] = 1;
+		for (int n = 1; n < 64; ++n) {
+			for (int k = 0; k <= SYZYGY_MAX_PIECES && k <= n; ++k) {
+				binomial[k][n] = (k > 0 ? binomial[k - 1][n - 1] : 0)
+					+ (k < n ? binomial[k][n - 1] : 0);
+			}
+		}
+
+		// Squares A2-H7 get values 0-47, the highest being the leading pawn. Another
+		// pawn can be only on squares with lower values when the leading pawn is on
+		// given square, which is the number of squares available for them.
+		int available = 47;
+
+		for (int leadPawns = 1; leadPawns < SYZYGY_MAX_PIECES; ++leadPawns) {
+			for (int file = FILE_A; file <= FILE_D; ++file) {
+				int idx = 0;
+
+				for (int rank = RANK_2; rank <= RANK_7; ++rank) {
+					int square = rank * 8 + file;
+
+					if (leadPawns == 1) {
+						mapPawns[square] = available--;
+						mapPawns[square ^ 7] = available--;
+					}
+
+					leadPawnIdx[leadPawns][square] = idx;
+					idx += binomial[leadPawns - 1][mapPawns[square]];
+				}
+
+				leadPawnsSize[leadPawns][file] = idx;
+			}
+		}
+	}
+};
+
+IndexInit init;
+
+} // anonymous namespace
+
+static uint16_t readLe16(const uint8_t *p)
+{
+	return static_cast<uint16_t>(p[0] | p[1] << 8);
+}
+
+static uint32_t readLe32(const uint8_t *p)
+{
+	return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8
+		| static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+
+static uint32_t readBe32(const uint8_t *p)
+{
+	return static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16
+		| static_cast<uint32_t>(p[2]) << 8 | static_cast<uint32_t>(p[3]);
+}
+
+static uint64_t readBe64(const uint8_t *p)
+{
+	return static_cast<uint64_t>(readBe32(p)) << 32 | readBe32(p + 4);
+}
+
+static const uint8_t * alignTo(const uint8_t *p, uintptr_t alignment)
+{
+	uintptr_t address = reinterpret_cast<uintptr_t>(p);
+	return p + ((alignment - address % alignment) % alignment);
+}
+
+static int getLeftSymbol(const PairsData &d, int symbol)
+{
+	const uint8_t *p = d.tree + 3 * symbol;
+	return (p[1] & 0xF) << 8 | p[0];
+}
+
+static int getRightSymbol(const PairsData &d, int symbol)
+{
+	const uint8_t *p = d.tree + 3 * symbol;
+	return p[2] << 4 | p[1] >> 4;
+}
+
+/// Piece as stored in the tables: pawn to king are 1-6, black pieces have bit 3 set.
+static int getCode(Color color, Piece piece)
+{
+	int ret = 0;
+
+	switch (piece) {
+		case PAWN:   ret = 1; break;
+		case KNIGHT: ret = 2; break;
+		case BISHOP: ret = 3; break;
+		case ROOK:   ret = 4; break;
+		case QUEEN:  ret = 5; break;
+		case KING:   ret = 6; break;
+	}
+
+	return color == BLACK ? ret | 8 : ret;
+}
+
+static int getSign(int value)
+{
+	return (value > 0) - (value < 0);
+}
+
+/// Position is ranked as the fifty move counter is reset, when the DTZ is a capture or pawn move away.
+static int getDtzBeforeZeroing(Wdl wdl)
+{
+	switch (wdl) {
+		case WDL_WIN:          return 1;
+		case WDL_CURSED_WIN:   return 101;
+		case WDL_BLESSED_LOSS: return -101;
+		case WDL_LOSS:         return -1;
+		default:               return 0;
+	}
+}
+
+/// Parse material of a table from file name such as "KRPvKR", white having the pieces before 'v'.
+/// Pieces are placed on arbitrary squares, only the counts are valid.
+static bool parseTableName(const std::string &name, Board &ret)
+{
+	ret.clear();
+
+	Color color = WHITE;
+	uint64_t square = 0;
+	int kings = 0;
+
+	for (char c : name) {
+		Piece piece;
+
+		switch (c) {
+			case 'K': piece = KING; break;
+			case 'Q': piece = QUEEN; break;
+			case 'R': piece = ROOK; break;
+			case 'B': piece = BISHOP; break;
+			case 'N': piece = KNIGHT; break;
+			case 'P': piece = PAWN; break;
+			case 'v':
+				if (color == BLACK)
+					return false;
+
+				color = BLACK;
+				continue;
+			default:
+				return false;
+		}
+
+		if (square >= SYZYGY_MAX_PIECES)
+			return false;
+
+		if (piece == KING)
+			kings++;
+
+		ret.setSquare(Square(square++), color, piece);
+	}
+
+	return color == BLACK && kings == 2
+		&& ret.getPieces(WHITE, KING).count() == 1
+		&& ret.getPieces(BLACK, KING).count() == 1;
+}
+
+/// Split pieces of the table into groups and compute the index multipliers of each group.
+static void setGroups(const SyzygyTable &table, PairsData &d, const int order[2], int file)
+{
+	// Leading group is the pawns, or the first three unique pieces, or kings and a pair of pieces
+	int n = 0;
+	int firstLen = table.hasPawns ? 0 : table.hasUniquePieces ? 3 : 2;
+
+	d.groupLen[n] = 1;
+
+	for (int i = 1; i < table.pieceCount; ++i) {
+		if (--firstLen > 0 || d.pieces[i] == d.pieces[i - 1])
+			d.groupLen[n]++;
+		else
+			d.groupLen[++n] = 1;
+	}
+
+	d.groupLen[++n] = 0;
+
+	// The leading group is encoded at position order[0] and the remaining pawns at
+	// order[1], other groups fill the rest in order.
+	bool bothPawns = table.hasPawns && table.pawnCount[1];
+	int next = bothPawns ? 2 : 1;
+	int freeSquares = 64 - d.groupLen[0] - (bothPawns ? d.groupLen[1] : 0);
+	uint64_t idx = 1;
+
+	for (int k = 0; next < n || k == order[0] || k == order[1]; ++k) {
+		if (k == order[0]) {
+			d.groupIdx[0] = idx;
+			idx *= table.hasPawns ? leadPawnsSize[d.groupLen[0]][file]
+				: table.hasUniquePieces ? 31332 : 462;
+		}
+		else if (k == order[1]) {
+			d.groupIdx[1] = idx;
+			idx *= binomial[d.groupLen[1]][48 - d.groupLen[0]];
+		}
+		else {
+			d.groupIdx[next] = idx;
+			idx *= binomial[d.groupLen[next]][freeSquares];
+			freeSquares -= d.groupLen[next++];
+		}
+	}
+
+	d.groupIdx[n] = idx;
+}
+
+/// Compute number of values each symbol expands to.
+static int getSymLen(PairsData &d, int symbol, std::vector<bool> &visited)
+{
+	visited[symbol] = true;
+
+	int right = getRightSymbol(d, symbol);
+	if (right == 0xFFF)
+		return 0;
+
+	int left = getLeftSymbol(d, symbol);
+
+	if (!visited[left])
+		d.symLen[left] = getSymLen(d, left, visited);
+
+	if (!visited[right])
+		d.symLen[right] = getSymLen(d, right, visited);
+
+	return d.symLen[left] + d.symLen[right] + 1;
+}
+
+/// Read sizes and the code tables of a subtable, returns pointer past them.
+static const uint8_t * setSizes(PairsData &d, const uint8_t *data)
+{
+	d.flags = *data++;
+
+	if (d.flags & FLAG_SINGLE_VALUE) {
+		d.minSymLen = *data++;
+		return data;
+	}
+
+	int groups = 0;
+	while (d.groupLen[groups])
+		groups++;
+
+	uint64_t size = d.groupIdx[groups];
+
+	d.blockSize = 1ULL << *data++;
+	d.span = 1ULL << *data++;
+	d.sparseIndexSize = (size + d.span - 1) / d.span;
+
+	int padding = *data++;
+	d.blocksCount = readLe32(data);
+	data += 4;
+
+	// Padded so that the sparse index never points past the end
+	d.blockLengthSize = d.blocksCount + padding;
+
+	d.maxSymLen = *data++;
+	d.minSymLen = *data++;
+	d.lowestSym = data;
+
+	// Canonical codes are ordered so that longer codes have lower values, compute the
+	// lowest code of each length so that the length of a code can be found by comparing.
+	d.base64.assign(d.maxSymLen - d.minSymLen + 1, 0);
+
+	for (int i = static_cast<int>(d.base64.size()) - 2; i >= 0; --i) {
+		d.base64[i] = (d.base64[i + 1] + readLe16(d.lowestSym + 2 * i)
+			- readLe16(d.lowestSym + 2 * (i + 1))) / 2;
+	}
+
+	for (size_t i = 0; i < d.base64.size(); ++i)
+		d.base64[i] <<= 64 - i - d.minSymLen;
+
+	data += d.base64.size() * 2;
+
+	d.symLen.assign(readLe16(data), 0);
+	data += 2;
+	d.tree = data;
+
+	std::vector<bool> visited(d.symLen.size());
+
+	for (size_t symbol = 0; symbol < d.symLen.size(); ++symbol) {
+		if (!visited[symbol])
+			d.symLen[symbol] = getSymLen(d, symbol, visited);
+	}
+
+	return data + d.symLen.size() * 3 + (d.symLen.size() & 1);
+}
+
+/// Read offsets of the DTZ value maps, returns pointer past the maps.
+static const uint8_t * setDtzMap(TableFile &file, const uint8_t *data, int maxFile)
+{
+	file.dtzMap = data;
+
+	for (int f = FILE_A; f <= maxFile; ++f) {
+		PairsData &d = file.items[0][f];
+
+		if (!(d.flags & FLAG_MAPPED))
+			continue;
+
+		if (d.flags & FLAG_WIDE) {
+			data = alignTo(data, 2);
+
+			for (int i = 0; i < 4; ++i) {
+				d.mapIdx[i] = static_cast<uint16_t>((data - file.dtzMap) / 2 + 1);
+				data += 2 * readLe16(data) + 2;
+			}
+		}
+		else {
+			for (int i = 0; i < 4; ++i) {
+				d.mapIdx[i] = static_cast<uint16_t>(data - file.dtzMap + 1);
+				data += *data + 1;
+			}
+		}
+	}
+
+	return alignTo(data, 2);
+}
+
+/// Map file of the table and read its layout. Returns false if the file is missing or invalid.
+static bool mapTable(const SyzygyTable &table, TableFile &file, bool dtz)
+{
+	if (file.tried)
+		return file.map != nullptr;
+
+	file.tried = true;
+
+	std::string path = table.path + (dtz ? ".rtbz" : ".rtbw");
+
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size % 64 != 16) {
+		logError("Invalid tablebase file: " + path);
+		close(fd);
+		return false;
+	}
+
+	size_t size = st.st_size;
+	void *map = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (map == MAP_FAILED) {
+		logError("Failed to map tablebase file: " + path);
+		return false;
+	}
+
+	// Values are read in a random order
+	madvise(map, size, MADV_RANDOM);
+
+	const uint8_t *data = static_cast<const uint8_t *>(map);
+
+	if (memcmp(data, dtz ? dtzMagic : wdlMagic, 4) != 0
+			|| bool(data[4] & 2) != table.hasPawns
+			|| bool(data[4] & 1) != (!dtz && table.key != table.key2)) {
+		logError("Invalid tablebase file: " + path);
+		munmap(map, size);
+		return false;
+	}
+
+	file.map = map;
+	file.mapSize = size;
+
+	data += 5;
+
+	// WDL tables store both sides to move unless the sides are symmetric
+	int sides = !dtz && table.key != table.key2 ? 2 : 1;
+	int maxFile = table.hasPawns ? FILE_D : FILE_A;
+	bool bothPawns = table.hasPawns && table.pawnCount[1];
+
+	for (int f = FILE_A; f <= maxFile; ++f) {
+		int order[2][2] = {
+			{ data[0] & 0xF, bothPawns ? data[1] & 0xF : 0xF },
+			{ data[0] >> 4, bothPawns ? data[1] >> 4 : 0xF }
+		};
+
+		data += bothPawns ? 2 : 1;
+
+		for (int k = 0; k < table.pieceCount; ++k, ++data) {
+			for (int i = 0; i < sides; ++i)
+				file.items[i][f].pieces[k] = i ? *data >> 4 : *data & 0xF;
+		}
+
+		for (int i = 0; i < sides; ++i)
+			setGroups(table, file.items[i][f], order[i], f);
+	}
+
+	data = alignTo(data, 2);
+
+	for (int f = FILE_A; f <= maxFile; ++f) {
+		for (int i = 0; i < sides; ++i)
+			data = setSizes(file.items[i][f], data);
+	}
+
+	if (dtz)
+		data = setDtzMap(file, data, maxFile);
+
+	for (int f = FILE_A; f <= maxFile; ++f) {
+		for (int i = 0; i < sides; ++i) {
+			file.items[i][f].sparseIndex = data;
+			data += file.items[i][f].sparseIndexSize * 6;
+		}
+	}
+
+	for (int f = FILE_A; f <= maxFile; ++f) {
+		for (int i = 0; i < sides; ++i) {
+			file.items[i][f].blockLength = data;
+			data += file.items[i][f].blockLengthSize * 2;
+		}
+	}
+
+	for (int f = FILE_A; f <= maxFile; ++f) {
+		for (int i = 0; i < sides; ++i) {
+			data = alignTo(data, 64);
+			file.items[i][f].data = data;
+			data += file.items[i][f].blocksCount * file.items[i][f].blockSize;
+		}
+	}
+
+	return true;
+}
+
+/// Return value at given index of a subtable.
+static int decompressPairs(const PairsData &d, uint64_t idx)
+{
+	if (d.flags & FLAG_SINGLE_VALUE)
+		return d.minSymLen;
+
+	// Sparse index points to the block and offset of every `span`th value, starting
+	// from the middle of the span. Walk the blocks from there to the value.
+	uint64_t k = idx / d.span;
+	uint32_t block = readLe32(d.sparseIndex + 6 * k);
+	int offset = readLe16(d.sparseIndex + 6 * k + 4);
+
+	offset += static_cast<int>(idx % d.span) - static_cast<int>(d.span / 2);
+
+	while (offset < 0)
+		offset += readLe16(d.blockLength + 2 * --block) + 1;
+
+	while (offset > readLe16(d.blockLength + 2 * block))
+		offset -= readLe16(d.blockLength + 2 * block++) + 1;
+
+	// Decode symbols of the block until the one which contains the value
+	const uint8_t *ptr = d.data + block * d.blockSize;
+
+	uint64_t buffer = readBe64(ptr);
+	int bufferSize = 64;
+	ptr += 8;
+
+	int symbol;
+
+	while (true) {
+		int len = 0;
+		while (buffer < d.base64[len])
+			len++;
+
+		symbol = static_cast<int>((buffer - d.base64[len]) >> (64 - len - d.minSymLen));
+		symbol += readLe16(d.lowestSym + 2 * len);
+
+		if (offset < d.symLen[symbol] + 1)
+			break;
+
+		offset -= d.symLen[symbol] + 1;
+
+		len += d.minSymLen;
+		buffer <<= len;
+		bufferSize -= len;
+
+		if (bufferSize <= 32) {
+			bufferSize += 32;
+			buffer |= static_cast<uint64_t>(readBe32(ptr)) << (64 - bufferSize);
+			ptr += 4;
+		}
+	}
+
+	// Expand the pair symbol down to the value
+	while (d.symLen[symbol]) {
+		int left = getLeftSymbol(d, symbol);
+
+		if (offset < d.symLen[left] + 1) {
+			symbol = left;
+		}
+		else {
+			offset -= d.symLen[left] + 1;
+			symbol = getRightSymbol(d, symbol);
+		}
+	}
+
+	return getLeftSymbol(d, symbol);
+}
+
+/// Convert stored DTZ value into plies.
+static int mapDtz(const TableFile &file, int f, int value, Wdl wdl)
+{
+	constexpr int wdlMap[] = { 1, 3, 0, 2, 0 };
+
+	const PairsData &d = file.items[0][f];
+
+	if (d.flags & FLAG_MAPPED) {
+		int idx = d.mapIdx[wdlMap[wdl + 2]] + value;
+		value = (d.flags & FLAG_WIDE) ? readLe16(file.dtzMap + 2 * idx) : file.dtzMap[idx];
+	}
+
+	if ((wdl == WDL_WIN && !(d.flags & FLAG_WIN_PLIES))
+			|| (wdl == WDL_LOSS && !(d.flags & FLAG_LOSS_PLIES))
+			|| wdl == WDL_CURSED_WIN
+			|| wdl == WDL_BLESSED_LOSS)
+		value *= 2;
+
+	return value + 1;
+}
+
+static bool isInCheck(const Board &board)
+{
+	Color own = board.getCurrent();
+	Bitboard king = board.getPieces(own, KING);
+
+	return king && getAttackers(board, king.findFirstSquare(), board.getPieces(), board.getPieces(flipColor(own)));
+}
+
+static bool isZeroing(const Board &board, Move move)
+{
+	return board.getSquare(move.getSource()).getPiece() == PAWN
+		|| board.getSquare(move.getDestination()).isOccupied();
+}
+
+static bool isCapture(const Board &board, Move move)
+{
+	Square src = move.getSource();
+	Square dst = move.getDestination();
+
+	// Pawn moving diagonally is an en passant capture even if the square is empty
+	return board.getSquare(dst).isOccupied()
+		|| (board.getSquare(src).getPiece() == PAWN && src.getFile() != dst.getFile());
+}
+
+static void makeMove(Board &board, Move move)
+{
+	board.movePiece(move.getSource(), move.getDestination(), move.getPromotion());
+	board.flipCurrent();
+}
+
+/// Generate legal moves of the side to move, except castling as positions with castle
+/// rights are never probed. Returns number of moves stored in `ret`.
+static int getLegalMoves(const Board &board, Move *ret)
+{
+	Color own = board.getCurrent();
+	Color opp = flipColor(own);
+
+	Bitboard allPieces = board.getPieces();
+	Bitboard ownPieces = board.getPieces(own);
+	Bitboard enpassant = board.getEnPassantSquares() & Bitboard::rank(own == WHITE ? RANK_6 : RANK_3);
+	Bitboard promotionRank = Bitboard::rank(own == WHITE ? RANK_8 : RANK_1);
+
+	int count = 0;
+	Bitboard pieces = ownPieces;
+
+	while (pieces) {
+		Square src = pieces.popFirstSquare();
+		Piece piece = board.getSquare(src).getPiece();
+
+		Bitboard moves = getAvailableMoves(own, piece, src, allPieces, ownPieces);
+		if (piece == PAWN)
+			moves |= getPawnAttacks(own, src) & enpassant;
+
+		while (moves) {
+			Square dst = moves.popFirstSquare();
+
+			Board next = board;
+			next.movePiece(src, dst);
+
+			Bitboard king = next.getPieces(own, KING);
+			if (king && getAttackers(next, king.findFirstSquare(), next.getPieces(), next.getPieces(opp)))
+				continue;
+
+			if (piece == PAWN && (Bitboard(dst) & promotionRank)) {
+				for (Piece promote : { QUEEN, ROOK, BISHOP, KNIGHT })
+					ret[count++] = Move(src, dst, promote);
+			}
+			else {
+				ret[count++] = Move(src, dst);
+			}
+		}
+	}
+
+	return count;
+}
+
+Tablebases::Tablebases()
+{
+}
+
+Tablebases::~Tablebases()
+{
+}
+
+int Tablebases::setPath(const std::string &path)
+{
+	keys.clear();
+	tables.clear();
+	maxPieces = 0;
+
+	size_t start = 0;
+
+	while (start < path.size()) {
+		size_t end = path.find(':', start);
+		if (end == std::string::npos)
+			end = path.size();
+
+		std::string directory = path.substr(start, end - start);
+		start = end + 1;
+
+		DIR *dir = directory.empty() ? nullptr : opendir(directory.c_str());
+		if (!dir)
+			continue;
+
+		while (dirent *entry = readdir(dir)) {
+			std::string name = entry->d_name;
+			const std::string extension = ".rtbw";
+
+			if (name.size() <= extension.size() || name.compare(name.size() - extension.size(), extension.size(), extension) != 0)
+				continue;
+
+			name.resize(name.size() - extension.size());
+
+			Board white;
+			if (!parseTableName(name, white))
+				continue;
+
+			// Same table with colors swapped
+			size_t separator = name.find('v');
+			Board black;
+			parseTableName(name.substr(separator + 1) + "v" + name.substr(0, separator), black);
+
+			if (keys.count(white.getMaterialKey()))
+				continue;
+
+			std::unique_ptr<SyzygyTable> table(new SyzygyTable());
+			table->path = directory + "/" + name;
+			table->key = white.getMaterialKey();
+			table->key2 = black.getMaterialKey();
+			table->pieceCount = white.getPieces().count();
+			table->hasPawns = bool(white.getPieces(PAWN));
+			table->hasUniquePieces = false;
+
+			for (Color color : { WHITE, BLACK }) {
+				for (Piece piece : { PAWN, KNIGHT, BISHOP, ROOK, QUEEN }) {
+					if (white.getPieces(color, piece).count() == 1)
+						table->hasUniquePieces = true;
+				}
+			}
+
+			// Leading color has fewer pawns, as it compresses better
+			int whitePawns = white.getPieces(WHITE, PAWN).count();
+			int blackPawns = white.getPieces(BLACK, PAWN).count();
+			bool whiteLeads = blackPawns == 0 || (whitePawns > 0 && blackPawns >= whitePawns);
+
+			table->pawnCount[0] = whiteLeads ? whitePawns : blackPawns;
+			table->pawnCount[1] = whiteLeads ? blackPawns : whitePawns;
+
+			keys[table->key] = table.get();
+			keys[table->key2] = table.get();
+
+			maxPieces = std::max(maxPieces, table->pieceCount);
+			tables.push_back(std::move(table));
+		}
+
+		closedir(dir);
+	}
+
+	if (!tables.empty())
+		logInfo("Found " + std::to_string(tables.size()) + " tablebases, up to " + std::to_string(maxPieces) + " pieces");
+
+	return static_cast<int>(tables.size());
+}
+
+/// Returns true if castling is possible later in the game. Board keeps the rights of
+/// squares which no longer have the king or rook, those don't count.
+static bool hasCastleRights(const Board &board)
+{
+	SquareState whiteKing(WHITE, KING);
+	SquareState whiteRook(WHITE, ROOK);
+	SquareState blackKing(BLACK, KING);
+	SquareState blackRook(BLACK, ROOK);
+
+	auto has = [&board](Square square, SquareState state) {
+		return board.getSquare(square).getBits() == state.getBits();
+	};
+
+	return (board.canCastle(G1) && has(E1, whiteKing) && has(H1, whiteRook))
+		|| (board.canCastle(C1) && has(E1, whiteKing) && has(A1, whiteRook))
+		|| (board.canCastle(G8) && has(E8, blackKing) && has(H8, blackRook))
+		|| (board.canCastle(C8) && has(E8, blackKing) && has(A8, blackRook));
+}
+
+bool Tablebases::canProbe(const Board &board) const
+{
+	return board.getPieces().count() <= maxPieces && !hasCastleRights(board);
+}
+
+int Tablebases::probeTable(const Board &board, bool dtz, Wdl wdl, ProbeState &state)
+{
+	// Bare kings
+	if (board.getPieces().count() == 2)
+		return WDL_DRAW;
+
+	uint64_t key = board.getMaterialKey();
+
+	auto it = keys.find(key);
+	if (it == keys.end()) {
+		state = PROBE_FAIL;
+		return 0;
+	}
+
+	SyzygyTable &table = *it->second;
+	TableFile &file = dtz ? table.dtz : table.wdl;
+
+	if (!mapTable(table, file, dtz)) {
+		state = PROBE_FAIL;
+		return 0;
+	}
+
+	// Tables are stored with white as the stronger side, and only with white to move if
+	// both sides have the same pieces. Otherwise swap the colors and flip the board.
+	bool blackToMove = board.getCurrent() == BLACK;
+	bool flip = (table.key == table.key2 && blackToMove) || key != table.key;
+	int flipColor = flip ? 8 : 0;
+	int flipSquares = flip ? 56 : 0;
+	int stm = flip != blackToMove ? 1 : 0;
+
+	int squares[SYZYGY_MAX_PIECES];
+	int pieces[SYZYGY_MAX_PIECES];
+	int size = 0;
+	int leadPawnsCount = 0;
+	int tbFile = FILE_A;
+
+	Bitboard leadPawns;
+
+	// Tables with pawns are split by the file of the leading pawn, mirrored to files A-D
+	if (table.hasPawns) {
+		int code = file.items[0][0].pieces[0] ^ flipColor;
+		leadPawns = board.getPieces(code & 8 ? BLACK : WHITE, PAWN);
+
+		Bitboard b = leadPawns;
+		while (b)
+			squares[size++] = static_cast<int>(b.popFirstSquare().getIndex()) ^ flipSquares;
+
+		leadPawnsCount = size;
+
+		std::swap(squares[0], *std::max_element(squares, squares + leadPawnsCount, comparePawns));
+		tbFile = std::min(getFile(squares[0]), 7 - getFile(squares[0]));
+	}
+
+	if (dtz) {
+		const PairsData &d = file.items[0][tbFile];
+
+		if ((d.flags & FLAG_STM) != stm && !(table.key == table.key2 && !table.hasPawns)) {
+			state = PROBE_CHANGE_STM;
+			return 0;
+		}
+	}
+
+	Bitboard b = board.getPieces() & ~leadPawns;
+	while (b) {
+		Square square = b.popFirstSquare();
+		SquareState piece = board.getSquare(square);
+
+		squares[size] = static_cast<int>(square.getIndex()) ^ flipSquares;
+		pieces[size++] = getCode(piece.getColor(), piece.getPiece()) ^ flipColor;
+	}
+
+	const PairsData &d = file.items[dtz ? 0 : stm][tbFile];
+
+	// Same order of pieces as in the table
+	for (int i = leadPawnsCount; i < size - 1; ++i) {
+		for (int j = i + 1; j < size; ++j) {
+			if (d.pieces[i] == pieces[j]) {
+				std::swap(pieces[i], pieces[j]);
+				std::swap(squares[i], squares[j]);
+				break;
+			}
+		}
+	}
+
+	// Mirror the leading piece to files A-D
+	if (getFile(squares[0]) > FILE_D) {
+		for (int i = 0; i < size; ++i)
+			squares[i] ^= 7;
+	}
+
+	uint64_t idx;
+
+	if (table.hasPawns) {
+		idx = leadPawnIdx[leadPawnsCount][squares[0]];
+
+		std::stable_sort(squares + 1, squares + leadPawnsCount, comparePawns);
+
+		for (int i = 1; i < leadPawnsCount; ++i)
+			idx += binomial[i][mapPawns[squares[i]]];
+	}
+	else {
+		// Without pawns the leading piece can be mirrored to ranks 1-4, and below the
+		// A1-H8 diagonal, leaving the A1-D1-D4 triangle
+		if (getRank(squares[0]) > RANK_4) {
+			for (int i = 0; i < size; ++i)
+				squares[i] ^= 56;
+		}
+
+		for (int i = 0; i < d.groupLen[0]; ++i) {
+			if (!offDiagonal(squares[i]))
+				continue;
+
+			if (offDiagonal(squares[i]) > 0) {
+				for (int j = i; j < size; ++j)
+					squares[j] = ((squares[j] >> 3) | (squares[j] << 3)) & 63;
+			}
+
+			break;
+		}
+
+		if (table.hasUniquePieces) {
+			// Three unique pieces together, the rest of the pieces skip occupied squares
+			int adjust1 = squares[1] > squares[0];
+			int adjust2 = (squares[2] > squares[0]) + (squares[2] > squares[1]);
+
+			if (offDiagonal(squares[0])) {
+				idx = (mapA1D1D4[squares[0]] * 63 + (squares[1] - adjust1)) * 62 + squares[2] - adjust2;
+			}
+			else if (offDiagonal(squares[1])) {
+				idx = (6 * 63 + getRank(squares[0]) * 28 + mapB1H1H7[squares[1]]) * 62 + squares[2] - adjust2;
+			}
+			else if (offDiagonal(squares[2])) {
+				idx = 6 * 63 * 62 + 4 * 28 * 62
+					+ getRank(squares[0]) * 7 * 28
+					+ (getRank(squares[1]) - adjust1) * 28
+					+ mapB1H1H7[squares[2]];
+			}
+			else {
+				idx = 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28
+					+ getRank(squares[0]) * 7 * 6
+					+ (getRank(squares[1]) - adjust1) * 6
+					+ (getRank(squares[2]) - adjust2);
+			}
+		}
+		else {
+			idx = mapKK[mapA1D1D4[squares[0]]][squares[1]];
+		}
+	}
+
+	idx *= d.groupIdx[0];
+
+	// Remaining groups as combinations of squares not taken by the previous groups
+	int *groupSquares = squares + d.groupLen[0];
+	bool remainingPawns = table.hasPawns && table.pawnCount[1];
+
+	for (int next = 1; d.groupLen[next]; ++next) {
+		std::stable_sort(groupSquares, groupSquares + d.groupLen[next]);
+
+		uint64_t n = 0;
+
+		for (int i = 0; i < d.groupLen[next]; ++i) {
+			int adjust = 0;
+			for (int *it = squares; it != groupSquares; ++it)
+				adjust += groupSquares[i] > *it;
+
+			n += binomial[i + 1][groupSquares[i] - adjust - (remainingPawns ? 8 : 0)];
+		}
+
+		remainingPawns = false;
+		idx += n * d.groupIdx[next];
+		groupSquares += d.groupLen[next];
+	}
+
+	int value = decompressPairs(d, idx);
+
+	return dtz ? mapDtz(file, tbFile, value, wdl) : value - 2;
+}
+
+Wdl Tablebases::search(const Board &board, bool zeroing, ProbeState &state)
+{
+	Move moves[maxMoves];
+	int count = getLegalMoves(board, moves);
+	int searched = 0;
+
+	Wdl best = WDL_LOSS;
+
+	for (int i = 0; i < count; ++i) {
+		if (!isCapture(board, moves[i]) && (!zeroing || board.getSquare(moves[i].getSource()).getPiece() != PAWN))
+			continue;
+
+		searched++;
+
+		Board next = board;
+		makeMove(next, moves[i]);
+
+		Wdl value = static_cast<Wdl>(-search(next, false, state));
+
+		if (state == PROBE_FAIL)
+			return WDL_DRAW;
+
+		if (value > best) {
+			best = value;
+
+			if (value >= WDL_WIN) {
+				state = PROBE_ZEROING_BEST_MOVE;
+				return value;
+			}
+		}
+	}
+
+	// Table can't be trusted if all moves were searched, e.g. with en passant
+	bool allSearched = searched > 0 && searched == count;
+
+	Wdl value = best;
+
+	if (!allSearched) {
+		value = static_cast<Wdl>(probeTable(board, false, WDL_DRAW, state));
+
+		if (state == PROBE_FAIL)
+			return WDL_DRAW;
+	}
+
+	if (best >= value) {
+		state = best > WDL_DRAW || allSearched ? PROBE_ZEROING_BEST_MOVE : PROBE_OK;
+		return best;
+	}
+
+	state = PROBE_OK;
+	return value;
+}
+
+int Tablebases::probeDtz(const Board &board, ProbeState &state)
+{
+	state = PROBE_OK;
+
+	Wdl wdl = search(board, true, state);
+
+	// Draws are not stored
+	if (state == PROBE_FAIL || wdl == WDL_DRAW)
+		return 0;
+
+	if (state == PROBE_ZEROING_BEST_MOVE)
+		return getDtzBeforeZeroing(wdl);
+
+	int dtz = probeTable(board, true, wdl, state);
+
+	if (state == PROBE_FAIL)
+		return 0;
+
+	if (state != PROBE_CHANGE_STM)
+		return (dtz + (wdl == WDL_BLESSED_LOSS || wdl == WDL_CURSED_WIN ? 100 : 0)) * getSign(wdl);
+
+	// Table stores only the other side to move, search one ply for the best move
+	Move moves[maxMoves];
+	int count = getLegalMoves(board, moves);
+	int best = 0xFFFF;
+
+	for (int i = 0; i < count; ++i) {
+		bool zeroing = isZeroing(board, moves[i]);
+
+		Board next = board;
+		makeMove(next, moves[i]);
+
+		// Result of a zeroing move is counted from before the move
+		dtz = zeroing
+			? -getDtzBeforeZeroing(search(next, false, state))
+			: -probeDtz(next, state);
+
+		if (state == PROBE_FAIL)
+			return 0;
+
+		// Mate is the fastest way to win
+		Move replies[maxMoves];
+		if (dtz == 1 && isInCheck(next) && getLegalMoves(next, replies) == 0)
+			best = 1;
+
+		if (!zeroing)
+			dtz += getSign(dtz);
+
+		// Only moves keeping the result count
+		if (dtz < best && getSign(dtz) == getSign(wdl))
+			best = dtz;
+	}
+
+	// No legal moves, mated
+	return best == 0xFFFF ? -1 : best;
+}
+
+bool Tablebases::probeWdl(const Board &board, Wdl &ret)
+{
+	ProbeState state = PROBE_OK;
+	Wdl wdl = search(board, false, state);
+
+	if (state == PROBE_FAIL)
+		return false;
+
+	ret = wdl;
+	return true;
+}
+
+bool Tablebases::probeDtz(const Board &board, int &ret)
+{
+	ProbeState state = PROBE_OK;
+	int dtz = probeDtz(board, state);
+
+	if (state == PROBE_FAIL)
+		return false;
+
+	ret = dtz;
+	return true;
+}
+
+bool Tablebases::probeRoot(const Board &board, Move &best, Wdl &ret)
+{
+	Move moves[maxMoves];
+	int count = getLegalMoves(board, moves);
+
+	if (count == 0)
+		return false;
+
+	int bestRank = -maxDtz - 1;
+	int bestDtz = 0;
+	Move bestMove;
+
+	for (int i = 0; i < count; ++i) {
+		ProbeState state = PROBE_OK;
+
+		Board next = board;
+		makeMove(next, moves[i]);
+
+		// Distance to zeroing from the root, zeroing moves are one of -101, -1, 0, 1, 101
+		int dtz;
+
+		if (isZeroing(board, moves[i])) {
+			dtz = getDtzBeforeZeroing(static_cast<Wdl>(-search(next, false, state)));
+		}
+		else {
+			dtz = -probeDtz(next, state);
+			dtz += getSign(dtz);
+		}
+
+		if (state == PROBE_FAIL)
+			return false;
+
+		Move replies[maxMoves];
+		if (dtz == 2 && isInCheck(next) && getLegalMoves(next, replies) == 0)
+			dtz = 1;
+
+		// Win quickly and lose slowly
+		int rank = dtz > 0 ? maxDtz - dtz : dtz < 0 ? -maxDtz - dtz : 0;
+
+		// Prefer the given move among equals
+		if (rank > bestRank || (rank == bestRank && moves[i] == best)) {
+			bestRank = rank;
+			bestDtz = dtz;
+			bestMove = moves[i];
+		}
+	}
+
+	best = bestMove;
+
+	if (bestDtz > 100)
+		ret = WDL_CURSED_WIN;
+	else if (bestDtz > 0)
+		ret = WDL_WIN;
+	else if (bestDtz < -100)
+		ret = WDL_BLESSED_LOSS;
+	else if (bestDtz < 0)
+		ret = WDL_LOSS;
+	else
+		ret = WDL_DRAW;
+
+	return true;
+}
+
+} // namespace vimlock
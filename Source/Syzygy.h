@@ -0,0 +1,104 @@
+#pragma once
+#include "Board.h"
+#include "Move.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace vimlock
+{
+
+/// Game theoretical result of a position from the perspective of the side to move.
+/// Cursed wins and blessed losses are drawn because of the fifty move rule.
+enum Wdl
+{
+	WDL_LOSS         = -2,
+	WDL_BLESSED_LOSS = -1,
+	WDL_DRAW         = 0,
+	WDL_CURSED_WIN   = 1,
+	WDL_WIN          = 2
+};
+
+/// Largest number of pieces, kings included, in the tables which can be probed.
+constexpr int SYZYGY_MAX_PIECES = 6;
+
+struct SyzygyTable;
+
+/// Syzygy endgame tablebases, read from memory mapped `.rtbw` and `.rtbz` files.
+///
+/// WDL tables tell whether a position is won, drawn or lost and are probed during the
+/// search. DTZ tables tell the distance in plies to the next capture or pawn move along
+/// the best line, and are probed at the root to pick a move which makes progress.
+/// Files are found by `setPath()` but mapped only when first probed.
+///
+/// Positions with castle rights can't be probed. The fifty move counter is taken to be
+/// zero at the probed position.
+class Tablebases
+{
+public:
+	Tablebases();
+	~Tablebases();
+
+	/// Find tables in given directories, separated by ':'. Forgets the previously found
+	/// tables, empty path disables probing. Returns number of WDL tables found.
+	int setPath(const std::string &path);
+
+	/// Return number of pieces in the largest table found, zero if there are none.
+	int getMaxPieces() const { return maxPieces; }
+
+	/// Returns true if the position has few enough pieces and no castle rights.
+	bool canProbe(const Board &board) const;
+
+	/// Probe win, draw or loss of the position.
+	/// Returns false if a required table is missing.
+	bool probeWdl(const Board &board, Wdl &ret);
+
+	/// Probe distance in plies to the next capture or pawn move, positive if the side to
+	/// move wins, negative if it loses and zero if drawn.
+	/// Returns false if a required table is missing.
+	bool probeDtz(const Board &board, int &ret);
+
+	/// Check `best` move of the root position against the tablebases. Keeps it if no other
+	/// move is better, otherwise replaces it with the move keeping the best result: winning
+	/// closest to a capture or pawn move, or losing furthest from one. `ret` is the result
+	/// of the position when playing the chosen move.
+	/// Returns false and leaves `best` untouched if a required table is missing.
+	bool probeRoot(const Board &board, Move &best, Wdl &ret);
+
+private:
+	/// Progress of a probe, see `search()`.
+	enum ProbeState
+	{
+		PROBE_FAIL,
+		PROBE_OK,
+
+		/// DTZ table stores only the other side to move.
+		PROBE_CHANGE_STM,
+
+		/// Best move is a capture or pawn move, whose result the DTZ table doesn't store.
+		PROBE_ZEROING_BEST_MOVE
+	};
+
+	/// Probe a single table, returning WDL or DTZ of the position without looking at
+	/// any moves. For DTZ, `wdl` must be the result of the position.
+	int probeTable(const Board &board, bool dtz, Wdl wdl, ProbeState &state);
+
+	/// Result of the position taking captures, and pawn moves if `zeroing` is set, into account.
+	/// Tables store arbitrary values for positions where such a move is the best, as it
+	/// compresses better.
+	Wdl search(const Board &board, bool zeroing, ProbeState &state);
+
+	int probeDtz(const Board &board, ProbeState &state);
+
+	std::vector<std::unique_ptr<SyzygyTable>> tables;
+
+	/// Tables by material key of both colors, see `Board::getMaterialKey()`.
+	std::unordered_map<uint64_t, SyzygyTable *> keys;
+
+	int maxPieces = 0;
+};
+
+} // namespace vimlock
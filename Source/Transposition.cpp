@@ -0,0 +1,393 @@
+#include "Transposition.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace vimlock
+{
+
+constexpr size_t TranspositionTable::defaultEntries;
+
+static const Piece promotions[] = { PAWN, ROOK, KNIGHT, BISHOP, QUEEN };
+
+// Shared memory requires atomics which don't depend on a lock inside the process
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "64 bit atomics must be lock free");
+
+/// Number of distinct generations fitting into `TableEntry::generation`.
+constexpr uint8_t generationCount = 1 << 6;
+
+/// Identifies a shared memory segment holding a table.
+static const char sharedMagic[8] = { 'V', 'L', 'T', 'T', 'A', 'B', 'L', 'E' };
+
+/// Incremented whenever layout of the shared table changes.
+constexpr uint32_t sharedVersion = 2;
+
+/// Start of a shared memory segment, followed by the entries.
+struct SharedHeader
+{
+	char magic[8];
+	uint32_t version;
+
+	/// Size of a single entry in bytes.
+	uint32_t entrySize;
+
+	/// Number of entries, a power of two.
+	uint64_t entries;
+
+	/// Set by the process creating the segment once the header is written.
+	std::atomic<uint32_t> ready;
+
+	/// Current search of all processes using the table, see `TranspositionTable::newSearch()`.
+	std::atomic<uint32_t> generation;
+};
+
+/// Entries start at a cache line boundary after the header.
+constexpr size_t sharedHeaderSize = 64;
+
+static_assert(sizeof(SharedHeader) <= sharedHeaderSize, "header doesn't fit");
+
+/// How long to wait for another process to finish creating a segment.
+constexpr std::chrono::milliseconds sharedTimeout(1000);
+
+/// Shared memory names start with a slash.
+static std::string getSharedName(const std::string &name)
+{
+	return name.empty() || name[0] != '/' ? "/" + name : name;
+}
+
+TranspositionTable::TranspositionTable(size_t count)
+{
+	bool allocated = resize(count);
+	assert(allocated && "can't allocate transposition table");
+	(void)allocated;
+}
+
+TranspositionTable::~TranspositionTable()
+{
+	unmapShared();
+}
+
+bool TranspositionTable::resize(size_t count, int threads)
+{
+	assert(count > 0);
+
+	size_t size = roundDownToPowerOfTwo(count);
+
+	// All zero bits is an empty entry
+	if (!memory.allocate(size * sizeof(Slot), threads))
+		return false;
+
+	unmapShared();
+
+	slots = static_cast<Slot *>(memory.getData());
+	mask = size - 1;
+	ownGeneration.store(0, std::memory_order_relaxed);
+
+	return true;
+}
+
+bool TranspositionTable::resizeMegabytes(size_t megabytes, int threads)
+{
+	static_assert(sizeof(Slot) == entryBytes, "Entry size doesn't match the slots");
+
+	return resize(std::max<size_t>(megabytes * 1024 * 1024 / entryBytes, 1), threads);
+}
+
+bool TranspositionTable::attach(const std::string &name_, size_t count)
+{
+	std::string name = getSharedName(name_);
+
+	// Whoever creates the segment initializes it, others wait until it's done
+	int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+	bool created = fd >= 0;
+
+	if (!created && errno == EEXIST)
+		fd = shm_open(name.c_str(), O_RDWR, 0);
+
+	if (fd < 0) {
+		logError("Can't open shared memory: " + name);
+		return false;
+	}
+
+	bool ret = mapShared(fd, created, count, name);
+	close(fd);
+
+	if (!ret && created)
+		shm_unlink(name.c_str());
+
+#ifdef MADV_HUGEPAGE
+	if (ret)
+		madvise(sharedMap, sharedSize, MADV_HUGEPAGE);
+#endif
+
+	return ret;
+}
+
+bool TranspositionTable::openFile(const std::string &path, size_t count)
+{
+	int fd = open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+	bool created = fd >= 0;
+
+	if (!created && errno == EEXIST)
+		fd = open(path.c_str(), O_RDWR);
+
+	if (fd < 0) {
+		logError("Can't open table file: " + path);
+		return false;
+	}
+
+	bool ret = mapShared(fd, created, count, path);
+	close(fd);
+
+	if (!ret && created)
+		remove(path.c_str());
+
+	// Entries are accessed at random, reading ahead would only waste memory
+	if (ret)
+		madvise(sharedMap, sharedSize, MADV_RANDOM);
+
+	return ret;
+}
+
+bool TranspositionTable::mapShared(int fd, bool created, size_t count, const std::string &name)
+{
+	assert(count > 0);
+
+	size_t size = roundDownToPowerOfTwo(count);
+
+	auto deadline = std::chrono::steady_clock::now() + sharedTimeout;
+	size_t mapSize = sharedHeaderSize + size * sizeof(Slot);
+
+	if (created) {
+		// New space is zeroed, which is an empty table
+		if (ftruncate(fd, mapSize) != 0) {
+			logError("Can't resize table: " + name);
+			return false;
+		}
+	}
+	else {
+		struct stat st;
+		st.st_size = 0;
+
+		while (fstat(fd, &st) == 0
+				&& static_cast<size_t>(st.st_size) < sharedHeaderSize
+				&& std::chrono::steady_clock::now() <= deadline)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+		mapSize = static_cast<size_t>(st.st_size);
+	}
+
+	void *map = mapSize >= sharedHeaderSize
+		? mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+		: MAP_FAILED;
+
+	if (map == MAP_FAILED) {
+		logError("Can't map table: " + name);
+		return false;
+	}
+
+	SharedHeader *header = static_cast<SharedHeader *>(map);
+
+	if (created) {
+		memcpy(header->magic, sharedMagic, sizeof(sharedMagic));
+		header->version = sharedVersion;
+		header->entrySize = sizeof(Slot);
+		header->entries = size;
+		header->generation.store(0, std::memory_order_relaxed);
+		header->ready.store(1, std::memory_order_release);
+	}
+	else {
+		while (!header->ready.load(std::memory_order_acquire) && std::chrono::steady_clock::now() <= deadline)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+		size = header->entries;
+
+		bool valid = header->ready.load(std::memory_order_acquire)
+			&& memcmp(header->magic, sharedMagic, sizeof(sharedMagic)) == 0
+			&& header->version == sharedVersion
+			&& header->entrySize == sizeof(Slot)
+			&& size > 0
+			&& (size & (size - 1)) == 0
+			&& mapSize == sharedHeaderSize + size * sizeof(Slot);
+
+		if (!valid) {
+			logError("Incompatible table: " + name);
+			munmap(map, mapSize);
+			return false;
+		}
+	}
+
+	unmapShared();
+	memory.release();
+
+	sharedMap = map;
+	sharedSize = mapSize;
+	slots = reinterpret_cast<Slot *>(static_cast<char *>(map) + sharedHeaderSize);
+	mask = size - 1;
+	generation = &header->generation;
+
+	logInfo("Using table of " + std::to_string(size) + " entries: " + name);
+
+	return true;
+}
+
+bool TranspositionTable::removeShared(const std::string &name)
+{
+	return shm_unlink(getSharedName(name).c_str()) == 0;
+}
+
+void TranspositionTable::unmapShared()
+{
+	if (sharedMap)
+		munmap(sharedMap, sharedSize);
+
+	sharedMap = nullptr;
+	sharedSize = 0;
+	generation = &ownGeneration;
+}
+
+void TranspositionTable::clear(int threads)
+{
+	// All zero bits is an empty entry
+	if (sharedMap) {
+		for (uint64_t i = 0; i <= mask; ++i) {
+			slots[i].check.store(0, std::memory_order_relaxed);
+			slots[i].data.store(0, std::memory_order_relaxed);
+		}
+	}
+	else {
+		memory.clear(threads);
+	}
+
+	generation->store(0, std::memory_order_relaxed);
+}
+
+void TranspositionTable::newSearch()
+{
+	generation->fetch_add(1, std::memory_order_relaxed);
+}
+
+uint8_t TranspositionTable::getGeneration() const
+{
+	return generation->load(std::memory_order_relaxed) % generationCount;
+}
+
+int TranspositionTable::getHashfull() const
+{
+	size_t count = std::min<size_t>(getSize(), 1000);
+	size_t used = 0;
+	uint8_t current = getGeneration();
+
+	for (size_t i = 0; i < count; ++i) {
+		TableEntry entry = unpackData(0, slots[i].data.load(std::memory_order_relaxed));
+
+		if (entry.bound != BOUND_NONE && entry.generation == current)
+			used++;
+	}
+
+	return static_cast<int>(used * 1000 / count);
+}
+
+uint64_t TranspositionTable::packData(const TableEntry &entry)
+{
+	return static_cast<uint64_t>(static_cast<uint32_t>(entry.eval))
+		| static_cast<uint64_t>(entry.move) << 32
+		| static_cast<uint64_t>(static_cast<uint8_t>(entry.depth)) << 48
+		| static_cast<uint64_t>(entry.bound) << 56
+		| static_cast<uint64_t>(entry.generation) << 58;
+}
+
+TableEntry TranspositionTable::unpackData(uint64_t key, uint64_t data)
+{
+	TableEntry ret;
+	ret.key = key;
+	ret.eval = static_cast<int32_t>(static_cast<uint32_t>(data));
+	ret.move = static_cast<uint16_t>(data >> 32);
+	ret.depth = static_cast<int8_t>(static_cast<uint8_t>(data >> 48));
+	ret.bound = (data >> 56) & 0x3;
+	ret.generation = (data >> 58) & 0x3F;
+
+	return ret;
+}
+
+bool TranspositionTable::probe(uint64_t key, TableEntry &ret) const
+{
+	const Slot &slot = slots[key & mask];
+
+	uint64_t data = slot.data.load(std::memory_order_relaxed);
+	uint64_t check = slot.check.load(std::memory_order_relaxed);
+
+	// Either a different position or the halves come from different writes
+	if ((check ^ data) != key)
+		return false;
+
+	TableEntry entry = unpackData(key, data);
+	if (entry.bound == BOUND_NONE)
+		return false;
+
+	ret = entry;
+	return true;
+}
+
+void TranspositionTable::store(uint64_t key, Move move, int eval, int depth, Bound bound)
+{
+	Slot &slot = slots[key & mask];
+
+	uint64_t oldData = slot.data.load(std::memory_order_relaxed);
+	uint64_t oldKey = slot.check.load(std::memory_order_relaxed) ^ oldData;
+	TableEntry old = unpackData(oldKey, oldData);
+	uint8_t current = getGeneration();
+
+	// Prefer keeping deeper results, of other positions only if they're from the current
+	// search. Deeper results of the same position are still valid whichever search stored them.
+	if (old.bound != BOUND_NONE && old.depth > depth && (old.key == key || old.generation == current))
+		return;
+
+	TableEntry entry;
+	entry.key = key;
+	entry.eval = eval;
+	entry.move = packMove(move);
+	entry.depth = static_cast<int8_t>(depth);
+	entry.bound = static_cast<uint8_t>(bound);
+	entry.generation = current;
+
+	uint64_t data = packData(entry);
+
+	slot.check.store(key ^ data, std::memory_order_relaxed);
+	slot.data.store(data, std::memory_order_relaxed);
+}
+
+uint16_t TranspositionTable::packMove(Move move)
+{
+	uint16_t promote = 0;
+	for (uint16_t i = 0; i < 5; ++i) {
+		if (promotions[i] == move.getPromotion())
+			promote = i;
+	}
+
+	return static_cast<uint16_t>(move.getSource().getIndex())
+		| static_cast<uint16_t>(move.getDestination().getIndex() << 6)
+		| static_cast<uint16_t>(promote << 12);
+}
+
+Move TranspositionTable::unpackMove(uint16_t bits)
+{
+	uint64_t src = bits & 0x3F;
+	uint64_t dst = (bits >> 6) & 0x3F;
+	int promote = (bits >> 12) & 0x7;
+
+	return Move(Square(src), Square(dst), promote < 5 ? promotions[promote] : PAWN);
+}
+
+} // namespace vimlock
@@ -0,0 +1,166 @@
+#pragma once
+#include "Memory.h"
+#include "Move.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace vimlock
+{
+
+/// Describes how the stored evaluation relates to the real value of the position.
+enum Bound
+{
+	BOUND_NONE  = 0,
+
+	/// Real value is at most the stored evaluation, search failed low.
+	BOUND_UPPER = 1,
+
+	/// Real value is at least the stored evaluation, search failed high.
+	BOUND_LOWER = 2,
+
+	/// Stored evaluation is the real value.
+	BOUND_EXACT = BOUND_UPPER | BOUND_LOWER
+};
+
+/// Search result remembered for a single position.
+struct TableEntry
+{
+	/// Zobrist key of the position.
+	uint64_t key;
+
+	/// Evaluation from the perspective of the side to move.
+	int32_t eval;
+
+	/// Best move found, packed with `TranspositionTable::packMove()`.
+	uint16_t move;
+
+	/// How many plies were searched below this position.
+	int8_t depth;
+
+	/// See `Bound`.
+	uint8_t bound : 2;
+
+	/// Search which stored the entry, see `TranspositionTable::newSearch()`.
+	uint8_t generation : 6;
+};
+
+/// Position keyed cache of search results.
+///
+/// Direct mapped. Like in `EvalCache`, entries store the key XOR'ed with the data so
+/// that torn entries fail verification. This lets threads, and processes sharing the
+/// table through shared memory, use it without locks.
+class TranspositionTable
+{
+public:
+	/// Construct a table with given number of entries, rounded down to a power of two.
+	explicit TranspositionTable(size_t entries=defaultEntries);
+	~TranspositionTable();
+
+	TranspositionTable(const TranspositionTable &) = delete;
+	TranspositionTable & operator = (const TranspositionTable &) = delete;
+
+	/// Replace the table with an empty one of given number of entries, rounded down to a
+	/// power of two, cleared using given number of threads.
+	/// Returns false and keeps the current table if the memory can't be allocated.
+	bool resize(size_t entries, int threads=1);
+
+	/// Same as `resize()`, with as many entries as fit in given number of megabytes, at
+	/// least one.
+	bool resizeMegabytes(size_t megabytes, int threads=1);
+
+	/// Use a table in the named POSIX shared memory segment, shared with other processes
+	/// using the same name. The segment is created with given number of entries, rounded
+	/// down to a power of two, if it doesn't exist. Otherwise its size comes from the segment.
+	/// Returns false and keeps the current table if the segment can't be used.
+	bool attach(const std::string &name, size_t entries);
+
+	/// Use a table stored in given file, shared with other processes using the same file
+	/// and kept when the process exits. The file is created with given number of entries,
+	/// rounded down to a power of two, if it doesn't exist.
+	/// Returns false and keeps the current table if the file can't be used.
+	bool openFile(const std::string &path, size_t entries);
+
+	/// Return true if the table is in shared memory or a file.
+	bool isShared() const { return sharedMap != nullptr; }
+
+	/// Remove the named shared memory segment. Processes using it keep their mapping.
+	static bool removeShared(const std::string &name);
+
+	/// Return number of entries.
+	size_t getSize() const { return mask + 1; }
+
+	/// Return how full the table is in permille, estimated from the entries stored by
+	/// the current search among the first thousand.
+	int getHashfull() const;
+
+	/// Forget all stored entries, splitting the work between given number of threads.
+	/// Entries of a shared table are forgotten by all processes using it.
+	void clear(int threads=1);
+
+	/// Start a new search. Entries are kept, but the ones stored by earlier searches
+	/// are the first to be replaced. Processes sharing a table share the current search,
+	/// so that they don't take each other's entries for old ones.
+	void newSearch();
+
+	/// If the position has been stored, copies the entry to `ret` and returns true.
+	bool probe(uint64_t key, TableEntry &ret) const;
+
+	/// Remember search result of a position.
+	void store(uint64_t key, Move move, int eval, int depth, Bound bound);
+
+	/// Pack move into 16 bits, 6 bits for source and destination and 3 for promotion.
+	static uint16_t packMove(Move move);
+
+	/// Inverse of `packMove()`.
+	static Move unpackMove(uint16_t bits);
+
+	static constexpr size_t defaultEntries = 1 << 18;
+
+	/// Bytes of memory used by each entry.
+	static constexpr size_t entryBytes = 2 * sizeof(uint64_t);
+
+private:
+	struct Slot
+	{
+		/// Key of the position XOR `data`.
+		std::atomic<uint64_t> check;
+
+		/// Rest of `TableEntry` packed into 64 bits.
+		std::atomic<uint64_t> data;
+	};
+
+	static uint64_t packData(const TableEntry &entry);
+	static TableEntry unpackData(uint64_t key, uint64_t data);
+
+	/// Map a table from shared memory or a file, initializing it if it was just created.
+	bool mapShared(int fd, bool created, size_t entries, const std::string &name);
+
+	void unmapShared();
+
+	/// Return the current search, as stored in entries.
+	uint8_t getGeneration() const;
+
+	LargeBuffer memory;
+
+	/// Shared memory or file mapping, including the header, if the table is shared.
+	void *sharedMap = nullptr;
+	size_t sharedSize = 0;
+
+	/// Entries, stored in `memory` or `sharedMap`.
+	Slot *slots = nullptr;
+
+	/// Number of entries - 1, used for masking the key into an index.
+	uint64_t mask;
+
+	/// Current search of a table of this process, see `generation`.
+	std::atomic<uint32_t> ownGeneration{0};
+
+	/// Current search, wraps around. Points to `ownGeneration` or into the header of a
+	/// shared table.
+	std::atomic<uint32_t> *generation = &ownGeneration;
+};
+
+} // namespace vimlock
@@ -4,13 +4,19 @@
 #include "Move.h"
 #include "Log.h"
 
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
 #include <sstream>
-#include <list>
 
 namespace vimlock
 {
 
+/// Transposition table size in megabytes.
+constexpr long minHashSize = 1;
+constexpr long maxHashSize = 1 << 20;
+constexpr long defaultHashSize = TranspositionTable::defaultEntries * TranspositionTable::entryBytes / (1024 * 1024);
+
 static bool startswith(const std::string &str, const std::string &prefix)
 {
 	return str.rfind(prefix, 0) == 0;
@@ -53,6 +59,8 @@ void Uci::onLine(const std::string &line)
 		onPosition(line);
 	else if (line == "quit")
 		onQuit(line);
+	else if (startswith(line, "setoption "))
+		onSetOption(line);
 	else if (line == "stop")
 		onQuit(line);
 	else if (line == "uci")
@@ -78,8 +86,18 @@ void Uci::onIsReady(const std::string &line)
 
 void Uci::onGo(const std::string &line)
 {
+	engine.setIterationHandler([this](const SearchInfo &info) { onIteration(info); });
+	engine.setCurrentMoveHandler([this](Move move, int number) {
+		send("info currmove " + move.toLan() + " currmovenumber " + std::to_string(number));
+	});
+
 	Evaluation e;
-	if (!engine.poll(e)) {
+	bool found = engine.poll(e);
+
+	engine.setIterationHandler(nullptr);
+	engine.setCurrentMoveHandler(nullptr);
+
+	if (!found) {
 		return;
 	}
 
@@ -91,63 +109,117 @@ void Uci::onGo(const std::string &line)
 	logInfo("total:        " + std::to_string(e.total));
 }
 
+void Uci::onIteration(const SearchInfo &info)
+{
+	std::string score = info.mate != 0
+		? "mate " + std::to_string(info.mate)
+		: "cp " + std::to_string(info.eval);
+
+	// Speed is left out when it couldn't be measured
+	std::string nps = info.nps != 0
+		? " nps " + std::to_string(info.nps)
+		: "";
+
+	send("info depth " + std::to_string(info.depth)
+		+ " seldepth " + std::to_string(info.selDepth)
+		+ " score " + score
+		+ " nodes " + std::to_string(info.nodes)
+		+ nps
+		+ " time " + std::to_string(info.time)
+		+ " hashfull " + std::to_string(info.hashfull)
+		+ " tbhits " + std::to_string(info.tbHits)
+		+ " pv " + info.continuation.toLan());
+}
+
 void Uci::onUciNewGame(const std::string &line)
 {
+	engine.newGame();
 }
 
-/// TODO: Handle FEN definitions
-void Uci::onPosition(const std::string &line)
+bool Uci::applyMove(const std::string &lan)
 {
-	Board board;
+	Move move;
+	if (!move.parseLan(lan))
+		return false;
+
+	Board next = position;
+	if (!next.movePiece(move.getSource(), move.getDestination(), move.getPromotion()))
+		return false;
+
+	next.flipCurrent();
+
+	positionKeys.push_back(position.getKey());
+	positionMoves.push_back(lan);
+	position = next;
 
-	std::list<std::string> parts;
+	return true;
+}
+
+void Uci::onPosition(const std::string &line)
+{
+	std::vector<std::string> parts;
 	std::istringstream stream(line);
 	std::string part;
-	while (std::getline(stream, part, ' '))
+	while (stream >> part)
 		parts.push_back(part);
 
-	// Remove "position"
-	parts.pop_front();
+	// Everything between "position" and "moves" describes the starting position
+	size_t movesStart = std::find(parts.begin(), parts.end(), "moves") - parts.begin();
 
-	if (parts.empty()) {
-		logError("Invalid command: " + line);
-		return;
-	}
+	std::string base;
+	for (size_t i = 1; i < movesStart; ++i)
+		base += (i > 1 ? " " : "") + parts[i];
 
-	if (parts.front() == "startpos") {
-		board.setStandardPosition();
-		parts.pop_front();
-	}
-	else if (parts.front() == "fen") {
-		logError("FEN strings not implemented");
-		parts.pop_front();
-	}
+	size_t first = std::min(movesStart + 1, parts.size());
+	size_t count = parts.size() - first;
 
-	if (!parts.empty()) {
-		if (parts.front() == "moves") {
-			MoveList moves;
-			parts.pop_front();
+	// Same game with moves added, only the new ones need to be applied
+	bool extends = !positionBase.empty()
+		&& base == positionBase
+		&& count >= positionMoves.size()
+		&& std::equal(positionMoves.begin(), positionMoves.end(), parts.begin() + first);
 
-			for (const std::string &it : parts) {
-				Move move;
-				if (!move.parseLan(it)) {
-					logError("Invalid command: " + line);
-				}
+	if (extends) {
+		first += positionMoves.size();
+	}
+	else {
+		positionBase.clear();
+		positionMoves.clear();
+		positionKeys.clear();
 
-				moves.push_back(move);
-			}
+		if (parts.size() < 2) {
+			logError("Invalid command: " + line);
+			return;
+		}
 
-			if (!board.applyMoves(moves)) {
-				logError("Invalid moves on position: " + line);
+		if (parts[1] == "startpos" && movesStart == 2) {
+			position.setStandardPosition();
+		}
+		else if (parts[1] == "fen") {
+			if (!position.fromFen(base.substr(3))) {
+				logError("Invalid FEN: " + line);
+				return;
 			}
 		}
 		else {
 			logError("Invalid command: " + line);
 			return;
 		}
+
+		positionBase = base;
+	}
+
+	for (size_t i = first; i < parts.size(); ++i) {
+		if (!applyMove(parts[i])) {
+			logError("Invalid moves on position: " + line);
+
+			// Rebuild from scratch next time
+			positionBase.clear();
+			break;
+		}
 	}
 
-	engine.setPosition(board);
+	engine.setPosition(position, positionKeys);
 }
 
 void Uci::onQuit(const std::string &line)
@@ -155,6 +227,72 @@ void Uci::onQuit(const std::string &line)
 	quit = true;
 }
 
+void Uci::onSetOption(const std::string &line)
+{
+	// setoption name <id> [value <x>], both may contain spaces
+	const std::string nameToken = " name ";
+	const std::string valueToken = " value ";
+
+	size_t nameStart = line.find(nameToken);
+	if (nameStart == std::string::npos) {
+		logError("Invalid command: " + line);
+		return;
+	}
+
+	nameStart += nameToken.size();
+
+	size_t valueStart = line.find(valueToken, nameStart);
+
+	std::string name = line.substr(nameStart, valueStart == std::string::npos ? std::string::npos : valueStart - nameStart);
+	std::string value = valueStart == std::string::npos ? "" : line.substr(valueStart + valueToken.size());
+
+	if (name == "EvalFile") {
+		if (value == "<empty>")
+			value.clear();
+
+		if (!engine.setEvalFile(value))
+			logError("Failed to load evaluation network: " + value);
+	}
+	else if (name == "SyzygyPath") {
+		if (value == "<empty>")
+			value.clear();
+
+		engine.setSyzygyPath(value);
+	}
+	else if (name == "BookFile") {
+		if (value == "<empty>")
+			value.clear();
+
+		if (!engine.setBookFile(value))
+			logError("Failed to load opening book: " + value);
+	}
+	else if (name == "Hash") {
+		long megabytes = strtol(value.c_str(), nullptr, 10);
+
+		if (megabytes < minHashSize || megabytes > maxHashSize)
+			logError("Invalid hash size: " + value);
+		else if (!engine.setHashSize(megabytes))
+			logError("Failed to allocate hash: " + value);
+	}
+	else if (name == "AnalysisFile") {
+		if (value == "<empty>")
+			value.clear();
+
+		if (!engine.setAnalysisFile(value))
+			logError("Failed to open analysis file: " + value);
+	}
+	else if (name == "SharedHash") {
+		if (value == "<empty>")
+			value.clear();
+
+		if (!engine.setSharedHash(value))
+			logError("Failed to use shared hash: " + value);
+	}
+	else {
+		logError("Unknown option: " + name);
+	}
+}
+
 void Uci::onStop(const std::string &line)
 {
 	engine.stop();
@@ -164,6 +302,13 @@ void Uci::onUci(const std::string &line)
 {
 	send("id name EngineDemo");
 	send("id author Joel Polso");
+	send("option name EvalFile type string default <empty>");
+	send("option name SyzygyPath type string default <empty>");
+	send("option name BookFile type string default <empty>");
+	send("option name Hash type spin default " + std::to_string(defaultHashSize)
+		+ " min " + std::to_string(minHashSize) + " max " + std::to_string(maxHashSize));
+	send("option name SharedHash type string default <empty>");
+	send("option name AnalysisFile type string default <empty>");
 	send("uciok");
 }
 
@@ -1,11 +1,16 @@
 #pragma once
+#include "Board.h"
+
+#include <cstdint>
 #include <iosfwd>
 #include <string>
+#include <vector>
 
 namespace vimlock
 {
 
 class Engine;
+struct SearchInfo;
 
 /// Universal Chess Interface (UCI) support.
 class Uci
@@ -22,6 +27,7 @@ private:
 	void onIsReady(const std::string &line);
 	void onPosition(const std::string &line);
 	void onQuit(const std::string &line);
+	void onSetOption(const std::string &line);
 	void onStop(const std::string &line);
 	void onUci(const std::string &line);
 	void onUciNewGame(const std::string &line);
@@ -29,11 +35,28 @@ private:
 
 	void send(const std::string &line);
 
+	/// Report progress of the search after an iteration.
+	void onIteration(const SearchInfo &info);
+
+	/// Apply a move given in long algebraic notation to the current position, adding
+	/// the previous position to the history. Returns false if the move is invalid.
+	bool applyMove(const std::string &lan);
+
 	Engine &engine;
 	std::istream &input;
 	std::ostream &output;
 
 	bool quit = false;
+
+	/// Position set by the last position command, kept so that a command extending
+	/// the same game applies only the new moves.
+	/// Base is the part of the command before the moves, empty if the position is not valid.
+	std::string positionBase;
+	std::vector<std::string> positionMoves;
+	Board position;
+
+	/// Keys of the positions before `position`, oldest first.
+	std::vector<uint64_t> positionKeys;
 };
 
 } // namespace vimlock
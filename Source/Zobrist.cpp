@@ -0,0 +1,48 @@
+#include "Zobrist.h"
+
+namespace vimlock
+{
+
+uint64_t Zobrist::pieces[2][6][64];
+uint64_t Zobrist::castling[16];
+uint64_t Zobrist::enpassant[8];
+uint64_t Zobrist::side;
+
+/// SplitMix64, good enough for generating hash keys and fixed seed keeps them stable between runs.
+static uint64_t nextRandom(uint64_t &state)
+{
+	uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+namespace
+{
+
+struct ZobristInit
+{
+	ZobristInit()
+	{
+		uint64_t state = 0x1234567ULL;
+
+		for (int c = 0; c < 2; ++c)
+			for (int p = 0; p < 6; ++p)
+				for (int s = 0; s < 64; ++s)
+					Zobrist::pieces[c][p][s] = nextRandom(state);
+
+		for (int i = 0; i < 16; ++i)
+			Zobrist::castling[i] = nextRandom(state);
+
+		for (int i = 0; i < 8; ++i)
+			Zobrist::enpassant[i] = nextRandom(state);
+
+		Zobrist::side = nextRandom(state);
+	}
+};
+
+ZobristInit init;
+
+} // anonymous namespace
+
+} // namespace vimlock
@@ -0,0 +1,39 @@
+#pragma once
+#include "Enums.h"
+#include "Square.h"
+
+#include <cstdint>
+
+namespace vimlock
+{
+
+/// Random keys used for hashing board positions.
+///
+/// Position hash is computed by XORing together the keys of every piece on the board,
+/// plus keys for side to move, castle rights and en passant file.
+///
+/// Material hash reuses the piece keys, indexing them with piece count instead of the square.
+struct Zobrist
+{
+	/// Return key for given piece on given square.
+	static uint64_t piece(Color color, Piece piece, Square square);
+
+	/// Keys for each piece, indexed by color, piece type and square.
+	static uint64_t pieces[2][6][64];
+
+	/// Keys for each combination of castle rights.
+	static uint64_t castling[16];
+
+	/// Keys for en passant target file.
+	static uint64_t enpassant[8];
+
+	/// Key toggled when black is to move.
+	static uint64_t side;
+};
+
+inline uint64_t Zobrist::piece(Color color, Piece piece, Square square)
+{
+	return pieces[colorIndex(color)][pieceIndex(piece)][square.getIndex()];
+}
+
+} // namespace vimlock
@@ -115,3 +115,16 @@ TEST_CASE("Bitboard flip ranks")
 	REQUIRE(Bitboard(Square(0, 3)).flipRanks().count() == 1);
 	REQUIRE(Bitboard(Square(0, 3)).flipRanks().contains(0, 4));
 }
+
+TEST_CASE("Bitboard iteration")
+{
+	REQUIRE(Bitboard(A1).findFirstSquare() == Square(A1));
+	REQUIRE(Bitboard(H8).findFirstSquare() == Square(H8));
+
+	Bitboard bits = Bitboard(C3) | Bitboard(A1) | Bitboard(H8);
+
+	REQUIRE(bits.popFirstSquare() == Square(A1));
+	REQUIRE(bits.popFirstSquare() == Square(C3));
+	REQUIRE(bits.popFirstSquare() == Square(H8));
+	REQUIRE(bits.empty());
+}
@@ -218,3 +218,195 @@ TEST_CASE("En passant works")
 	}
 
 }
+
+TEST_CASE("Position key")
+{
+	Board a;
+	Board b;
+
+	a.setStandardPosition();
+	b.setStandardPosition();
+
+	SECTION("Same position has same key") {
+		REQUIRE(a.getKey() == b.getKey());
+	}
+
+	SECTION("Transposed move order gives same key") {
+		REQUIRE(a.applyMoves({{G1, F3}, {G8, F6}, {B1, C3}}));
+		REQUIRE(b.applyMoves({{B1, C3}, {G8, F6}, {G1, F3}}));
+		REQUIRE(a.getKey() == b.getKey());
+	}
+
+	SECTION("Side to move changes key") {
+		b.flipCurrent();
+		REQUIRE(a.getKey() != b.getKey());
+	}
+
+	SECTION("Moving a piece changes key") {
+		REQUIRE(b.movePiece(G1, F3));
+		REQUIRE(a.getKey() != b.getKey());
+
+		REQUIRE(b.movePiece(F3, G1));
+		REQUIRE(a.getKey() == b.getKey());
+	}
+
+	SECTION("Castle rights change key") {
+		REQUIRE(a.movePiece(B1, C3));
+		REQUIRE(a.movePiece(A1, B1));
+		REQUIRE(a.movePiece(B1, A1));
+		REQUIRE(a.movePiece(C3, B1));
+
+		REQUIRE(a.getKey() != b.getKey());
+	}
+
+	SECTION("Pawn key follows only pawns") {
+		REQUIRE(b.movePiece(G1, F3));
+		REQUIRE(a.getPawnKey() == b.getPawnKey());
+
+		REQUIRE(b.movePiece(E2, E4));
+		REQUIRE(a.getPawnKey() != b.getPawnKey());
+	}
+}
+
+TEST_CASE("Incremental material and positional scores")
+{
+	Board board;
+	board.setStandardPosition();
+
+	auto requireConsistent = [](const Board &board) {
+		for (Color color : {WHITE, BLACK}) {
+			int material = 0;
+			Score positional;
+
+			for (uint64_t i = 0; i < 64; ++i) {
+				SquareState square = board.getSquare(Square(i));
+				if (!square.isOccupied() || square.getColor() != color)
+					continue;
+
+				material += getPieceValue(square.getPiece());
+				positional += Psqt::get(color, square.getPiece(), Square(i));
+			}
+
+			REQUIRE(board.getMaterial(color) == material);
+			REQUIRE(board.getPositional(color) == positional);
+		}
+	};
+
+	SECTION("Start position") {
+		REQUIRE(board.getMaterial(WHITE) == 8 * PAWN_VALUE + 2 * (ROOK_VALUE + KNIGHT_VALUE + BISHOP_VALUE) + QUEEN_VALUE);
+		REQUIRE(board.getMaterial(WHITE) == board.getMaterial(BLACK));
+		REQUIRE(board.getPositional(WHITE) == board.getPositional(BLACK));
+		REQUIRE(board.getPhase() == MAX_PHASE);
+		requireConsistent(board);
+	}
+
+	SECTION("Captures") {
+		REQUIRE(board.applyMoves({{E2, E4}, {D7, D5}, {E4, D5}, {D8, D5}}));
+		REQUIRE(board.getMaterial(WHITE) == board.getMaterial(BLACK));
+		requireConsistent(board);
+	}
+
+	SECTION("Promotion") {
+		board.clear();
+		board.setSquare(B7, WHITE, PAWN);
+		board.setSquare(A8, BLACK, ROOK);
+
+		REQUIRE(board.movePiece(B7, A8, QUEEN));
+		REQUIRE(board.getMaterial(WHITE) == QUEEN_VALUE);
+		REQUIRE(board.getMaterial(BLACK) == 0);
+		REQUIRE(board.getPhase() == getPhaseWeight(QUEEN));
+		requireConsistent(board);
+	}
+}
+
+TEST_CASE("Packed scores")
+{
+	SECTION("Values survive packing") {
+		for (int mg : {-32000, -300, -1, 0, 1, 250, 32000}) {
+			for (int eg : {-32000, -300, -1, 0, 1, 250, 32000}) {
+				REQUIRE(Score(mg, eg).getMidgame() == mg);
+				REQUIRE(Score(mg, eg).getEndgame() == eg);
+			}
+		}
+	}
+
+	SECTION("Arithmetic") {
+		Score a(100, -20);
+		Score b(-150, 40);
+
+		REQUIRE((a + b) == Score(-50, 20));
+		REQUIRE((a - b) == Score(250, -60));
+		REQUIRE(-a == Score(-100, 20));
+		REQUIRE(b * 3 == Score(-450, 120));
+	}
+
+	SECTION("Tapering") {
+		Score score(100, 300);
+
+		REQUIRE(score.taper(MAX_PHASE, MAX_PHASE) == 100);
+		REQUIRE(score.taper(0, MAX_PHASE) == 300);
+		REQUIRE(score.taper(MAX_PHASE / 2, MAX_PHASE) == 200);
+		REQUIRE(score.taper(MAX_PHASE + 4, MAX_PHASE) == 100);
+	}
+}
+
+TEST_CASE("FEN")
+{
+	Board board;
+	Board expected;
+	expected.setStandardPosition();
+
+	SECTION("Standard position") {
+		const std::string fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+		REQUIRE(board.fromFen(fen));
+		REQUIRE(board.getKey() == expected.getKey());
+		REQUIRE(board.getMaterialKey() == expected.getMaterialKey());
+		REQUIRE(expected.toFen() == fen);
+	}
+
+	SECTION("Moves update en passant, castle rights and clocks") {
+		REQUIRE(expected.applyMoves({{E2, E4}, {G8, F6}, {E4, E5}, {D7, D5}}));
+		REQUIRE(expected.toFen() == "rnbqkb1r/ppp1pppp/5n2/3pP3/8/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 3");
+
+		REQUIRE(board.fromFen(expected.toFen()));
+		REQUIRE(board.getKey() == expected.getKey());
+
+		// En passant capture works on the parsed board
+		REQUIRE(board.movePiece(E5, D6));
+		REQUIRE(!board.getSquare(D5).isOccupied());
+
+		REQUIRE(expected.applyMoves({{G1, F3}, {H8, G8}, {F1, E2}, {B8, C6}}));
+		REQUIRE(expected.toFen() == "r1bqkbr1/ppp1pppp/2n2n2/3pP3/8/5N2/PPPPBPPP/RNBQK2R w KQq - 4 5");
+		REQUIRE(expected.getHalfmoveClock() == 4);
+		REQUIRE(expected.getFullmoveNumber() == 5);
+
+		REQUIRE(expected.applyMoves({{E1, G1}}));
+		REQUIRE(expected.toFen() == "r1bqkbr1/ppp1pppp/2n2n2/3pP3/8/5N2/PPPPBPPP/RNBQ1RK1 b q - 5 5");
+	}
+
+	SECTION("Optional clocks and unusable en passant") {
+		REQUIRE(board.fromFen("4k3/8/8/8/4P3/8/8/4K3 b - e3"));
+		REQUIRE(board.getEnPassantSquares() == Bitboard(E3));
+		REQUIRE(board.getHalfmoveClock() == 0);
+		REQUIRE(board.getFullmoveNumber() == 1);
+		REQUIRE(board.toFen() == "4k3/8/8/8/4P3/8/8/4K3 b - e3 0 1");
+
+		// No pawn which could have moved past the square
+		REQUIRE(board.fromFen("4k3/8/8/8/8/8/8/4K3 b - e3 12 40"));
+		REQUIRE(!board.getEnPassantSquares());
+		REQUIRE(board.getHalfmoveClock() == 12);
+		REQUIRE(board.getFullmoveNumber() == 40);
+	}
+
+	SECTION("Invalid strings") {
+		REQUIRE(!board.fromFen(""));
+		REQUIRE(!board.fromFen("8/8/8/8/8/8/8 w - -"));
+		REQUIRE(!board.fromFen("9/8/8/8/8/8/8/8 w - -"));
+		REQUIRE(!board.fromFen("8/8/8/8/8/8/8/8 x - -"));
+		REQUIRE(!board.fromFen("8/8/8/8/8/8/8/8 w X -"));
+		REQUIRE(!board.fromFen("8/8/8/8/8/8/8/8 w - e4"));
+		REQUIRE(!board.fromFen("8/8/8/8/8/8/8/8 w - - 0"));
+		REQUIRE(!board.fromFen("8/8/8/8/8/8/8/8 w - - 0 1 extra"));
+	}
+}
@@ -0,0 +1,294 @@
+#include <catch2/catch.hpp>
+#include "Book.h"
+#include "BookBuilder.h"
+#include "Engine.h"
+
+#include <algorithm>
+#include <cstdio>
+
+using namespace vimlock;
+
+/// Write entries into a book file, sorting them by key.
+static void writeBook(const std::string &path, std::vector<BookEntry> entries)
+{
+	std::stable_sort(entries.begin(), entries.end(), [](const BookEntry &a, const BookEntry &b) {
+		return a.key < b.key;
+	});
+
+	FILE *file = fopen(path.c_str(), "wb");
+	REQUIRE(file);
+
+	for (const BookEntry &entry : entries) {
+		uint8_t data[BOOK_ENTRY_SIZE];
+		Book::writeEntry(entry, data);
+		REQUIRE(fwrite(data, 1, sizeof(data), file) == sizeof(data));
+	}
+
+	fclose(file);
+}
+
+static BookEntry makeEntry(const Board &board, Move move, uint16_t weight)
+{
+	BookEntry ret;
+	ret.key = Book::getKey(board);
+	ret.move = Book::encodeMove(board, move);
+	ret.weight = weight;
+	ret.learn = 0;
+	return ret;
+}
+
+TEST_CASE("Book keys")
+{
+	Board a;
+	Board b;
+	a.setStandardPosition();
+	b.setStandardPosition();
+
+	SECTION("Keys match the Polyglot reference") {
+		REQUIRE(Book::getKey(a) == 0x463B96181691FC9CULL);
+
+		REQUIRE(a.applyMoves({{E2, E4}}));
+		REQUIRE(Book::getKey(a) == 0x823C9B50FD114196ULL);
+
+		REQUIRE(a.applyMoves({{D7, D5}}));
+		REQUIRE(Book::getKey(a) == 0x0756B94461C50FB0ULL);
+
+		REQUIRE(a.applyMoves({{E4, E5}, {F7, F5}}));
+		REQUIRE(Book::getKey(a) == 0x22A48B5A8E47FF78ULL);
+
+		// Castle rights are lost by moving the kings
+		REQUIRE(a.applyMoves({{E1, E2}, {E8, F7}}));
+		REQUIRE(Book::getKey(a) == 0x00FDD303C946BDD9ULL);
+
+		// En passant which can be captured, then a rook leaving its corner
+		REQUIRE(b.applyMoves({{A2, A4}, {B7, B5}, {H2, H4}, {B5, B4}, {C2, C4}}));
+		REQUIRE(Book::getKey(b) == 0x3C8123EA7B067637ULL);
+
+		REQUIRE(b.applyMoves({{B4, C3}, {A1, A3}}));
+		REQUIRE(Book::getKey(b) == 0x5C3F9B829B279560ULL);
+	}
+
+	SECTION("Transpositions have the same key") {
+		REQUIRE(a.applyMoves({{G1, F3}, {G8, F6}, {B1, C3}}));
+		REQUIRE(b.applyMoves({{B1, C3}, {G8, F6}, {G1, F3}}));
+		REQUIRE(Book::getKey(a) == Book::getKey(b));
+	}
+
+	SECTION("Side to move changes the key") {
+		b.setCurrent(BLACK);
+		REQUIRE(Book::getKey(a) != Book::getKey(b));
+	}
+
+	SECTION("Castle rights change the key") {
+		REQUIRE(a.applyMoves({{G1, F3}, {G8, F6}, {H1, G1}, {H8, G8}, {G1, H1}, {G8, H8}}));
+		REQUIRE(b.applyMoves({{G1, F3}, {G8, F6}}));
+		REQUIRE(Book::getKey(a) != Book::getKey(b));
+	}
+
+	SECTION("En passant only when it can be captured") {
+		// No black pawn next to e4, same as if the pawn had moved one step at a time
+		REQUIRE(a.applyMoves({{E2, E4}}));
+		REQUIRE(b.movePiece(E2, E3));
+		REQUIRE(b.movePiece(E3, E4));
+		b.setCurrent(BLACK);
+		REQUIRE(a.getEnPassantSquares());
+		REQUIRE(Book::getKey(a) == Book::getKey(b));
+
+		// Black pawn on d4 can capture
+		Board c;
+		Board d;
+		c.setStandardPosition();
+		d.setStandardPosition();
+		REQUIRE(c.applyMoves({{E2, E3}, {D7, D5}, {E3, E4}, {D5, D4}, {C2, C4}}));
+		REQUIRE(d.applyMoves({{E2, E3}, {D7, D5}, {E3, E4}, {D5, D4}, {C2, C3}, {A7, A6}, {C3, C4}}));
+		d.setCurrent(BLACK);
+		REQUIRE(Book::getKey(c) != Book::getKey(d));
+	}
+}
+
+TEST_CASE("Book moves")
+{
+	Board board;
+	board.setStandardPosition();
+
+	SECTION("Castling is stored as capturing the rook") {
+		REQUIRE(board.applyMoves({{E2, E4}, {E7, E5}, {G1, F3}, {B8, C6}, {F1, C4}, {G8, F6}}));
+
+		Move castle(E1, G1);
+		uint16_t encoded = Book::encodeMove(board, castle);
+		REQUIRE(Book::decodeMove(board, encoded) == castle);
+		REQUIRE(Book::decodeMove(board, encoded) != Move(E1, H1));
+		REQUIRE((encoded & 0x3F) == H1);
+	}
+
+	SECTION("Promotions") {
+		board.clear();
+		board.setSquare(E1, WHITE, KING);
+		board.setSquare(B7, WHITE, PAWN);
+		board.setSquare(E8, BLACK, KING);
+
+		Move move(B7, B8, KNIGHT);
+		REQUIRE(Book::decodeMove(board, Book::encodeMove(board, move)) == move);
+	}
+	SECTION("Moves of pieces not to move are invalid") {
+		// Entries of a colliding key, moving from an empty square or an opponent's piece
+		REQUIRE(Book::decodeMove(board, Book::encodeMove(board, Move(E4, E5))) == Move());
+		REQUIRE(Book::decodeMove(board, Book::encodeMove(board, Move(E7, E5))) == Move());
+		REQUIRE(Book::decodeMove(board, Book::encodeMove(board, Move(E8, G8))) == Move());
+	}
+}
+
+TEST_CASE("Book probing")
+{
+	const std::string path = "TestBook.bin";
+
+	Board start;
+	start.setStandardPosition();
+
+	Board afterE4 = start;
+	REQUIRE(afterE4.applyMoves({{E2, E4}}));
+
+	writeBook(path, {
+		makeEntry(start, Move(E2, E4), 1),
+		makeEntry(start, Move(D2, D4), 0),
+		// Illegal move, as if the key collided with another position
+		makeEntry(afterE4, Move(E2, E4), 5),
+		makeEntry(afterE4, Move(C7, C5), 1),
+	});
+
+	Book book;
+	Move move;
+
+	SECTION("Missing and invalid files") {
+		REQUIRE(!book.load("NoSuchBook.bin"));
+		REQUIRE(!book.isLoaded());
+
+		FILE *file = fopen(path.c_str(), "ab");
+		REQUIRE(file);
+		fputc(0, file);
+		fclose(file);
+
+		REQUIRE(!book.load(path));
+		REQUIRE(!book.probe(start, move));
+	}
+
+	SECTION("Entries") {
+		REQUIRE(book.load(path));
+		REQUIRE(book.getSize() == 4);
+
+		std::vector<BookEntry> entries;
+		book.getEntries(start, entries);
+		REQUIRE(entries.size() == 2);
+
+		// Zero weight is never picked when other moves have weight
+		for (int i = 0; i < 10; ++i) {
+			REQUIRE(book.probe(start, move));
+			REQUIRE(move == Move(E2, E4));
+
+			REQUIRE(book.probe(afterE4, move));
+			REQUIRE(move == Move(C7, C5));
+		}
+
+		Board other = afterE4;
+		REQUIRE(other.applyMoves({{C7, C5}}));
+		REQUIRE(!book.probe(other, move));
+
+		REQUIRE(book.load(""));
+		REQUIRE(!book.probe(start, move));
+	}
+
+	SECTION("Engine plays book moves without searching") {
+		Engine engine;
+		REQUIRE(engine.setBookFile(path));
+		engine.setPosition(start);
+
+		Evaluation eval;
+		REQUIRE(engine.poll(eval));
+		REQUIRE(eval.best == Move(E2, E4));
+		REQUIRE(eval.total == 0);
+	}
+
+	remove(path.c_str());
+}
+
+TEST_CASE("Book builder")
+{
+	const std::string pgnPath = "TestBook.pgn";
+	const std::string bookPath = "TestBookBuilt.bin";
+
+	FILE *file = fopen(pgnPath.c_str(), "w");
+	REQUIRE(file);
+	fputs(
+		"[Result \"1-0\"]\n\n1. e4 e5 1-0\n\n"
+		"[Result \"0-1\"]\n\n1. e4 c5 0-1\n\n"
+		"[Result \"1/2-1/2\"]\n\n1. d4 d5 1/2-1/2\n\n"
+		"[Result \"1/2-1/2\"]\n\n1. e4 e5 2. Qxf7 1/2-1/2\n\n",
+		file);
+	fclose(file);
+
+	BookBuilder::Options options;
+	options.threads = 2;
+	options.tempPrefix = "TestBookRun";
+
+	Board start;
+	start.setStandardPosition();
+
+	Board afterE4 = start;
+	REQUIRE(afterE4.applyMoves({{E2, E4}}));
+
+	Book book;
+	std::vector<BookEntry> entries;
+
+	SECTION("Weights") {
+		BookBuilder builder(options);
+		REQUIRE(builder.addFile(pgnPath));
+		REQUIRE(builder.getGames() == 4);
+		// Illegal move ends the last game
+		REQUIRE(builder.getPositions() == 8);
+		REQUIRE(builder.write(bookPath));
+
+		REQUIRE(book.load(bookPath));
+		REQUIRE(book.getSize() == 5);
+
+		// Two points for a win and one for a draw, best first
+		book.getEntries(start, entries);
+		REQUIRE(entries.size() == 2);
+		REQUIRE(Book::decodeMove(start, entries[0].move) == Move(E2, E4));
+		REQUIRE(entries[0].weight == 3);
+		REQUIRE(Book::decodeMove(start, entries[1].move) == Move(D2, D4));
+		REQUIRE(entries[1].weight == 1);
+
+		book.getEntries(afterE4, entries);
+		REQUIRE(entries.size() == 2);
+		REQUIRE(Book::decodeMove(afterE4, entries[0].move) == Move(C7, C5));
+		REQUIRE(entries[0].weight == 2);
+		REQUIRE(Book::decodeMove(afterE4, entries[1].move) == Move(E7, E5));
+		REQUIRE(entries[1].weight == 1);
+	}
+
+	SECTION("Spilling runs and filtering") {
+		options.maxEntries = 2;
+		options.minGames = 2;
+
+		BookBuilder builder(options);
+		REQUIRE(builder.addFile(pgnPath));
+		REQUIRE(!builder.addFile("NoSuchFile.pgn"));
+		REQUIRE(builder.write(bookPath));
+		REQUIRE(builder.getRuns() > 1);
+
+		REQUIRE(book.load(bookPath));
+		REQUIRE(book.getSize() == 2);
+
+		book.getEntries(start, entries);
+		REQUIRE(entries.size() == 1);
+		REQUIRE(entries[0].weight == 3);
+
+		book.getEntries(afterE4, entries);
+		REQUIRE(entries.size() == 1);
+		REQUIRE(Book::decodeMove(afterE4, entries[0].move) == Move(E7, E5));
+	}
+
+	book.load("");
+	remove(pgnPath.c_str());
+	remove(bookPath.c_str());
+}
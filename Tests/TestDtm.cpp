@@ -0,0 +1,237 @@
+#include <catch2/catch.hpp>
+#include "Bitbase.h"
+#include "Dtm.h"
+
+#include <cstdio>
+
+using namespace vimlock;
+
+/// Return longest win of the side to move in plies and number of drawn positions of a generated table.
+static void getStats(const DtmGenerator &generator, const DtmIndex &index, int &longest, uint64_t &draws)
+{
+	longest = 0;
+	draws = 0;
+
+	for (uint64_t i = 0; i < index.getSize(); ++i) {
+		Board board;
+		uint8_t value;
+
+		if (!index.getBoard(i, board) || !generator.probe(board, value) || value == DTM_INVALID)
+			continue;
+
+		if (value == DTM_DRAW)
+			draws++;
+		else if (isDtmWin(value))
+			longest = std::max(longest, getDtmPlies(value));
+	}
+}
+
+TEST_CASE("DTM index", "[dtm]")
+{
+	DtmIndex index;
+
+	REQUIRE(!index.parse("KQ"));
+	REQUIRE(!index.parse("QvK"));
+	REQUIRE(!index.parse("KXvK"));
+	REQUIRE(index.parse("KRvKN"));
+	REQUIRE(index.getSize() == 2 * 10 * 64 * 64 * 64);
+
+	Board board;
+	board.clear();
+	board.setSquare(E1, WHITE, KING);
+	board.setSquare(A7, WHITE, ROOK);
+	board.setSquare(E8, BLACK, KING);
+	board.setSquare(C3, BLACK, KNIGHT);
+
+	REQUIRE(DtmIndex::getName(board) == "KRvKN");
+
+	uint64_t idx;
+	REQUIRE(index.getIndex(board, idx));
+
+	SECTION("Round trip") {
+		Board decoded;
+		REQUIRE(index.getBoard(idx, decoded));
+
+		uint64_t check;
+		REQUIRE(index.getIndex(decoded, check));
+		REQUIRE(check == idx);
+	}
+
+	SECTION("Symmetric positions") {
+		// Mirrored files
+		Board mirrored;
+		mirrored.clear();
+		mirrored.setSquare(D1, WHITE, KING);
+		mirrored.setSquare(H7, WHITE, ROOK);
+		mirrored.setSquare(D8, BLACK, KING);
+		mirrored.setSquare(F3, BLACK, KNIGHT);
+
+		uint64_t other;
+		REQUIRE(index.getIndex(mirrored, other));
+		REQUIRE(other == idx);
+
+		// Colors swapped
+		Board flipped;
+		flipped.clear();
+		flipped.setSquare(E8, BLACK, KING);
+		flipped.setSquare(A2, BLACK, ROOK);
+		flipped.setSquare(E1, WHITE, KING);
+		flipped.setSquare(C6, WHITE, KNIGHT);
+		flipped.setCurrent(BLACK);
+
+		REQUIRE(DtmIndex::getName(flipped) == "KRvKN");
+		REQUIRE(index.getIndex(flipped, other));
+		REQUIRE(other == idx);
+
+		// Different side to move
+		board.setCurrent(BLACK);
+		REQUIRE(index.getIndex(board, other));
+		REQUIRE(other != idx);
+	}
+
+	SECTION("Other material") {
+		board.setSquare(C3, BLACK, BISHOP);
+
+		uint64_t other;
+		REQUIRE(!index.getIndex(board, other));
+	}
+}
+
+TEST_CASE("DTM generator", "[dtm]")
+{
+	DtmGenerator generator(2);
+
+	int longest;
+	uint64_t draws;
+
+	SECTION("Mates") {
+		REQUIRE(!generator.generate("KvK"));
+		REQUIRE(generator.generate("KQvK"));
+		REQUIRE(generator.generate("KRvK"));
+		REQUIRE(generator.generate("KBvK"));
+
+		DtmIndex index;
+
+		REQUIRE(index.parse("KQvK"));
+		getStats(generator, index, longest, draws);
+		REQUIRE(longest == 19);
+
+		REQUIRE(index.parse("KRvK"));
+		getStats(generator, index, longest, draws);
+		REQUIRE(longest == 31);
+
+		REQUIRE(index.parse("KBvK"));
+		getStats(generator, index, longest, draws);
+		REQUIRE(longest == 0);
+		REQUIRE(draws > 0);
+
+		// Mate in one and already mated
+		Board board;
+		board.clear();
+		board.setSquare(G6, WHITE, KING);
+		board.setSquare(A1, WHITE, ROOK);
+		board.setSquare(G8, BLACK, KING);
+
+		uint8_t value;
+		REQUIRE(generator.probe(board, value));
+		REQUIRE(isDtmWin(value));
+		REQUIRE(getDtmPlies(value) == 1);
+
+		board.movePiece(A1, A8);
+		board.setCurrent(BLACK);
+		REQUIRE(generator.probe(board, value));
+		REQUIRE(!isDtmWin(value));
+		REQUIRE(getDtmPlies(value) == 0);
+
+		// Black can capture the rook
+		board.clear();
+		board.setSquare(A1, WHITE, KING);
+		board.setSquare(G7, WHITE, ROOK);
+		board.setSquare(G8, BLACK, KING);
+		board.setCurrent(BLACK);
+		REQUIRE(generator.probe(board, value));
+		REQUIRE(value == DTM_DRAW);
+	}
+
+	SECTION("Pawn agrees with the KPK bitbase") {
+		REQUIRE(generator.generate("KPvK"));
+
+		std::vector<std::string> names = generator.getNames();
+		REQUIRE(names.size() == 5);
+		REQUIRE(names.back() == "KPvK");
+
+		DtmIndex index;
+		REQUIRE(index.parse("KPvK"));
+
+		uint64_t checked = 0;
+
+		for (uint64_t i = 0; i < index.getSize(); ++i) {
+			Board board;
+			uint8_t value;
+
+			if (!index.getBoard(i, board) || !generator.probe(board, value) || value == DTM_INVALID)
+				continue;
+
+			bool won = value != DTM_DRAW && isDtmWin(value) == (board.getCurrent() == WHITE);
+			bool expected = probeKPK(WHITE,
+				board.getPieces(WHITE, KING).findFirstSquare(),
+				board.getPieces(WHITE, PAWN).findFirstSquare(),
+				board.getPieces(BLACK, KING).findFirstSquare(),
+				board.getCurrent());
+
+			if (won != expected)
+				FAIL("Mismatch at index " << i);
+
+			checked++;
+		}
+
+		REQUIRE(checked > 0);
+	}
+
+	SECTION("Files") {
+		const std::string path = "TestDtm.dtm";
+
+		REQUIRE(generator.generate("KRvK"));
+		REQUIRE(!generator.save("KQvK", path));
+
+		DtmTable table;
+		REQUIRE(!table.load("NoSuchFile.dtm"));
+
+		for (const char *name : { "KRvK", "KPvK" }) {
+			REQUIRE(generator.generate(name));
+			REQUIRE(generator.save(name, path));
+
+			REQUIRE(table.load(path));
+			REQUIRE(table.getIndex().getName() == name);
+
+			const DtmIndex &index = table.getIndex();
+
+			// Never larger than the values themselves, besides the header and block offsets
+			FILE *file = fopen(path.c_str(), "rb");
+			REQUIRE(file);
+			fseek(file, 0, SEEK_END);
+			long fileSize = ftell(file);
+			fclose(file);
+
+			uint64_t blocks = (index.getSize() + 4095) / 4096;
+			REQUIRE(static_cast<uint64_t>(fileSize) <= 48 + (blocks + 1) * 8 + index.getSize());
+
+			for (uint64_t i = 0; i < index.getSize(); ++i) {
+				Board board;
+				uint8_t value;
+
+				if (!index.getBoard(i, board) || !generator.probe(board, value) || value == DTM_INVALID)
+					continue;
+
+				uint8_t loaded;
+				REQUIRE(table.probe(board, loaded));
+
+				if (loaded != value)
+					FAIL(name << " mismatch at index " << i);
+			}
+		}
+
+		table.load("");
+		remove(path.c_str());
+	}
+}
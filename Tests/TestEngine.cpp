@@ -1,6 +1,15 @@
 #include <catch2/catch.hpp>
 #include "Engine.h"
 #include "Format.h"
+#include "Memory.h"
+#include "Transposition.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <unistd.h>
 
 using namespace vimlock;
 
@@ -70,6 +79,167 @@ TEST_CASE("Find a mate in two")
 	}
 }
 
+/// Search given position and return what the engine reported after each iteration.
+static std::vector<SearchInfo> searchInfo(const Board &board, int depth)
+{
+	std::vector<SearchInfo> ret;
+
+	Engine engine{depth};
+	engine.setPosition(board);
+	engine.setIterationHandler([&ret](const SearchInfo &info) { ret.push_back(info); });
+
+	Evaluation eval;
+	engine.poll(eval);
+
+	return ret;
+}
+
+TEST_CASE("Check extensions")
+{
+	// Rxe8+ Rxe8 Rxe8#, checkmate happens on the third ply
+	Board board;
+	board.setSquare(E1, WHITE, ROOK);
+	board.setSquare(E2, WHITE, ROOK);
+	board.setSquare(H8, BLACK, KING);
+	board.setSquare(E8, BLACK, ROOK);
+	board.setSquare(A8, BLACK, ROOK);
+	board.setSquare(H7, BLACK, PAWN);
+	board.setSquare(G7, BLACK, PAWN);
+	board.setSquare(F7, BLACK, PAWN);
+
+	SECTION("Checks are searched past the horizon") {
+		// Without extensions the checkmated position would be evaluated statically at
+		// the horizon of three plies, instead of being seen to have no moves
+		std::vector<SearchInfo> info = searchInfo(board, 3);
+
+		REQUIRE(info.size() == 3);
+		REQUIRE(info.back().mate == 2);
+		REQUIRE(info.back().selDepth > 3);
+	}
+
+	SECTION("Path is extended only within budget") {
+		// Depth of two allows a single extension, the mating check would need a second one
+		std::vector<SearchInfo> info = searchInfo(board, 2);
+
+		REQUIRE(info.size() == 2);
+		REQUIRE(info.back().mate == 0);
+		REQUIRE(info.back().selDepth <= 3);
+	}
+
+	SECTION("No path goes deeper than the budget allows") {
+		Board checks;
+		REQUIRE(checks.fromFen("6k1/5ppp/8/8/8/8/1Q3PPP/1R4K1 w - - 0 1"));
+
+		for (const SearchInfo &it : searchInfo(checks, 6))
+			REQUIRE(it.selDepth <= it.depth + 6 / 2);
+	}
+}
+
+TEST_CASE("Search info")
+{
+	Board board;
+	board.setStandardPosition();
+
+	SECTION("Speed is measured for each iteration") {
+		for (const SearchInfo &it : searchInfo(board, 3)) {
+			REQUIRE(it.nodes > 0);
+			REQUIRE(it.nps > 0);
+			REQUIRE(it.nps >= it.nodes * 1000 / (it.time + 1));
+		}
+	}
+
+	SECTION("Root moves are reported once the delay has passed") {
+		Engine engine{2};
+		engine.setPosition(board);
+
+		std::vector<Move> moves;
+		std::vector<int> numbers;
+
+		engine.setCurrentMoveHandler([&](Move move, int number) {
+			moves.push_back(move);
+			numbers.push_back(number);
+		}, std::chrono::milliseconds(0));
+
+		Evaluation eval;
+		REQUIRE(engine.poll(eval));
+
+		// Every legal move of each iteration, numbered from one
+		REQUIRE(moves.size() == 2 * 20);
+
+		for (size_t i = 0; i < numbers.size(); ++i)
+			REQUIRE(numbers[i] == static_cast<int>(i % 20) + 1);
+
+		std::vector<Move> first(moves.begin(), moves.begin() + 20);
+		REQUIRE(std::find(first.begin(), first.end(), Move(G1, F3)) != first.end());
+		REQUIRE(std::find(first.begin(), first.end(), Move(E2, E4)) != first.end());
+
+		// Long delay, nothing is reported by a short search
+		moves.clear();
+		engine.setCurrentMoveHandler([&](Move move, int) { moves.push_back(move); });
+		REQUIRE(engine.poll(eval));
+		REQUIRE(moves.empty());
+	}
+}
+
+/// Search given position and return the result.
+static Evaluation search(const Board &board, int depth, bool pruning)
+{
+	Engine engine{depth};
+	engine.setPruning(pruning);
+	engine.setPosition(board);
+
+	Evaluation ret;
+	engine.poll(ret);
+	return ret;
+}
+
+TEST_CASE("Pruning")
+{
+	SECTION("Fewer positions are searched") {
+		Board board;
+		board.setStandardPosition();
+		REQUIRE(board.applyMoves({{E2, E4}, {E7, E5}, {G1, F3}, {B8, C6}, {F1, C4}, {G8, F6}}));
+
+		Evaluation pruned = search(board, 5, true);
+		Evaluation full = search(board, 5, false);
+
+		REQUIRE(pruned.total * 2 < full.total);
+	}
+
+	SECTION("Tactics are still found") {
+		// Rxe8+ Rxe8 Rxe8#
+		Board board;
+		board.setSquare(E1, WHITE, ROOK);
+		board.setSquare(E2, WHITE, ROOK);
+		board.setSquare(H8, BLACK, KING);
+		board.setSquare(E8, BLACK, ROOK);
+		board.setSquare(A8, BLACK, ROOK);
+		board.setSquare(H7, BLACK, PAWN);
+		board.setSquare(G7, BLACK, PAWN);
+		board.setSquare(F7, BLACK, PAWN);
+
+		Evaluation pruned = search(board, 5, true);
+		Evaluation full = search(board, 5, false);
+
+		REQUIRE(pruned.total < full.total);
+		REQUIRE(pruned.eval == full.eval);
+		REQUIRE(pruned.continuation == full.continuation);
+	}
+
+	SECTION("Quiet checks near the horizon are searched") {
+		// Kc7 Ka7 Ra2#, the mate being one of many quiet rook and king moves which would
+		// be pruned as late moves of a zero window node if it wasn't a check
+		Board board;
+		board.setSquare(A8, BLACK, KING);
+		board.setSquare(C6, WHITE, KING);
+		board.setSquare(H2, WHITE, ROOK);
+
+		std::vector<SearchInfo> info = searchInfo(board, 3);
+
+		REQUIRE(info.back().mate == 2);
+	}
+}
+
 TEST_CASE("Promote optimally")
 {
 	Board board;
@@ -84,3 +254,305 @@ TEST_CASE("Promote optimally")
 		REQUIRE(bestMoves(board, 1, depth) == MoveList{ {H7, H8, QUEEN}});
 	}
 }
+
+TEST_CASE("Capture en passant")
+{
+	Board board;
+
+	int depth = GENERATE(3, 4);
+
+	SECTION("Free pawn") {
+		board.setSquare(A1, WHITE, KING);
+		board.setSquare(E5, WHITE, PAWN);
+		board.setSquare(H8, BLACK, KING);
+		board.setSquare(D7, BLACK, PAWN);
+
+		board.setCurrent(BLACK);
+		REQUIRE(board.applyMoves({{D7, D5}}));
+
+		REQUIRE(bestMoves(board, 1, depth) == MoveList{{E5, D6}});
+	}
+}
+
+TEST_CASE("Evaluation cache")
+{
+	EvalCache cache(16);
+	int eval = 0;
+
+	SECTION("Stored evaluations are returned") {
+		REQUIRE_FALSE(cache.probe(0, eval));
+
+		cache.store(0, -123);
+		REQUIRE(cache.probe(0, eval));
+		REQUIRE(eval == -123);
+	}
+
+	SECTION("Colliding keys replace each other") {
+		cache.store(1, 10);
+		cache.store(17, 20);
+
+		REQUIRE_FALSE(cache.probe(1, eval));
+		REQUIRE(cache.probe(17, eval));
+		REQUIRE(eval == 20);
+	}
+
+	SECTION("Clearing forgets everything") {
+		cache.store(5, 10);
+		cache.clear();
+		REQUIRE_FALSE(cache.probe(5, eval));
+	}
+}
+
+TEST_CASE("Transposition table")
+{
+	TranspositionTable table(16);
+	TableEntry entry;
+
+	SECTION("Deeper results of the current search are kept") {
+		table.store(1, Move(E2, E4), 10, 5, BOUND_EXACT);
+		table.store(17, Move(D2, D4), 20, 3, BOUND_EXACT);
+
+		REQUIRE(table.probe(1, entry));
+		REQUIRE_FALSE(table.probe(17, entry));
+	}
+
+	SECTION("Results of earlier searches are replaced") {
+		table.store(1, Move(E2, E4), 10, 5, BOUND_EXACT);
+		table.newSearch();
+
+		REQUIRE(table.probe(1, entry));
+		REQUIRE(entry.eval == 10);
+
+		table.store(17, Move(D2, D4), 20, 3, BOUND_EXACT);
+
+		REQUIRE_FALSE(table.probe(1, entry));
+		REQUIRE(table.probe(17, entry));
+		REQUIRE(TranspositionTable::unpackMove(entry.move) == Move(D2, D4));
+	}
+
+	SECTION("Hashfull counts entries of the current search") {
+		REQUIRE(table.getHashfull() == 0);
+
+		for (uint64_t key = 0; key < 8; ++key)
+			table.store(key, Move(), 0, 1, BOUND_LOWER);
+
+		REQUIRE(table.getHashfull() == 500);
+
+		table.newSearch();
+		REQUIRE(table.getHashfull() == 0);
+	}
+
+	SECTION("Resizing forgets everything") {
+		table.store(1, Move(E2, E4), 10, 5, BOUND_EXACT);
+
+		REQUIRE(table.resize(100, 2));
+		REQUIRE(table.getSize() == 64);
+		REQUIRE_FALSE(table.probe(1, entry));
+	}
+
+	SECTION("Size in megabytes fits the entries") {
+		REQUIRE(table.resizeMegabytes(3));
+		REQUIRE(table.getSize() * TranspositionTable::entryBytes == 2 * 1024 * 1024);
+
+		REQUIRE(table.resizeMegabytes(0));
+		REQUIRE(table.getSize() == 1);
+	}
+
+	SECTION("Tables in the same shared memory share entries") {
+		std::string name = "/vimlock-test-" + std::to_string(getpid());
+
+		TranspositionTable other(1024);
+
+		REQUIRE(table.attach(name, 32));
+		REQUIRE(other.attach(name, 1024));
+		REQUIRE(TranspositionTable::removeShared(name));
+
+		// Size comes from whoever created the segment
+		REQUIRE(table.isShared());
+		REQUIRE(other.getSize() == 32);
+
+		table.store(5, Move(E2, E4), 10, 3, BOUND_EXACT);
+		REQUIRE(other.probe(5, entry));
+		REQUIRE(entry.eval == 10);
+
+		// Back to a table of our own
+		REQUIRE(other.resize(16));
+		REQUIRE_FALSE(other.isShared());
+		REQUIRE_FALSE(other.probe(5, entry));
+	}
+
+	SECTION("Tables in the same shared memory agree on the current search") {
+		std::string name = "/vimlock-test-generation-" + std::to_string(getpid());
+
+		TranspositionTable other(16);
+
+		REQUIRE(table.attach(name, 16));
+		table.newSearch();
+		table.newSearch();
+
+		REQUIRE(other.attach(name, 16));
+		REQUIRE(TranspositionTable::removeShared(name));
+		other.newSearch();
+
+		// Entries of the other process are current, so its deeper ones are kept
+		table.store(1, Move(E2, E4), 10, 5, BOUND_EXACT);
+		other.store(17, Move(D2, D4), 20, 3, BOUND_EXACT);
+
+		REQUIRE(other.probe(1, entry));
+		REQUIRE(entry.eval == 10);
+		REQUIRE_FALSE(table.probe(17, entry));
+
+		other.store(2, Move(D2, D4), 20, 5, BOUND_EXACT);
+		table.store(18, Move(E2, E4), 10, 3, BOUND_EXACT);
+
+		REQUIRE(table.probe(2, entry));
+		REQUIRE(entry.eval == 20);
+
+		REQUIRE(table.getHashfull() == other.getHashfull());
+		REQUIRE(table.getHashfull() > 0);
+	}
+
+	SECTION("Clearing in parallel forgets everything") {
+		for (uint64_t key = 0; key < 16; ++key)
+			table.store(key, Move(), 0, 1, BOUND_LOWER);
+
+		table.clear(3);
+
+		for (uint64_t key = 0; key < 16; ++key)
+			REQUIRE_FALSE(table.probe(key, entry));
+	}
+}
+
+TEST_CASE("Large buffer")
+{
+	LargeBuffer buffer;
+
+	REQUIRE(buffer.allocate(LargeBuffer::pageSize + 1, 2));
+	REQUIRE(buffer.getSize() == 2 * LargeBuffer::pageSize);
+	REQUIRE(reinterpret_cast<uintptr_t>(buffer.getData()) % LargeBuffer::pageSize == 0);
+
+	unsigned char *data = static_cast<unsigned char *>(buffer.getData());
+	REQUIRE(std::count(data, data + buffer.getSize(), 0) == static_cast<long>(buffer.getSize()));
+
+	std::fill(data, data + buffer.getSize(), 0xFF);
+	buffer.clear(3);
+	REQUIRE(std::count(data, data + buffer.getSize(), 0) == static_cast<long>(buffer.getSize()));
+}
+
+TEST_CASE("Search results are kept within a game")
+{
+	Board board;
+	board.setStandardPosition();
+	REQUIRE(board.applyMoves({{E2, E4}, {E7, E5}, {G1, F3}, {B8, C6}}));
+
+	Engine engine{4};
+	engine.setPosition(board);
+
+	Evaluation first;
+	REQUIRE(engine.poll(first));
+
+	// Same position again starts from what the previous search left
+	Evaluation second;
+	REQUIRE(engine.poll(second));
+	REQUIRE(second.total < first.total);
+
+	// New game starts from scratch
+	engine.newGame();
+
+	Evaluation third;
+	REQUIRE(engine.poll(third));
+	REQUIRE(third.total == first.total);
+	REQUIRE(third.best == first.best);
+}
+
+/// File in the temporary directory, removed when going out of scope.
+struct TempFile
+{
+	explicit TempFile(const std::string &name)
+	{
+		const char *dir = getenv("TMPDIR");
+		path = std::string(dir && *dir ? dir : "/tmp") + "/" + name;
+	}
+
+	~TempFile()
+	{
+		remove(path.c_str());
+	}
+
+	std::string path;
+};
+
+TEST_CASE("Analysis file")
+{
+	TempFile file("vimlock-test-analysis-" + std::to_string(getpid()) + ".tt");
+
+	Board board;
+	board.setStandardPosition();
+	REQUIRE(board.applyMoves({{E2, E4}, {E7, E5}, {G1, F3}, {B8, C6}}));
+
+	Evaluation first;
+
+	{
+		Engine engine{4};
+		REQUIRE(engine.setAnalysisFile(file.path));
+
+		engine.setPosition(board);
+		REQUIRE(engine.poll(first));
+		REQUIRE(first.total > 0);
+	}
+
+	// Another run finds the result without searching, and reports it like a search
+	Engine engine{4};
+	REQUIRE(engine.setAnalysisFile(file.path));
+
+	std::vector<SearchInfo> info;
+	engine.setIterationHandler([&info](const SearchInfo &it) { info.push_back(it); });
+	engine.setPosition(board);
+
+	Evaluation second;
+	REQUIRE(engine.poll(second));
+	REQUIRE(second.total == 0);
+	REQUIRE(second.best == first.best);
+	REQUIRE(second.eval == first.eval);
+
+	REQUIRE(info.size() == 1);
+	REQUIRE(info.back().depth >= 4);
+	REQUIRE(info.back().eval == first.eval);
+	REQUIRE(info.back().nps == 0);
+	REQUIRE(info.back().continuation == MoveList{first.best});
+
+	// Stored move isn't played if it repeats a position of the game
+	Board endgame;
+	REQUIRE(endgame.fromFen("8/8/8/4k3/8/8/8/R3K3 w - - 10 40"));
+
+	Evaluation stored;
+	engine.setPosition(endgame);
+	REQUIRE(engine.poll(stored));
+
+	Board next = endgame;
+	REQUIRE(next.applyMoves({stored.best}));
+
+	Engine repeating{4};
+	REQUIRE(repeating.setAnalysisFile(file.path));
+
+	repeating.setPosition(endgame);
+
+	Evaluation third;
+	REQUIRE(repeating.poll(third));
+	REQUIRE(third.total == 0);
+
+	repeating.setPosition(endgame, {next.getKey()});
+
+	REQUIRE(repeating.poll(third));
+	REQUIRE(third.total > 0);
+
+	// Deeper search than stored still searches
+	Engine deeper{5};
+	REQUIRE(deeper.setAnalysisFile(file.path));
+
+	deeper.setPosition(board);
+
+	Evaluation fourth;
+	REQUIRE(deeper.poll(fourth));
+	REQUIRE(fourth.total > 0);
+}
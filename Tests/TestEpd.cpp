@@ -0,0 +1,57 @@
+#include <catch2/catch.hpp>
+#include "Epd.h"
+
+#include <cstdio>
+
+using namespace vimlock;
+
+TEST_CASE("EPD file")
+{
+	const std::string path = "TestEpd.epd";
+
+	FILE *file = fopen(path.c_str(), "w");
+	REQUIRE(file);
+
+	for (int i = 0; i < 100; ++i) {
+		fprintf(file, "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 bm e5; id \"line %d\"; c0 \"a; b\";\n", i);
+		fputs("\n", file);
+		fputs("not a position\n", file);
+		fprintf(file, "4k3/8/8/8/8/8/8/4K3 w - - %d 60\r\n", i);
+	}
+
+	fclose(file);
+
+	EpdFile epd;
+	int threads = GENERATE(1, 3, 7);
+
+	REQUIRE(!epd.load("NoSuchFile.epd", threads));
+	REQUIRE(epd.load(path, threads));
+	REQUIRE(epd.size() == 200);
+	REQUIRE(epd.getSkipped() == 100);
+
+	std::string value;
+
+	for (int i = 0; i < 100; ++i) {
+		const Board &board = epd.getBoard(2 * i);
+		REQUIRE(board.getCurrent() == BLACK);
+		REQUIRE(board.getEnPassantSquares() == Bitboard(E3));
+
+		REQUIRE(epd.getOperation(2 * i, "id", value));
+		REQUIRE(value == "line " + std::to_string(i));
+
+		REQUIRE(epd.getOperation(2 * i, "bm", value));
+		REQUIRE(value == "e5");
+
+		REQUIRE(epd.getOperation(2 * i, "c0", value));
+		REQUIRE(value == "a; b");
+
+		REQUIRE(!epd.getOperation(2 * i, "b", value));
+
+		const Board &ending = epd.getBoard(2 * i + 1);
+		REQUIRE(ending.getHalfmoveClock() == i);
+		REQUIRE(ending.getFullmoveNumber() == 60);
+		REQUIRE(epd.getOperations(2 * i + 1).empty());
+	}
+
+	remove(path.c_str());
+}
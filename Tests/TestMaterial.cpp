@@ -0,0 +1,182 @@
+#include <catch2/catch.hpp>
+#include "Bitbase.h"
+#include "Material.h"
+
+using namespace vimlock;
+
+TEST_CASE("Material key")
+{
+	Board a;
+	Board b;
+
+	a.setStandardPosition();
+	b.setStandardPosition();
+
+	SECTION("Moving pieces keeps the key") {
+		REQUIRE(b.applyMoves({{G1, F3}, {E7, E5}}));
+		REQUIRE(a.getMaterialKey() == b.getMaterialKey());
+	}
+
+	SECTION("Captures change the key") {
+		REQUIRE(b.applyMoves({{E2, E4}, {D7, D5}, {E4, D5}}));
+		REQUIRE(a.getMaterialKey() != b.getMaterialKey());
+	}
+
+	SECTION("Same pieces on different squares give the same key") {
+		a.clear();
+		a.setSquare(E1, WHITE, KING);
+		a.setSquare(A1, WHITE, ROOK);
+		a.setSquare(E8, BLACK, KING);
+
+		b.clear();
+		b.setSquare(H5, BLACK, KING);
+		b.setSquare(C3, WHITE, KING);
+		b.setSquare(D7, WHITE, ROOK);
+
+		REQUIRE(a.getMaterialKey() == b.getMaterialKey());
+	}
+}
+
+TEST_CASE("Endgame recognition")
+{
+	Board board;
+	board.clear();
+	board.setSquare(E1, WHITE, KING);
+	board.setSquare(E8, BLACK, KING);
+
+	MaterialEntry entry;
+
+	SECTION("Lone kings are a draw") {
+		MaterialTable::evaluate(board, entry);
+		REQUIRE(entry.endgame == ENDGAME_DRAW);
+	}
+
+	SECTION("Minor pieces can't mate") {
+		board.setSquare(C1, WHITE, BISHOP);
+		board.setSquare(B8, BLACK, KNIGHT);
+		MaterialTable::evaluate(board, entry);
+		REQUIRE(entry.endgame == ENDGAME_DRAW);
+	}
+
+	SECTION("Rook against lone king") {
+		board.setSquare(A8, BLACK, ROOK);
+		MaterialTable::evaluate(board, entry);
+
+		REQUIRE(entry.endgame == ENDGAME_KXK);
+		REQUIRE(entry.strongSide == BLACK);
+		REQUIRE(entry.evaluate(board) < -KNOWN_WIN_EVAL);
+
+		// Better with the defending king on the edge
+		Board edge = board;
+		edge.setSquare(E1, SquareState());
+		edge.setSquare(A1, WHITE, KING);
+		REQUIRE(entry.evaluate(edge) < entry.evaluate(board));
+	}
+
+	SECTION("Bishops mate only when on both colors") {
+		board.setSquare(C1, WHITE, BISHOP);
+		board.setSquare(F1, WHITE, BISHOP);
+		MaterialTable::evaluate(board, entry);
+
+		REQUIRE(entry.endgame == ENDGAME_KXK);
+		REQUIRE(entry.hasEndgame(board));
+		REQUIRE(entry.evaluate(board) > KNOWN_WIN_EVAL);
+
+		// Both on dark squares, e.g. after promoting to a bishop
+		Board same = board;
+		same.setSquare(F1, SquareState());
+		same.setSquare(E3, WHITE, BISHOP);
+		REQUIRE(same.getMaterialKey() == board.getMaterialKey());
+		REQUIRE_FALSE(entry.hasEndgame(same));
+
+		// Unless a knight helps
+		same.setSquare(B1, WHITE, KNIGHT);
+		MaterialTable::evaluate(same, entry);
+		REQUIRE(entry.endgame == ENDGAME_KXK);
+		REQUIRE(entry.hasEndgame(same));
+	}
+
+	SECTION("Bishop and knight drive the king to the bishop's corner") {
+		board.setSquare(C1, WHITE, BISHOP);
+		board.setSquare(B1, WHITE, KNIGHT);
+		MaterialTable::evaluate(board, entry);
+		REQUIRE(entry.endgame == ENDGAME_KBNK);
+
+		// C1 is dark, so is A1 and H8
+		Board right = board;
+		right.setSquare(E8, SquareState());
+		right.setSquare(H8, BLACK, KING);
+
+		Board wrong = board;
+		wrong.setSquare(E8, SquareState());
+		wrong.setSquare(A8, BLACK, KING);
+
+		REQUIRE(entry.evaluate(right) > entry.evaluate(wrong));
+	}
+
+	SECTION("Unstoppable pawn") {
+		board.setSquare(A6, WHITE, PAWN);
+		MaterialTable::evaluate(board, entry);
+
+		REQUIRE(entry.endgame == ENDGAME_KPK);
+		REQUIRE(entry.evaluate(board) > KNOWN_WIN_EVAL);
+	}
+
+	SECTION("Opposite colored bishops are drawish") {
+		board.setSquare(C1, WHITE, BISHOP);
+		board.setSquare(A2, WHITE, PAWN);
+		board.setSquare(B2, WHITE, PAWN);
+		board.setSquare(C8, BLACK, BISHOP);
+		MaterialTable::evaluate(board, entry);
+
+		REQUIRE(entry.endgame == ENDGAME_NONE);
+		REQUIRE(entry.getScale(board, WHITE) < SCALE_NORMAL);
+
+		// Same colored bishops are not
+		board.setSquare(C8, SquareState());
+		board.setSquare(F8, BLACK, BISHOP);
+		REQUIRE(entry.getScale(board, WHITE) == SCALE_NORMAL);
+	}
+
+	SECTION("Rook against minor piece is hard to win") {
+		board.setSquare(A1, WHITE, ROOK);
+		board.setSquare(B8, BLACK, KNIGHT);
+		MaterialTable::evaluate(board, entry);
+
+		REQUIRE(entry.endgame == ENDGAME_NONE);
+		REQUIRE(entry.getScale(board, WHITE) < SCALE_NORMAL);
+		REQUIRE(entry.getScale(board, BLACK) == 0);
+	}
+}
+
+TEST_CASE("KPK bitbase")
+{
+	SECTION("King in front of the pawn on the 6th rank wins") {
+		REQUIRE(probeKPK(WHITE, Square(E6), Square(E5), Square(E8), WHITE));
+		REQUIRE(probeKPK(WHITE, Square(E6), Square(E5), Square(E8), BLACK));
+	}
+
+	SECTION("Same for black and mirrored files") {
+		REQUIRE(probeKPK(BLACK, Square(D3), Square(D4), Square(D1), WHITE));
+		REQUIRE(probeKPK(BLACK, Square(G3), Square(G4), Square(G1), BLACK));
+	}
+
+	SECTION("Defending king in the corner of a rook pawn draws") {
+		REQUIRE_FALSE(probeKPK(WHITE, Square(C5), Square(A5), Square(A8), WHITE));
+		REQUIRE_FALSE(probeKPK(BLACK, Square(F4), Square(H4), Square(H1), BLACK));
+	}
+
+	SECTION("Unprotected pawn gets captured") {
+		REQUIRE_FALSE(probeKPK(WHITE, Square(A1), Square(H2), Square(H3), BLACK));
+		REQUIRE_FALSE(probeKPK(WHITE, Square(A1), Square(D4), Square(D5), BLACK));
+	}
+
+	SECTION("Opposition decides") {
+		// Kings facing each other, side to move loses the opposition
+		REQUIRE(probeKPK(WHITE, Square(E5), Square(E4), Square(E7), BLACK));
+		REQUIRE_FALSE(probeKPK(WHITE, Square(E5), Square(E4), Square(E7), WHITE));
+
+		// Unless the pawn has a spare tempo
+		REQUIRE(probeKPK(WHITE, Square(E4), Square(E2), Square(E6), WHITE));
+	}
+}
@@ -1,4 +1,5 @@
 #include <catch2/catch.hpp>
+#include "Attacks.h"
 #include "Moves.h"
 #include "Format.h"
 
@@ -451,3 +452,129 @@ TEST_CASE("King in check")
 	}
 }
 #endif
+
+TEST_CASE("Attack tables match set-wise generation")
+{
+	for (uint64_t i = 0; i < 64; ++i) {
+		INFO("square " << Square(i));
+		REQUIRE(getKnightMoves(Square(i)) == getKnightAttacks(Bitboard(Square(i))));
+		REQUIRE(getKingMoves(Square(i)) == getKingAttacks(Bitboard(Square(i))));
+	}
+}
+
+TEST_CASE("Set-wise pawn generation")
+{
+	Board board;
+	board.setStandardPosition();
+	REQUIRE(board.applyMoves({{E2, E4}, {D7, D5}, {A2, A3}, {H7, H5}}));
+
+	Bitboard allPieces = board.getPieces();
+
+	SECTION("Attacks match single pawn attacks") {
+		for (Color color : {WHITE, BLACK}) {
+			Bitboard pawns = board.getPieces(color, PAWN);
+			Bitboard expected;
+
+			while (pawns)
+				expected |= getPawnAttacks(color, pawns.popFirstSquare());
+
+			Bitboard all = board.getPieces(color, PAWN);
+			REQUIRE(expected == (color == WHITE ? getPawnAttacks<WHITE>(all) : getPawnAttacks<BLACK>(all)));
+		}
+	}
+
+	SECTION("Pushes match single pawn moves") {
+		Bitboard pawns = board.getPieces(WHITE, PAWN);
+		Bitboard expected;
+
+		while (pawns)
+			expected |= getPawnMoves(WHITE, pawns.popFirstSquare(), allPieces);
+
+		Bitboard all = board.getPieces(WHITE, PAWN);
+		REQUIRE(expected == (getPawnPushes<WHITE>(all, allPieces) | getPawnDoublePushes<WHITE>(all, allPieces)));
+	}
+
+	SECTION("Double pushes") {
+		Bitboard all = board.getPieces(BLACK, PAWN);
+		REQUIRE(getPawnDoublePushes<BLACK>(all, allPieces).count() == 6);
+		REQUIRE(getPawnDoublePushes<BLACK>(all, allPieces).contains(Square(E5)));
+	}
+
+	SECTION("Captures don't wrap around") {
+		REQUIRE(getPawnAttacksWest<WHITE>(Bitboard(A2)).empty());
+		REQUIRE(getPawnAttacksEast<WHITE>(Bitboard(H2)).empty());
+		REQUIRE(getPawnAttacksWest<BLACK>(Bitboard(A7)).empty());
+		REQUIRE(getPawnAttacksEast<BLACK>(Bitboard(H7)).empty());
+	}
+}
+
+TEST_CASE("Slider attack fills")
+{
+	// Deterministic pseudo random positions
+	uint64_t state = 0x2545F4914F6CDD1DULL;
+	auto random = [&state]() {
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		return state;
+	};
+
+	for (int i = 0; i < 1000; ++i) {
+		Bitboard allPieces(random() & random());
+		Bitboard rooks = allPieces & Bitboard(random() & random() & random());
+		Bitboard bishops = allPieces & Bitboard(random() & random() & random());
+
+		Bitboard expected;
+
+		Bitboard tmp = rooks;
+		while (tmp)
+			expected |= getRookMoves(tmp.popFirstSquare(), allPieces);
+
+		tmp = bishops;
+		while (tmp)
+			expected |= getBishopMoves(tmp.popFirstSquare(), allPieces);
+
+		INFO("pieces\n" << allPieces << "rooks\n" << rooks << "bishops\n" << bishops);
+
+		REQUIRE(getSliderAttacksScalar(rooks, bishops, allPieces) == expected);
+		REQUIRE(getSliderAttacks(rooks, bishops, allPieces) == expected);
+
+		if (hasAvx2())
+			REQUIRE(getSliderAttacksAvx2(rooks, bishops, allPieces) == expected);
+	}
+}
+
+TEST_CASE("Checkers and pinned pieces")
+{
+	Board board;
+	board.clear();
+	board.setSquare(E1, WHITE, KING);
+	board.setSquare(E2, WHITE, KNIGHT);
+	board.setSquare(C3, WHITE, PAWN);
+	board.setSquare(B4, BLACK, BISHOP);
+	board.setSquare(E8, BLACK, ROOK);
+	board.setSquare(F3, BLACK, KNIGHT);
+	board.setSquare(H4, BLACK, BISHOP);
+	board.setSquare(G3, WHITE, PAWN);
+	board.setSquare(F2, WHITE, PAWN);
+
+	AttackInfo info;
+
+	SECTION("Only piece between king and slider is pinned") {
+		REQUIRE(info.getPinned(board) == (Bitboard(E2) | Bitboard(C3)));
+		REQUIRE(info.getCheckers(board) == Bitboard(F3));
+	}
+
+	SECTION("Attack maps match per piece generation") {
+		Bitboard allPieces = board.getPieces();
+		REQUIRE(info.getAttacks(board, BLACK) == getAvailableCaptures(board, allPieces, board.getPieces(BLACK)));
+		REQUIRE(info.getAttacks(board, WHITE) == getAvailableCaptures(board, allPieces, board.getPieces(WHITE)));
+		REQUIRE(info.getAttacks(board, BLACK, BISHOP) == (getBishopMoves(B4, allPieces) | getBishopMoves(H4, allPieces)));
+	}
+
+	SECTION("Between and line") {
+		REQUIRE(getBetween(E1, E8) == (Bitboard::file(FILE_E) & ~Bitboard(E1) & ~Bitboard(E8)));
+		REQUIRE(getBetween(E1, F3).empty());
+		REQUIRE(getLine(B4, E1) == (Bitboard(A5) | Bitboard(B4) | Bitboard(C3) | Bitboard(D2) | Bitboard(E1)));
+	}
+}
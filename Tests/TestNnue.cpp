@@ -0,0 +1,170 @@
+#include <catch2/catch.hpp>
+#include "Nnue.h"
+#include "Sliders.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+using namespace vimlock;
+
+/// Make a pseudo random move for the side to move, never capturing a king.
+/// Returns false if there are no moves.
+static bool randomMove(Board &board, uint64_t &state)
+{
+	auto random = [&state]() {
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		return state;
+	};
+
+	Square sources[16];
+	Bitboard targets[16];
+	int count = 0;
+
+	Bitboard pieces = board.getPieces(board.getCurrent());
+	Bitboard kings = board.getPieces(KING);
+
+	while (pieces) {
+		Square src = pieces.popFirstSquare();
+		Bitboard moves = board.getMoves(src) & ~kings;
+
+		if (moves) {
+			sources[count] = src;
+			targets[count++] = moves;
+		}
+	}
+
+	if (count == 0)
+		return false;
+
+	int i = static_cast<int>(random() % count);
+	Bitboard moves = targets[i];
+
+	for (int skip = static_cast<int>(random() % moves.count()); skip > 0; --skip)
+		moves.popFirstSquare();
+
+	Square dst = moves.findFirstSquare();
+	bool promotion = board.getSquare(sources[i]).getPiece() == PAWN
+		&& (dst.getRank() == RANK_1 || dst.getRank() == RANK_8);
+
+	board.movePiece(sources[i], dst, promotion ? QUEEN : PAWN);
+	board.flipCurrent();
+
+	return true;
+}
+
+static bool sameAccumulator(const Accumulator &a, const Accumulator &b)
+{
+	return std::memcmp(a.values, b.values, sizeof(a.values)) == 0;
+}
+
+TEST_CASE("Network accumulator updates")
+{
+	Network network;
+	network.randomize(1);
+
+	uint64_t state = 0x2545F4914F6CDD1DULL;
+
+	for (int game = 0; game < 10; ++game) {
+		Board board;
+		board.setStandardPosition();
+
+		Accumulator acc;
+		network.refresh(board, WHITE, acc);
+		network.refresh(board, BLACK, acc);
+
+		for (int ply = 0; ply < 100; ++ply) {
+			Board prev = board;
+			if (!randomMove(board, state))
+				break;
+
+			Accumulator fresh;
+			network.refresh(board, WHITE, fresh);
+			network.refresh(board, BLACK, fresh);
+
+			Accumulator scalar;
+			network.updateScalar(prev, board, acc, scalar);
+
+			INFO("game " << game << " ply " << ply);
+			REQUIRE(sameAccumulator(scalar, fresh));
+
+			if (hasAvx2()) {
+				Accumulator avx2;
+				network.updateAvx2(prev, board, acc, avx2);
+				REQUIRE(sameAccumulator(avx2, fresh));
+			}
+
+			acc = scalar;
+		}
+	}
+}
+
+TEST_CASE("Network kernels match scalar reference")
+{
+	Network network;
+	network.randomize(2);
+
+	uint64_t state = 0x9E3779B97F4A7C15ULL;
+
+	Board board;
+	board.setStandardPosition();
+
+	int minEval = 0;
+	int maxEval = 0;
+
+	for (int ply = 0; ply < 200; ++ply) {
+		if (!randomMove(board, state))
+			board.setStandardPosition();
+
+		Accumulator acc;
+		network.refresh(board, WHITE, acc);
+		network.refresh(board, BLACK, acc);
+
+		int eval = network.evaluateScalar(acc, board.getCurrent());
+
+		INFO("ply " << ply);
+		REQUIRE(network.evaluate(acc, board.getCurrent()) == eval);
+
+		if (hasAvx2())
+			REQUIRE(network.evaluateAvx2(acc, board.getCurrent()) == eval);
+
+		minEval = std::min(minEval, eval);
+		maxEval = std::max(maxEval, eval);
+	}
+
+	// Evaluations should not be saturated
+	REQUIRE(minEval < maxEval);
+}
+
+TEST_CASE("Network file round trip")
+{
+	Network network;
+	network.randomize(3);
+
+	Board board;
+	board.setStandardPosition();
+	REQUIRE(board.applyMoves({{E2, E4}, {D7, D5}, {E4, D5}}));
+
+	Accumulator acc;
+	network.refresh(board, WHITE, acc);
+	network.refresh(board, BLACK, acc);
+
+	std::string path = "TestNnue.bin";
+	REQUIRE(network.save(path));
+
+	Network loaded;
+	REQUIRE(loaded.load(path));
+
+	Accumulator loadedAcc;
+	loaded.refresh(board, WHITE, loadedAcc);
+	loaded.refresh(board, BLACK, loadedAcc);
+
+	REQUIRE(sameAccumulator(acc, loadedAcc));
+	REQUIRE(loaded.evaluate(loadedAcc, BLACK) == network.evaluate(acc, BLACK));
+
+	std::remove(path.c_str());
+
+	REQUIRE_FALSE(loaded.load(path));
+}
@@ -0,0 +1,79 @@
+#include <catch2/catch.hpp>
+#include "PawnTable.h"
+
+using namespace vimlock;
+
+TEST_CASE("Pawn structure")
+{
+	Board board;
+	board.clear();
+
+	PawnEntry entry;
+
+	SECTION("Passed pawns") {
+		board.setSquare(D5, WHITE, PAWN);
+		board.setSquare(H2, WHITE, PAWN);
+		board.setSquare(G7, BLACK, PAWN);
+		board.setSquare(A4, BLACK, PAWN);
+
+		PawnTable::evaluate(board, entry);
+
+		REQUIRE(entry.passed[colorIndex(WHITE)] == Bitboard(D5));
+		REQUIRE(entry.passed[colorIndex(BLACK)] == Bitboard(A4));
+	}
+
+	SECTION("Only the front pawn of doubled pawns is passed") {
+		board.setSquare(C4, WHITE, PAWN);
+		board.setSquare(C3, WHITE, PAWN);
+
+		PawnTable::evaluate(board, entry);
+
+		REQUIRE(entry.passed[colorIndex(WHITE)] == Bitboard(C4));
+	}
+
+	SECTION("Weak pawns are penalized") {
+		// Connected pawns against a doubled isolated pair
+		board.setSquare(B3, WHITE, PAWN);
+		board.setSquare(C3, WHITE, PAWN);
+		board.setSquare(F6, BLACK, PAWN);
+		board.setSquare(F5, BLACK, PAWN);
+		board.setSquare(B6, BLACK, PAWN);
+		board.setSquare(C6, BLACK, PAWN);
+
+		PawnTable::evaluate(board, entry);
+
+		REQUIRE(entry.scores[colorIndex(BLACK)].getMidgame() < entry.scores[colorIndex(WHITE)].getMidgame());
+	}
+
+	SECTION("Backward pawn") {
+		board.setSquare(C4, WHITE, PAWN);
+		board.setSquare(D3, WHITE, PAWN);
+		board.setSquare(E5, BLACK, PAWN);
+		board.setSquare(C5, BLACK, PAWN);
+		board.setSquare(D6, BLACK, PAWN);
+
+		PawnEntry advanced;
+		PawnTable::evaluate(board, entry);
+
+		// Moving the pawn next to its neighbour removes the weakness
+		board.setSquare(D3, SquareState());
+		board.setSquare(D4, WHITE, PAWN);
+		PawnTable::evaluate(board, advanced);
+
+		REQUIRE(entry.scores[colorIndex(WHITE)].getMidgame() < advanced.scores[colorIndex(WHITE)].getMidgame());
+	}
+
+	SECTION("Table returns same result as direct evaluation") {
+		board.setStandardPosition();
+
+		PawnTable table;
+		PawnTable::evaluate(board, entry);
+
+		const PawnEntry &cached = table.probe(board);
+
+		REQUIRE(cached.key == board.getPawnKey());
+		REQUIRE(cached.scores[0] == entry.scores[0]);
+		REQUIRE(cached.scores[1] == entry.scores[1]);
+		REQUIRE(&table.probe(board) == &cached);
+	}
+}
@@ -0,0 +1,116 @@
+#include <catch2/catch.hpp>
+#include "Pgn.h"
+
+#include <sstream>
+
+using namespace vimlock;
+
+TEST_CASE("Standard algebraic notation")
+{
+	Board board;
+	board.setStandardPosition();
+
+	Move move;
+
+	SECTION("Pawn and piece moves") {
+		REQUIRE(parseSan(board, "e4", move));
+		REQUIRE(move == Move(E2, E4));
+
+		REQUIRE(parseSan(board, "Nf3", move));
+		REQUIRE(move == Move(G1, F3));
+
+		REQUIRE(!parseSan(board, "e5", move));
+		REQUIRE(!parseSan(board, "Ke2", move));
+		REQUIRE(!parseSan(board, "Xe4", move));
+		REQUIRE(!parseSan(board, "", move));
+	}
+
+	SECTION("Captures and suffixes") {
+		REQUIRE(board.applyMoves({{E2, E4}, {D7, D5}}));
+
+		REQUIRE(parseSan(board, "exd5", move));
+		REQUIRE(move == Move(E4, D5));
+
+		REQUIRE(parseSan(board, "Bb5+", move));
+		REQUIRE(move == Move(F1, B5));
+
+		REQUIRE(parseSan(board, "e5!?", move));
+		REQUIRE(move == Move(E4, E5));
+	}
+
+	SECTION("Disambiguation") {
+		REQUIRE(board.applyMoves({{G1, F3}, {A7, A6}, {D2, D4}, {A6, A5}}));
+
+		// Both knights can reach d2
+		REQUIRE(!parseSan(board, "Nd2", move));
+
+		REQUIRE(parseSan(board, "Nbd2", move));
+		REQUIRE(move == Move(B1, D2));
+
+		REQUIRE(parseSan(board, "Nfd2", move));
+		REQUIRE(move == Move(F3, D2));
+	}
+
+	SECTION("Castling") {
+		REQUIRE(board.applyMoves({{E2, E4}, {E7, E5}, {G1, F3}, {B8, C6}, {F1, C4}, {G8, F6}}));
+
+		REQUIRE(parseSan(board, "O-O", move));
+		REQUIRE(move == Move(E1, G1));
+
+		REQUIRE(!parseSan(board, "O-O-O", move));
+	}
+
+	SECTION("Promotion") {
+		board.clear();
+		board.setSquare(E1, WHITE, KING);
+		board.setSquare(B7, WHITE, PAWN);
+		board.setSquare(H8, BLACK, KING);
+		board.setSquare(A8, BLACK, ROOK);
+
+		REQUIRE(parseSan(board, "b8=Q+", move));
+		REQUIRE(move == Move(B7, B8, QUEEN));
+
+		REQUIRE(parseSan(board, "bxa8N", move));
+		REQUIRE(move == Move(B7, A8, KNIGHT));
+
+		REQUIRE(!parseSan(board, "b8", move));
+	}
+}
+
+TEST_CASE("PGN reader")
+{
+	std::istringstream stream(
+		"[Event \"Test\"]\n"
+		"[Result \"1-0\"]\n"
+		"\n"
+		"1. e4 {best by test\n"
+		"spanning lines} e5 (1... c5 2. Nf3) 2.Nf3 $1 Nc6 ; rest of line\n"
+		"3. Bb5 a6 1-0\n"
+		"\n"
+		"[Event \"Second\"]\n"
+		"[FEN \"8/8/8/8/8/8/8/K6k w - - 0 1\"]\n"
+		"\n"
+		"1. d4 d5 1/2-1/2\n"
+		"\n"
+		"1. c4 *\n");
+
+	PgnReader reader(stream);
+	PgnGame game;
+
+	REQUIRE(reader.readGame(game));
+	REQUIRE(game.tags["Event"] == "Test");
+	REQUIRE(game.result == RESULT_WHITE_WINS);
+	REQUIRE(game.moves == std::vector<std::string>{"e4", "e5", "Nf3", "Nc6", "Bb5", "a6"});
+
+	REQUIRE(reader.readGame(game));
+	REQUIRE(game.tags.count("FEN"));
+	REQUIRE(game.result == RESULT_DRAW);
+	REQUIRE(game.moves == std::vector<std::string>{"d4", "d5"});
+
+	REQUIRE(reader.readGame(game));
+	REQUIRE(game.tags.empty());
+	REQUIRE(game.result == RESULT_UNKNOWN);
+	REQUIRE(game.moves == std::vector<std::string>{"c4"});
+
+	REQUIRE(!reader.readGame(game));
+}
@@ -0,0 +1,771 @@
+#include <catch2/catch.hpp>
+#include "Dtm.h"
+#include "Engine.h"
+#include "Syzygy.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace vimlock;
+
+/// Write a WDL table where all positions have the same value for each side to move.
+/// Values are WDL + 2, pieces are the three pieces of the table as stored in the file.
+static void writeSingleValueTable(const std::string &path, const uint8_t pieces[3], uint8_t whiteValue, uint8_t blackValue)
+{
+	uint8_t data[80] = {
+		0xD7, 0x66, 0x0C, 0xA5,        // magic
+		0x01,                          // split by side to move, no pawns
+		0x00,                          // order of the groups
+		pieces[0], pieces[1], pieces[2],
+		0x00,                          // alignment
+		0x80, whiteValue,              // single value, white to move
+		0x80, blackValue,              // single value, black to move
+	};
+
+	FILE *file = fopen(path.c_str(), "wb");
+	REQUIRE(file);
+	REQUIRE(fwrite(data, 1, sizeof(data), file) == sizeof(data));
+	fclose(file);
+}
+
+/// Compressed values of a subtable, in the sections they are stored in the file.
+struct Subtable
+{
+	std::vector<uint8_t> sizes;
+	std::vector<uint8_t> sparseIndex;
+	std::vector<uint8_t> blockLength;
+	std::vector<uint8_t> data;
+};
+
+static void appendLe16(std::vector<uint8_t> &out, unsigned value)
+{
+	out.push_back(value & 0xFF);
+	out.push_back((value >> 8) & 0xFF);
+}
+
+static void appendLe32(std::vector<uint8_t> &out, uint32_t value)
+{
+	appendLe16(out, value & 0xFFFF);
+	appendLe16(out, value >> 16);
+}
+
+/// Compress values like the Syzygy generator: frequent pairs of symbols are replaced by
+/// new symbols, which are stored with canonical Huffman codes in blocks of fixed size.
+static Subtable compressPairs(const std::vector<uint8_t> &values, uint8_t flags)
+{
+	constexpr int blockBits = 6;
+	constexpr int spanBits = 5;
+	constexpr size_t blockSize = 1 << blockBits;
+	constexpr uint64_t span = 1 << spanBits;
+
+	// Left and right child of each symbol, leaves have the value and 0xFFF
+	std::vector<int> left;
+	std::vector<int> right;
+	std::vector<int> length;
+	std::vector<int> sequence;
+
+	std::map<uint8_t, int> leaves;
+
+	for (uint8_t value : values) {
+		if (!leaves.count(value)) {
+			leaves[value] = static_cast<int>(left.size());
+			left.push_back(value);
+			right.push_back(0xFFF);
+			length.push_back(1);
+		}
+
+		sequence.push_back(leaves[value]);
+	}
+
+	for (int round = 0; round < 8; ++round) {
+		std::map<std::pair<int, int>, int> counts;
+
+		for (size_t i = 0; i + 1 < sequence.size(); ++i)
+			counts[{ sequence[i], sequence[i + 1] }]++;
+
+		std::pair<int, int> best;
+		int bestCount = 3;
+
+		for (const auto &it : counts) {
+			if (it.second > bestCount && length[it.first.first] + length[it.first.second] <= 256) {
+				best = it.first;
+				bestCount = it.second;
+			}
+		}
+
+		if (bestCount == 3)
+			break;
+
+		int symbol = static_cast<int>(left.size());
+		left.push_back(best.first);
+		right.push_back(best.second);
+		length.push_back(length[best.first] + length[best.second]);
+
+		std::vector<int> next;
+
+		for (size_t i = 0; i < sequence.size(); ++i) {
+			if (i + 1 < sequence.size() && sequence[i] == best.first && sequence[i + 1] == best.second) {
+				next.push_back(symbol);
+				++i;
+			}
+			else
+				next.push_back(sequence[i]);
+		}
+
+		sequence.swap(next);
+	}
+
+	int symbols = static_cast<int>(left.size());
+
+	// Huffman code lengths of the symbols left in the sequence
+	std::vector<uint64_t> weights(symbols);
+	for (int symbol : sequence)
+		weights[symbol]++;
+
+	std::vector<int> codeLen(symbols);
+	std::vector<int> parent;
+	std::vector<uint64_t> nodes;
+	std::vector<int> nodeOf(symbols, -1);
+
+	for (int i = 0; i < symbols; ++i) {
+		if (weights[i]) {
+			nodeOf[i] = static_cast<int>(nodes.size());
+			nodes.push_back(weights[i]);
+			parent.push_back(-1);
+		}
+	}
+
+	std::vector<int> active;
+	for (size_t i = 0; i < nodes.size(); ++i)
+		active.push_back(static_cast<int>(i));
+
+	while (active.size() > 1) {
+		std::sort(active.begin(), active.end(), [&nodes](int a, int b) { return nodes[a] > nodes[b]; });
+
+		int a = active.back();
+		active.pop_back();
+		int b = active.back();
+		active.pop_back();
+
+		parent[a] = parent[b] = static_cast<int>(nodes.size());
+		active.push_back(static_cast<int>(nodes.size()));
+		nodes.push_back(nodes[a] + nodes[b]);
+		parent.push_back(-1);
+	}
+
+	for (int i = 0; i < symbols; ++i) {
+		for (int node = nodeOf[i]; node >= 0 && parent[node] >= 0; node = parent[node])
+			codeLen[i]++;
+
+		// Single symbol still needs a bit
+		if (nodeOf[i] >= 0 && codeLen[i] == 0)
+			codeLen[i] = 1;
+	}
+
+	int minLen = 64;
+	int maxLen = 0;
+
+	for (int len : codeLen) {
+		if (len) {
+			minLen = std::min(minLen, len);
+			maxLen = std::max(maxLen, len);
+		}
+	}
+
+	REQUIRE(maxLen <= 32);
+
+	// Symbols with codes numbered from the longest codes, the rest after them
+	std::vector<int> order(symbols);
+	for (int i = 0; i < symbols; ++i)
+		order[i] = i;
+
+	std::stable_sort(order.begin(), order.end(), [&codeLen](int a, int b) {
+		return codeLen[a] > codeLen[b];
+	});
+
+	std::vector<int> number(symbols);
+	for (int i = 0; i < symbols; ++i)
+		number[order[i]] = i;
+
+	int lengths = maxLen - minLen + 1;
+	std::vector<int> lowestSym(lengths);
+	std::vector<uint64_t> base(lengths);
+	std::vector<int> countOfLen(lengths);
+
+	for (int i = 0; i < symbols; ++i) {
+		if (codeLen[i])
+			countOfLen[codeLen[i] - minLen]++;
+	}
+
+	for (int i = lengths - 2; i >= 0; --i) {
+		lowestSym[i] = lowestSym[i + 1] + countOfLen[i + 1];
+		base[i] = (base[i + 1] + countOfLen[i + 1]) / 2;
+	}
+
+	Subtable ret;
+
+	ret.sizes.push_back(flags);
+	ret.sizes.push_back(blockBits);
+	ret.sizes.push_back(spanBits);
+	ret.sizes.push_back(0);
+
+	// Blocks of whole symbols
+	std::vector<uint64_t> blockStarts;
+	std::vector<uint8_t> block(blockSize);
+	size_t bits = blockSize * 8;
+	uint64_t blockValues = 0;
+	uint64_t position = 0;
+
+	auto finishBlock = [&]() {
+		if (blockStarts.empty())
+			return;
+
+		appendLe16(ret.blockLength, static_cast<unsigned>(blockValues - 1));
+		ret.data.insert(ret.data.end(), block.begin(), block.end());
+	};
+
+	for (int symbol : sequence) {
+		int len = codeLen[symbol];
+
+		if (bits + len > blockSize * 8 || blockValues + length[symbol] > 65536) {
+			finishBlock();
+			std::fill(block.begin(), block.end(), 0);
+			blockStarts.push_back(position);
+			bits = 0;
+			blockValues = 0;
+		}
+
+		int i = len - minLen;
+		uint64_t code = base[i] + (number[symbol] - lowestSym[i]);
+
+		for (int b = len - 1; b >= 0; --b, ++bits) {
+			if ((code >> b) & 1)
+				block[bits / 8] |= 0x80 >> (bits % 8);
+		}
+
+		blockValues += length[symbol];
+		position += length[symbol];
+	}
+
+	finishBlock();
+
+	appendLe32(ret.sizes, static_cast<uint32_t>(blockStarts.size()));
+	ret.sizes.push_back(maxLen);
+	ret.sizes.push_back(minLen);
+
+	for (int i = 0; i < lengths; ++i)
+		appendLe16(ret.sizes, lowestSym[i]);
+
+	appendLe16(ret.sizes, symbols);
+
+	for (int i : order) {
+		int l = right[i] == 0xFFF ? left[i] : number[left[i]];
+		int r = right[i] == 0xFFF ? 0xFFF : number[right[i]];
+
+		ret.sizes.push_back(l & 0xFF);
+		ret.sizes.push_back(((l >> 8) & 0xF) | (r & 0xF) << 4);
+		ret.sizes.push_back(r >> 4);
+	}
+
+	if (symbols & 1)
+		ret.sizes.push_back(0);
+
+	// Block and offset of the value in the middle of every span, past the end in the last block
+	for (uint64_t k = 0; k * span < values.size(); ++k) {
+		uint64_t middle = k * span + span / 2;
+		size_t b = std::upper_bound(blockStarts.begin(), blockStarts.end(), middle) - blockStarts.begin() - 1;
+
+		appendLe32(ret.sparseIndex, static_cast<uint32_t>(b));
+		appendLe16(ret.sparseIndex, static_cast<unsigned>(middle - blockStarts[b]));
+	}
+
+	return ret;
+}
+
+/// Write a table file of given header, up to the pieces of each file of the leading
+/// pawn, followed by the subtables in the order they are probed and the DTZ maps.
+static void writeTableFile(const std::string &path, std::vector<uint8_t> out, const std::vector<Subtable> &subtables,
+	const std::vector<uint8_t> &dtzMap)
+{
+	if (out.size() & 1)
+		out.push_back(0);
+
+	for (const Subtable &it : subtables)
+		out.insert(out.end(), it.sizes.begin(), it.sizes.end());
+
+	out.insert(out.end(), dtzMap.begin(), dtzMap.end());
+
+	if (out.size() & 1)
+		out.push_back(0);
+
+	for (const Subtable &it : subtables)
+		out.insert(out.end(), it.sparseIndex.begin(), it.sparseIndex.end());
+
+	for (const Subtable &it : subtables)
+		out.insert(out.end(), it.blockLength.begin(), it.blockLength.end());
+
+	for (const Subtable &it : subtables) {
+		out.resize((out.size() + 63) / 64 * 64);
+		out.insert(out.end(), it.data.begin(), it.data.end());
+	}
+
+	// Checksum at the end, which blocks may be read past into
+	out.resize((out.size() + 63) / 64 * 64 + 16);
+
+	FILE *file = fopen(path.c_str(), "wb");
+	REQUIRE(file);
+	REQUIRE(fwrite(out.data(), 1, out.size(), file) == out.size());
+	fclose(file);
+}
+
+/// Piece codes of the tables, black pieces have bit 3 set.
+enum
+{
+	CODE_PAWN = 1,
+	CODE_ROOK = 4,
+	CODE_KING = 6,
+	CODE_BLACK = 8
+};
+
+/// Index of a position of three pieces, one of them the white pawn if there are any,
+/// as the Syzygy tables encode it. Pieces are the codes in the order of the subtable and
+/// the leading group is stored at `leadOrder`. Sets `file` to the file of the leading
+/// pawn, mirrored to A-D, or to zero without pawns.
+static uint64_t getSyzygyIndex(const Board &board, const int pieces[3], int leadOrder, int &file)
+{
+	int squares[3];
+
+	for (int i = 0; i < 3; ++i) {
+		Color color = pieces[i] & CODE_BLACK ? BLACK : WHITE;
+		Piece piece = (pieces[i] & 7) == CODE_PAWN ? PAWN : (pieces[i] & 7) == CODE_ROOK ? ROOK : KING;
+		squares[i] = static_cast<int>(board.getPieces(color, piece).findFirstSquare().getIndex());
+	}
+
+	auto rank = [](int square) { return square / 8; };
+	auto below = [](int square) { return square / 8 < square % 8; };
+	auto onDiagonal = [](int square) { return square / 8 == square % 8; };
+
+	// Leading piece mirrored to files A-D
+	if (squares[0] % 8 > 3) {
+		for (int &it : squares)
+			it ^= 7;
+	}
+
+	file = 0;
+
+	if (pieces[0] == CODE_PAWN) {
+		file = squares[0] % 8;
+		// Each group alone, the leading pawn by its rank and the rest skipping taken squares
+		uint64_t groups[3] = {
+			static_cast<uint64_t>(rank(squares[0]) - 1),
+			static_cast<uint64_t>(squares[1] - (squares[0] < squares[1])),
+			static_cast<uint64_t>(squares[2] - (squares[0] < squares[2]) - (squares[1] < squares[2]))
+		};
+
+		const uint64_t sizes[3] = { 6, 63, 62 };
+
+		uint64_t idx = 0;
+		uint64_t multiplier = 1;
+		int next = 1;
+
+		for (int k = 0; k < 3; ++k) {
+			int group = k == leadOrder ? 0 : next++;
+			idx += groups[group] * multiplier;
+			multiplier *= sizes[group];
+		}
+
+		return idx;
+	}
+
+	// Without pawns also mirrored to ranks 1-4, and below the diagonal
+	if (rank(squares[0]) > 3) {
+		for (int &it : squares)
+			it ^= 56;
+	}
+
+	for (int i = 0; i < 3; ++i) {
+		if (onDiagonal(squares[i]))
+			continue;
+
+		if (!below(squares[i])) {
+			for (int &it : squares)
+				it = (it % 8) * 8 + it / 8;
+		}
+
+		break;
+	}
+
+	// Squares of the A1-D1-D4 triangle below the diagonal, then on it; and below the diagonal
+	const int triangle[] = { B1, C1, D1, C2, D2, D3, A1, B2, C3, D4 };
+	int triangleIdx = static_cast<int>(std::find(std::begin(triangle), std::end(triangle), squares[0]) - std::begin(triangle));
+
+	int belowIdx[64] = {};
+	for (int s = 0, n = 0; s < 64; ++s) {
+		if (below(s))
+			belowIdx[s] = n++;
+	}
+
+	int adjust1 = squares[1] > squares[0];
+	int adjust2 = (squares[2] > squares[0]) + (squares[2] > squares[1]);
+
+	if (!onDiagonal(squares[0]))
+		return (triangleIdx * 63 + squares[1] - adjust1) * 62 + squares[2] - adjust2;
+	else if (!onDiagonal(squares[1]))
+		return (6 * 63 + rank(squares[0]) * 28 + belowIdx[squares[1]]) * 62 + squares[2] - adjust2;
+	else if (!onDiagonal(squares[2]))
+		return 6 * 63 * 62 + 4 * 28 * 62 + rank(squares[0]) * 7 * 28 + (rank(squares[1]) - adjust1) * 28 + belowIdx[squares[2]];
+
+	return 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28 + rank(squares[0]) * 7 * 6 + (rank(squares[1]) - adjust1) * 6 + rank(squares[2]) - adjust2;
+}
+
+/// Result of a generated position from the perspective of the side to move.
+static Wdl getDtmWdl(uint8_t value)
+{
+	return value == DTM_DRAW ? WDL_DRAW : isDtmWin(value) ? WDL_WIN : WDL_LOSS;
+}
+
+/// Layout of the subtables of a three piece table.
+struct TableLayout
+{
+	std::string name;
+	bool pawns;
+
+	/// Pieces and position of the leading group, for each side to move stored.
+	int pieces[2][3];
+	int leadOrder[2];
+	int sides;
+};
+
+/// Collect values of the subtables from the generated table, by side to move and file of
+/// the leading pawn. `getValue` returns the stored value, or -1 if any value will do.
+template<typename GetValue>
+static std::vector<std::vector<uint8_t>> collectValues(const DtmGenerator &generator, const TableLayout &layout, GetValue getValue)
+{
+	int files = layout.pawns ? 4 : 1;
+	size_t size = layout.pawns ? 6 * 63 * 62 : 31332;
+
+	std::vector<std::vector<int>> values(2 * files, std::vector<int>(size, -1));
+
+	DtmIndex index;
+	REQUIRE(index.parse(layout.name));
+
+	for (uint64_t i = 0; i < index.getSize(); ++i) {
+		Board board;
+		uint8_t value;
+
+		if (!index.getBoard(i, board) || !generator.probe(board, value) || value == DTM_INVALID)
+			continue;
+
+		int side = board.getCurrent() == WHITE ? 0 : 1;
+		if (side >= layout.sides)
+			continue;
+
+		int stored = getValue(board, value);
+		if (stored < 0)
+			continue;
+
+		int file;
+		uint64_t idx = getSyzygyIndex(board, layout.pieces[side], layout.leadOrder[side], file);
+		REQUIRE(idx < size);
+
+		// Symmetric positions have the same index
+		int &it = values[file * 2 + side][idx];
+		if (it >= 0 && it != stored)
+			FAIL(layout.name << " conflicting values at index " << idx);
+
+		it = stored;
+	}
+
+	std::vector<std::vector<uint8_t>> ret;
+
+	for (int f = 0; f < files; ++f) {
+		for (int side = 0; side < layout.sides; ++side) {
+			std::vector<uint8_t> subtable;
+
+			// Unused indices continue the previous value, as it compresses best
+			for (int value : values[f * 2 + side])
+				subtable.push_back(value >= 0 ? value : subtable.empty() ? 0 : subtable.back());
+
+			ret.push_back(subtable);
+		}
+	}
+
+	return ret;
+}
+
+/// Header of a table up to the pieces.
+static std::vector<uint8_t> getTableHeader(const TableLayout &layout, bool dtz)
+{
+	std::vector<uint8_t> ret;
+
+	if (dtz)
+		ret.insert(ret.end(), { 0x71, 0xE8, 0x23, 0x5D });
+	else
+		ret.insert(ret.end(), { 0xD7, 0x66, 0x0C, 0xA5 });
+
+	ret.push_back((layout.sides == 2 ? 1 : 0) | (layout.pawns ? 2 : 0));
+
+	for (int f = 0; f < (layout.pawns ? 4 : 1); ++f) {
+		ret.push_back(layout.leadOrder[0] | (layout.sides == 2 ? layout.leadOrder[1] : 0) << 4);
+
+		for (int k = 0; k < 3; ++k)
+			ret.push_back(layout.pieces[0][k] | (layout.sides == 2 ? layout.pieces[1][k] : 0) << 4);
+	}
+
+	return ret;
+}
+
+/// Write WDL table of the material from the values of the generator.
+static void writeWdlTable(const std::string &path, const DtmGenerator &generator, const TableLayout &layout)
+{
+	auto values = collectValues(generator, layout, [](const Board &, uint8_t value) {
+		return getDtmWdl(value) + 2;
+	});
+
+	std::vector<Subtable> subtables;
+	for (const std::vector<uint8_t> &it : values)
+		subtables.push_back(compressPairs(it, 0));
+
+	writeTableFile(path, getTableHeader(layout, false), subtables, {});
+}
+
+/// Write DTZ table of a material without pawns or captures by the winning side, where
+/// DTZ is the distance to mate. Only white to move is stored, through a map of values.
+static void writeDtzTable(const std::string &path, const DtmGenerator &generator, const TableLayout &layout)
+{
+	constexpr uint8_t FLAG_MAPPED = 2;
+
+	// Wins stored in moves, as the number of plies is odd
+	std::vector<int> wins;
+
+	collectValues(generator, layout, [&wins](const Board &, uint8_t value) {
+		if (getDtmWdl(value) == WDL_WIN)
+			wins.push_back(getDtmPlies(value) / 2);
+		return -1;
+	});
+
+	std::sort(wins.begin(), wins.end());
+	wins.erase(std::unique(wins.begin(), wins.end()), wins.end());
+	REQUIRE(wins.size() < 256);
+
+	auto values = collectValues(generator, layout, [&wins](const Board &, uint8_t value) {
+		if (getDtmWdl(value) != WDL_WIN)
+			return -1;
+		return static_cast<int>(std::lower_bound(wins.begin(), wins.end(), getDtmPlies(value) / 2) - wins.begin());
+	});
+
+	// Maps of wins, losses, cursed wins and blessed losses
+	std::vector<uint8_t> map;
+	map.push_back(static_cast<uint8_t>(wins.size()));
+	map.insert(map.end(), wins.begin(), wins.end());
+	map.insert(map.end(), { 0, 0, 0 });
+
+	writeTableFile(path, getTableHeader(layout, true), { compressPairs(values[0], FLAG_MAPPED) }, map);
+}
+
+/// Same position with colors swapped and the board flipped vertically.
+static Board flipColors(const Board &board)
+{
+	Board ret;
+	ret.clear();
+
+	Bitboard pieces = board.getPieces();
+	while (pieces) {
+		Square square = pieces.popFirstSquare();
+		SquareState state = board.getSquare(square);
+
+		ret.setSquare(Square(square.getIndex() ^ 56), flipColor(state.getColor()), state.getPiece());
+	}
+
+	ret.setCurrent(flipColor(board.getCurrent()));
+	return ret;
+}
+
+TEST_CASE("Syzygy tablebases", "[syzygy]")
+{
+	const std::string directory = "TestSyzygy";
+
+	mkdir(directory.c_str(), 0755);
+
+	// King, queen and king for both sides to move
+	const uint8_t kqk[3] = { 0x66, 0x55, 0xEE };
+	writeSingleValueTable(directory + "/KQvK.rtbw", kqk, 4, 0);
+
+	// Invalid file
+	FILE *file = fopen((directory + "/KRvK.rtbw").c_str(), "wb");
+	REQUIRE(file);
+	fputs("not a table", file);
+	fclose(file);
+
+	Tablebases tablebases;
+	Board board;
+
+	SECTION("Missing directory") {
+		REQUIRE(tablebases.setPath("NoSuchDirectory") == 0);
+		REQUIRE(tablebases.getMaxPieces() == 0);
+
+		board.setSquare(E1, WHITE, KING);
+		board.setSquare(E8, BLACK, KING);
+		REQUIRE(!tablebases.canProbe(board));
+	}
+
+	SECTION("Probing") {
+		REQUIRE(tablebases.setPath("NoSuchDirectory:" + directory) == 2);
+		REQUIRE(tablebases.getMaxPieces() == 3);
+
+		Wdl wdl;
+		int dtz;
+
+		board.setSquare(E1, WHITE, KING);
+		board.setSquare(D4, WHITE, QUEEN);
+		board.setSquare(E8, BLACK, KING);
+		REQUIRE(tablebases.canProbe(board));
+
+		REQUIRE(tablebases.probeWdl(board, wdl));
+		REQUIRE(wdl == WDL_WIN);
+
+		board.setCurrent(BLACK);
+		REQUIRE(tablebases.probeWdl(board, wdl));
+		REQUIRE(wdl == WDL_LOSS);
+
+		// Missing DTZ table
+		REQUIRE(!tablebases.probeDtz(board, dtz));
+
+		// Colors swapped
+		board.clear();
+		board.setSquare(E1, WHITE, KING);
+		board.setSquare(D5, BLACK, QUEEN);
+		board.setSquare(E8, BLACK, KING);
+		board.setCurrent(BLACK);
+		REQUIRE(tablebases.probeWdl(board, wdl));
+		REQUIRE(wdl == WDL_WIN);
+
+		// Capturing the queen draws, regardless of what the table says
+		board.clear();
+		board.setSquare(A1, WHITE, KING);
+		board.setSquare(D4, WHITE, QUEEN);
+		board.setSquare(E5, BLACK, KING);
+		board.setCurrent(BLACK);
+		REQUIRE(tablebases.probeWdl(board, wdl));
+		REQUIRE(wdl == WDL_DRAW);
+
+		REQUIRE(tablebases.probeDtz(board, dtz));
+		REQUIRE(dtz == 0);
+
+		// Invalid table
+		board.clear();
+		board.setSquare(E1, WHITE, KING);
+		board.setSquare(A2, WHITE, ROOK);
+		board.setSquare(E8, BLACK, KING);
+		REQUIRE(!tablebases.probeWdl(board, wdl));
+
+		// Table not found
+		board.setSquare(B2, WHITE, BISHOP);
+		REQUIRE(!tablebases.canProbe(board));
+		REQUIRE(!tablebases.probeWdl(board, wdl));
+	}
+
+	SECTION("Wins are reported in centipawns") {
+		Engine engine{2};
+		REQUIRE(engine.setSyzygyPath(directory) == 2);
+
+		board.setSquare(E1, WHITE, KING);
+		board.setSquare(D4, WHITE, QUEEN);
+		board.setSquare(E8, BLACK, KING);
+
+		std::vector<SearchInfo> info;
+		engine.setIterationHandler([&info](const SearchInfo &it) { info.push_back(it); });
+		engine.setPosition(board);
+
+		Evaluation eval;
+		REQUIRE(engine.poll(eval));
+
+		// Beyond any material, but not a checkmate
+		REQUIRE(!info.empty());
+		REQUIRE(info.back().mate == 0);
+		REQUIRE(info.back().eval > 10000);
+		REQUIRE(info.back().eval < 20000);
+	}
+
+	unlink((directory + "/KQvK.rtbw").c_str());
+	unlink((directory + "/KRvK.rtbw").c_str());
+	rmdir(directory.c_str());
+}
+
+TEST_CASE("Syzygy tables of generated endgames", "[syzygy]")
+{
+	const std::string directory = "TestSyzygyDtm";
+
+	mkdir(directory.c_str(), 0755);
+
+	DtmGenerator generator(2);
+	REQUIRE(generator.generate("KRvK"));
+	REQUIRE(generator.generate("KPvK"));
+
+	const int king = CODE_KING;
+	const int rook = CODE_ROOK;
+	const int pawn = CODE_PAWN;
+	const int blackKing = CODE_KING | CODE_BLACK;
+
+	// Pieces in a different order for each side to move, and the pawn encoded last for black
+	TableLayout krk = { "KRvK", false, { { king, rook, blackKing }, { blackKing, king, rook } }, { 0, 0 }, 2 };
+	TableLayout krkDtz = { "KRvK", false, { { rook, king, blackKing }, {} }, { 0, 0 }, 1 };
+	TableLayout kpk = { "KPvK", true, { { pawn, king, blackKing }, { pawn, blackKing, king } }, { 0, 2 }, 2 };
+
+	writeWdlTable(directory + "/KRvK.rtbw", generator, krk);
+	writeDtzTable(directory + "/KRvK.rtbz", generator, krkDtz);
+	writeWdlTable(directory + "/KPvK.rtbw", generator, kpk);
+
+	Tablebases tablebases;
+	REQUIRE(tablebases.setPath(directory) == 2);
+
+	for (const char *name : { "KRvK", "KPvK" }) {
+		DtmIndex index;
+		REQUIRE(index.parse(name));
+
+		bool dtz = index.getName() == "KRvK";
+		uint64_t checked = 0;
+
+		for (uint64_t i = 0; i < index.getSize(); ++i) {
+			Board board;
+			uint8_t value;
+
+			if (!index.getBoard(i, board) || !generator.probe(board, value) || value == DTM_INVALID)
+				continue;
+
+			Wdl expected = getDtmWdl(value);
+
+			// Distance to mate, mated positions are one ply from the end
+			int expectedDtz = expected == WDL_DRAW ? 0
+				: expected == WDL_WIN ? getDtmPlies(value)
+				: -std::max(getDtmPlies(value), 1);
+
+			for (const Board &it : { board, flipColors(board) }) {
+				Wdl wdl;
+				REQUIRE(tablebases.probeWdl(it, wdl));
+
+				if (wdl != expected)
+					FAIL(name << " WDL " << wdl << " instead of " << expected << " at index " << i);
+
+				int dtzValue;
+				if (dtz && (!tablebases.probeDtz(it, dtzValue) || dtzValue != expectedDtz))
+					FAIL(name << " DTZ " << dtzValue << " instead of " << expectedDtz << " at index " << i);
+			}
+
+			checked++;
+		}
+
+		REQUIRE(checked > 0);
+	}
+
+	unlink((directory + "/KRvK.rtbw").c_str());
+	unlink((directory + "/KRvK.rtbz").c_str());
+	unlink((directory + "/KPvK.rtbw").c_str());
+	rmdir(directory.c_str());
+}
@@ -0,0 +1,91 @@
+#include <catch2/catch.hpp>
+#include "Engine.h"
+#include "Uci.h"
+
+#include <sstream>
+
+using namespace vimlock;
+
+/// Run given commands and return the output.
+static std::string run(Engine &engine, const std::string &commands)
+{
+	std::istringstream input(commands);
+	std::ostringstream output;
+
+	Uci uci(engine, input, output);
+	uci.main();
+
+	return output.str();
+}
+
+TEST_CASE("UCI position")
+{
+	Engine engine{3};
+
+	SECTION("Moves extending the previous position") {
+		run(engine,
+			"position startpos moves e2e4\n"
+			"position startpos moves e2e4 e7e5\n"
+			"position startpos moves e2e4 e7e5 g1f3\n");
+
+		REQUIRE(engine.getPosition().toFen() == "rnbqkbnr/pppp1ppp/8/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R b KQkq - 1 2");
+
+		// Different game
+		run(engine, "position startpos moves d2d4\n");
+		REQUIRE(engine.getPosition().toFen() == "rnbqkbnr/pppppppp/8/8/3P4/8/PPP1PPPP/RNBQKBNR b KQkq d3 0 1");
+	}
+
+	SECTION("Commands are kept between runs of the same interface") {
+		std::istringstream input(
+			"position startpos moves e2e4 e7e5\n"
+			"position startpos moves e2e4 e7e5 g1f3 xxxx\n"
+			"position startpos moves e2e4 c7c5\n"
+			"position fen 4k3/8/8/8/8/8/8/4K3 w - - 0 1 moves e1d1\n");
+		std::ostringstream output;
+
+		Uci uci(engine, input, output);
+		uci.main();
+
+		REQUIRE(engine.getPosition().toFen() == "4k3/8/8/8/8/8/8/3K4 b - - 1 1");
+	}
+
+	SECTION("Repetition saves the losing side") {
+		// Down a queen, but moving the knight back and forth repeats the position
+		std::string output = run(engine,
+			"position fen 7k/8/8/4q3/8/8/8/1K4N1 w - - 0 1 moves g1f3 h8g8 f3g1 g8h8\n"
+			"go\n");
+
+		REQUIRE(output.find("bestmove g1f3\n") != std::string::npos);
+	}
+}
+
+TEST_CASE("UCI hash option")
+{
+	Engine engine{2};
+
+	std::string output = run(engine,
+		"uci\n"
+		"setoption name Hash value 16\n"
+		"go\n");
+
+	REQUIRE(output.find("option name Hash type spin default 4 min 1 max ") != std::string::npos);
+	REQUIRE(output.find(" hashfull ") != std::string::npos);
+}
+
+TEST_CASE("UCI search info")
+{
+	Engine engine{3};
+
+	std::string output = run(engine,
+		"position fen 7k/8/6K1/8/8/8/8/Q7 w - - 0 1\n"
+		"go\n");
+
+	// A line for each iteration, before the best move
+	REQUIRE(output.find("info depth 1 seldepth ") == 0);
+	REQUIRE(output.find("info depth 2 seldepth ") != std::string::npos);
+	REQUIRE(output.find("info depth 3 seldepth ") < output.find("bestmove a1a8"));
+
+	REQUIRE(output.find(" score mate 1 nodes ") != std::string::npos);
+	REQUIRE(output.find(" nps ") != std::string::npos);
+	REQUIRE(output.find(" tbhits 0 pv a1a8\n") != std::string::npos);
+}
@@ -0,0 +1,77 @@
+#include "BookBuilder.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace vimlock;
+
+static void usage(const char *name)
+{
+	std::cerr << "Usage: " << name << " [-j threads] [--max-ply plies] [--min-games games]"
+		" [--max-entries entries] [--temp prefix] -o book.bin games.pgn..." << std::endl;
+}
+
+int main(int argc, const char *argv[])
+{
+	BookBuilder::Options options;
+	options.threads = std::max<int>(std::thread::hardware_concurrency(), 1);
+
+	std::string output;
+	std::vector<std::string> inputs;
+
+	for (int i = 1; i < argc; ++i) {
+		bool hasValue = i + 1 < argc;
+
+		if (!strcmp(argv[i], "-j") && hasValue)
+			options.threads = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--max-ply") && hasValue)
+			options.maxPly = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--min-games") && hasValue)
+			options.minGames = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--max-entries") && hasValue)
+			options.maxEntries = strtoull(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--temp") && hasValue)
+			options.tempPrefix = argv[++i];
+		else if (!strcmp(argv[i], "-o") && hasValue)
+			output = argv[++i];
+		else if (argv[i][0] == '-') {
+			usage(argv[0]);
+			return 1;
+		}
+		else
+			inputs.push_back(argv[i]);
+	}
+
+	if (output.empty() || inputs.empty()) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	// Run files go next to the book unless told otherwise
+	if (options.tempPrefix == BookBuilder::Options().tempPrefix)
+		options.tempPrefix = output + ".run";
+
+	BookBuilder builder(options);
+
+	for (const std::string &path : inputs) {
+		if (!builder.addFile(path)) {
+			std::cerr << "Failed to read " << path << std::endl;
+			return 1;
+		}
+
+		std::cout << path << ": " << builder.getGames() << " games, " << builder.getPositions() << " positions" << std::endl;
+	}
+
+	if (!builder.write(output)) {
+		std::cerr << "Failed to write " << output << std::endl;
+		return 1;
+	}
+
+	std::cout << output << ": merged " << builder.getRuns() << " runs" << std::endl;
+
+	return 0;
+}
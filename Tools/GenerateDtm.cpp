@@ -0,0 +1,97 @@
+#include "Dtm.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace vimlock;
+
+static void usage(const char *name)
+{
+	std::cerr << "Usage: " << name << " [-j threads] [-o directory] [--verify] material..." << std::endl;
+	std::cerr << "Generates distance to mate tables such as KQvK or KRPvKR, up to 5 pieces." << std::endl;
+}
+
+/// Compare values of a saved file with the generated ones.
+static bool verify(const DtmGenerator &generator, const std::string &path)
+{
+	DtmTable table;
+	if (!table.load(path))
+		return false;
+
+	const DtmIndex &index = table.getIndex();
+
+	for (uint64_t i = 0; i < index.getSize(); ++i) {
+		Board board;
+		uint8_t expected;
+
+		if (!index.getBoard(i, board) || !generator.probe(board, expected) || expected == DTM_INVALID)
+			continue;
+
+		if (table.getValue(i) != expected) {
+			std::cerr << "Mismatch in " << path << " at index " << i << std::endl;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int main(int argc, const char *argv[])
+{
+	int threads = std::max<int>(std::thread::hardware_concurrency(), 1);
+	std::string directory = ".";
+	bool verifyFiles = false;
+	std::vector<std::string> names;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "-j") && i + 1 < argc)
+			threads = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-o") && i + 1 < argc)
+			directory = argv[++i];
+		else if (!strcmp(argv[i], "--verify"))
+			verifyFiles = true;
+		else if (argv[i][0] == '-') {
+			usage(argv[0]);
+			return 1;
+		}
+		else
+			names.push_back(argv[i]);
+	}
+
+	if (names.empty()) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	DtmGenerator generator(threads);
+
+	for (const std::string &name : names) {
+		if (!generator.generate(name)) {
+			std::cerr << "Failed to generate " << name << std::endl;
+			return 1;
+		}
+	}
+
+	// Tables the requested ones depend on are written too, probing needs them
+	for (const std::string &name : generator.getNames()) {
+		std::string path = directory + "/" + name + ".dtm";
+
+		if (!generator.save(name, path)) {
+			std::cerr << "Failed to write " << path << std::endl;
+			return 1;
+		}
+
+		if (verifyFiles && !verify(generator, path)) {
+			std::cerr << "Failed to verify " << path << std::endl;
+			return 1;
+		}
+
+		std::cout << path << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/ChessBookBuild.dir/Tools/BuildBook.cpp.o"
+  "CMakeFiles/ChessBookBuild.dir/Tools/BuildBook.cpp.o.d"
+  "ChessBookBuild"
+  "ChessBookBuild.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/ChessBookBuild.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
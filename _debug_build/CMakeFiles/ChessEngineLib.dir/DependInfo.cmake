@@ -0,0 +1,41 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/Source/Attacks.cpp" "CMakeFiles/ChessEngineLib.dir/Source/Attacks.cpp.o" "gcc" "CMakeFiles/ChessEngineLib.dir/Source/Attacks.cpp.o.d"
+  "/root/repo/Source/Bitbase.cpp" "CMakeFiles/ChessEngineLib.dir/Source/Bitbase.cpp.o" "gcc" "CMakeFiles/ChessEngineLib.dir/Source/Bitbase.cpp.o.d"
+  "/root/repo/Source/Board.cpp" "CMakeFiles/ChessEngineLib.dir/Source/Board.cpp.o" "gcc" "CMakeFiles/ChessEngineLib.dir/Source/Board.cpp.o.d"
+  "/root/repo/Source/Book.cpp" "CMakeFiles/ChessEngineLib.dir/Source/Book.cpp.o" "gcc" "CMakeFiles/ChessEngineLib.dir/Source/Book.cpp.o.d"
+  "/root/repo/Source/BookBuilder.cpp" "CMakeFiles/ChessEngineLib.dir/Source/BookBuilder.cpp.o" "gcc" "CMakeFiles/ChessEngineLib.dir/Source/BookBuilder.cpp.o.d"
+  "/root/repo/Source/Dtm.cpp" "CMakeFiles/ChessEngineLib.dir/Source/Dtm.cpp.o" "gcc" "CMakeFiles/ChessEngineLib.dir/Source/Dtm.cpp.o.d"
+  "/root/repo/Source/Engine.cpp" "CMakeFiles/ChessEngineLib.dir/Source/Engine.cpp.o" "gcc" "CMakeFiles/ChessEngineLib.dir/Source/Engine.cpp.o.d"
+  "/root/repo/Source/Epd.cpp" "CMakeFiles/ChessEngineLib.dir/Source/Epd.cpp.o" "gcc" "CMakeFiles/ChessEngineLib.dir/Source/Epd.cpp.o.d"
+  "/root/repo/Source/EvalCache.cpp" "CMakeFiles/ChessEngineLib.dir/Source/EvalCache.cpp.o" "gcc" "CMakeFiles/ChessEngineLib.dir/Source/EvalCache.cpp.o.d"
+  "/root/repo/Source/Format.cpp" "CMakeFiles/ChessEngineLib.dir/Source/Format.cpp.o" "gcc" "CMakeFiles/ChessEngineLib.dir/Source/Format.cpp.o.d"
+  "/root/repo/Source/Log.cpp" "CMakeFiles/ChessEngineLib.dir/Source/Log.cpp.o" "gcc" "CMakeFiles/ChessEngineLib.dir/Source/Log.cpp.o.d"
+  "/root/repo/Source/Material.cpp" "CMakeFiles/ChessEngineLib.dir/Source/Material.cpp.o" "gcc" "CMakeFiles/ChessEngineLib.dir/Source/Material.cpp.o.d"
+  "/root/repo/Source/Memory.cpp" "CMakeFiles/ChessEngineLib.dir/Source/Memory.cpp.o" "gcc" "CMakeFiles/ChessEngineLib.dir/Source/Memory.cpp.o.d"
+  "/root/repo/Source/Move.cpp" "CMakeFiles/ChessEngineLib.dir/Source/Move.cpp.o" "gcc" "CMakeFiles/ChessEngineLib.dir/Source/Move.cpp.o.d"
+  "/root/repo/Source/Nnue.cpp" "CMakeFiles/ChessEngineLib.dir/Source/Nnue.cpp.o" "gcc" "CMakeFiles/ChessEngineLib.dir/Source/Nnue.cpp.o.d"
+  "/root/repo/Source/PawnTable.cpp" "CMakeFiles/ChessEngineLib.dir/Source/PawnTable.cpp.o" "gcc" "CMakeFiles/ChessEngineLib.dir/Source/PawnTable.cpp.o.d"
+  "/root/repo/Source/Pgn.cpp" "CMakeFiles/ChessEngineLib.dir/Source/Pgn.cpp.o" "gcc" "CMakeFiles/ChessEngineLib.dir/Source/Pgn.cpp.o.d"
+  "/root/repo/Source/Psqt.cpp" "CMakeFiles/ChessEngineLib.dir/Source/Psqt.cpp.o" "gcc" "CMakeFiles/ChessEngineLib.dir/Source/Psqt.cpp.o.d"
+  "/root/repo/Source/Sliders.cpp" "CMakeFiles/ChessEngineLib.dir/Source/Sliders.cpp.o" "gcc" "CMakeFiles/ChessEngineLib.dir/Source/Sliders.cpp.o.d"
+  "/root/repo/Source/Syzygy.cpp" "CMakeFiles/ChessEngineLib.dir/Source/Syzygy.cpp.o" "gcc" "CMakeFiles/ChessEngineLib.dir/Source/Syzygy.cpp.o.d"
+  "/root/repo/Source/Transposition.cpp" "CMakeFiles/ChessEngineLib.dir/Source/Transposition.cpp.o" "gcc" "CMakeFiles/ChessEngineLib.dir/Source/Transposition.cpp.o.d"
+  "/root/repo/Source/Uci.cpp" "CMakeFiles/ChessEngineLib.dir/Source/Uci.cpp.o" "gcc" "CMakeFiles/ChessEngineLib.dir/Source/Uci.cpp.o.d"
+  "/root/repo/Source/Zobrist.cpp" "CMakeFiles/ChessEngineLib.dir/Source/Zobrist.cpp.o" "gcc" "CMakeFiles/ChessEngineLib.dir/Source/Zobrist.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
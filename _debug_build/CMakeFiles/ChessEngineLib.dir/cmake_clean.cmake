@@ -0,0 +1,55 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/ChessEngineLib.dir/Source/Attacks.cpp.o"
+  "CMakeFiles/ChessEngineLib.dir/Source/Attacks.cpp.o.d"
+  "CMakeFiles/ChessEngineLib.dir/Source/Bitbase.cpp.o"
+  "CMakeFiles/ChessEngineLib.dir/Source/Bitbase.cpp.o.d"
+  "CMakeFiles/ChessEngineLib.dir/Source/Board.cpp.o"
+  "CMakeFiles/ChessEngineLib.dir/Source/Board.cpp.o.d"
+  "CMakeFiles/ChessEngineLib.dir/Source/Book.cpp.o"
+  "CMakeFiles/ChessEngineLib.dir/Source/Book.cpp.o.d"
+  "CMakeFiles/ChessEngineLib.dir/Source/BookBuilder.cpp.o"
+  "CMakeFiles/ChessEngineLib.dir/Source/BookBuilder.cpp.o.d"
+  "CMakeFiles/ChessEngineLib.dir/Source/Dtm.cpp.o"
+  "CMakeFiles/ChessEngineLib.dir/Source/Dtm.cpp.o.d"
+  "CMakeFiles/ChessEngineLib.dir/Source/Engine.cpp.o"
+  "CMakeFiles/ChessEngineLib.dir/Source/Engine.cpp.o.d"
+  "CMakeFiles/ChessEngineLib.dir/Source/Epd.cpp.o"
+  "CMakeFiles/ChessEngineLib.dir/Source/Epd.cpp.o.d"
+  "CMakeFiles/ChessEngineLib.dir/Source/EvalCache.cpp.o"
+  "CMakeFiles/ChessEngineLib.dir/Source/EvalCache.cpp.o.d"
+  "CMakeFiles/ChessEngineLib.dir/Source/Format.cpp.o"
+  "CMakeFiles/ChessEngineLib.dir/Source/Format.cpp.o.d"
+  "CMakeFiles/ChessEngineLib.dir/Source/Log.cpp.o"
+  "CMakeFiles/ChessEngineLib.dir/Source/Log.cpp.o.d"
+  "CMakeFiles/ChessEngineLib.dir/Source/Material.cpp.o"
+  "CMakeFiles/ChessEngineLib.dir/Source/Material.cpp.o.d"
+  "CMakeFiles/ChessEngineLib.dir/Source/Memory.cpp.o"
+  "CMakeFiles/ChessEngineLib.dir/Source/Memory.cpp.o.d"
+  "CMakeFiles/ChessEngineLib.dir/Source/Move.cpp.o"
+  "CMakeFiles/ChessEngineLib.dir/Source/Move.cpp.o.d"
+  "CMakeFiles/ChessEngineLib.dir/Source/Nnue.cpp.o"
+  "CMakeFiles/ChessEngineLib.dir/Source/Nnue.cpp.o.d"
+  "CMakeFiles/ChessEngineLib.dir/Source/PawnTable.cpp.o"
+  "CMakeFiles/ChessEngineLib.dir/Source/PawnTable.cpp.o.d"
+  "CMakeFiles/ChessEngineLib.dir/Source/Pgn.cpp.o"
+  "CMakeFiles/ChessEngineLib.dir/Source/Pgn.cpp.o.d"
+  "CMakeFiles/ChessEngineLib.dir/Source/Psqt.cpp.o"
+  "CMakeFiles/ChessEngineLib.dir/Source/Psqt.cpp.o.d"
+  "CMakeFiles/ChessEngineLib.dir/Source/Sliders.cpp.o"
+  "CMakeFiles/ChessEngineLib.dir/Source/Sliders.cpp.o.d"
+  "CMakeFiles/ChessEngineLib.dir/Source/Syzygy.cpp.o"
+  "CMakeFiles/ChessEngineLib.dir/Source/Syzygy.cpp.o.d"
+  "CMakeFiles/ChessEngineLib.dir/Source/Transposition.cpp.o"
+  "CMakeFiles/ChessEngineLib.dir/Source/Transposition.cpp.o.d"
+  "CMakeFiles/ChessEngineLib.dir/Source/Uci.cpp.o"
+  "CMakeFiles/ChessEngineLib.dir/Source/Uci.cpp.o.d"
+  "CMakeFiles/ChessEngineLib.dir/Source/Zobrist.cpp.o"
+  "CMakeFiles/ChessEngineLib.dir/Source/Zobrist.cpp.o.d"
+  "libChessEngineLib.a"
+  "libChessEngineLib.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/ChessEngineLib.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/ChessEval.dir/Source/Main.cpp.o"
+  "CMakeFiles/ChessEval.dir/Source/Main.cpp.o.d"
+  "ChessEval"
+  "ChessEval.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/ChessEval.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/GenerateDtm.dir/Tools/GenerateDtm.cpp.o"
+  "CMakeFiles/GenerateDtm.dir/Tools/GenerateDtm.cpp.o.d"
+  "GenerateDtm"
+  "GenerateDtm.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/GenerateDtm.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
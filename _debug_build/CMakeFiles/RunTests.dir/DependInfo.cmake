@@ -0,0 +1,34 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/Tests/Main.cpp" "CMakeFiles/RunTests.dir/Tests/Main.cpp.o" "gcc" "CMakeFiles/RunTests.dir/Tests/Main.cpp.o.d"
+  "/root/repo/Tests/TestBitboard.cpp" "CMakeFiles/RunTests.dir/Tests/TestBitboard.cpp.o" "gcc" "CMakeFiles/RunTests.dir/Tests/TestBitboard.cpp.o.d"
+  "/root/repo/Tests/TestBoard.cpp" "CMakeFiles/RunTests.dir/Tests/TestBoard.cpp.o" "gcc" "CMakeFiles/RunTests.dir/Tests/TestBoard.cpp.o.d"
+  "/root/repo/Tests/TestBook.cpp" "CMakeFiles/RunTests.dir/Tests/TestBook.cpp.o" "gcc" "CMakeFiles/RunTests.dir/Tests/TestBook.cpp.o.d"
+  "/root/repo/Tests/TestDtm.cpp" "CMakeFiles/RunTests.dir/Tests/TestDtm.cpp.o" "gcc" "CMakeFiles/RunTests.dir/Tests/TestDtm.cpp.o.d"
+  "/root/repo/Tests/TestEngine.cpp" "CMakeFiles/RunTests.dir/Tests/TestEngine.cpp.o" "gcc" "CMakeFiles/RunTests.dir/Tests/TestEngine.cpp.o.d"
+  "/root/repo/Tests/TestEpd.cpp" "CMakeFiles/RunTests.dir/Tests/TestEpd.cpp.o" "gcc" "CMakeFiles/RunTests.dir/Tests/TestEpd.cpp.o.d"
+  "/root/repo/Tests/TestMaterial.cpp" "CMakeFiles/RunTests.dir/Tests/TestMaterial.cpp.o" "gcc" "CMakeFiles/RunTests.dir/Tests/TestMaterial.cpp.o.d"
+  "/root/repo/Tests/TestMove.cpp" "CMakeFiles/RunTests.dir/Tests/TestMove.cpp.o" "gcc" "CMakeFiles/RunTests.dir/Tests/TestMove.cpp.o.d"
+  "/root/repo/Tests/TestMoves.cpp" "CMakeFiles/RunTests.dir/Tests/TestMoves.cpp.o" "gcc" "CMakeFiles/RunTests.dir/Tests/TestMoves.cpp.o.d"
+  "/root/repo/Tests/TestNnue.cpp" "CMakeFiles/RunTests.dir/Tests/TestNnue.cpp.o" "gcc" "CMakeFiles/RunTests.dir/Tests/TestNnue.cpp.o.d"
+  "/root/repo/Tests/TestPawns.cpp" "CMakeFiles/RunTests.dir/Tests/TestPawns.cpp.o" "gcc" "CMakeFiles/RunTests.dir/Tests/TestPawns.cpp.o.d"
+  "/root/repo/Tests/TestPgn.cpp" "CMakeFiles/RunTests.dir/Tests/TestPgn.cpp.o" "gcc" "CMakeFiles/RunTests.dir/Tests/TestPgn.cpp.o.d"
+  "/root/repo/Tests/TestSyzygy.cpp" "CMakeFiles/RunTests.dir/Tests/TestSyzygy.cpp.o" "gcc" "CMakeFiles/RunTests.dir/Tests/TestSyzygy.cpp.o.d"
+  "/root/repo/Tests/TestUci.cpp" "CMakeFiles/RunTests.dir/Tests/TestUci.cpp.o" "gcc" "CMakeFiles/RunTests.dir/Tests/TestUci.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_debug_build/CMakeFiles/ChessEngineLib.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,39 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/RunTests.dir/Tests/Main.cpp.o"
+  "CMakeFiles/RunTests.dir/Tests/Main.cpp.o.d"
+  "CMakeFiles/RunTests.dir/Tests/TestBitboard.cpp.o"
+  "CMakeFiles/RunTests.dir/Tests/TestBitboard.cpp.o.d"
+  "CMakeFiles/RunTests.dir/Tests/TestBoard.cpp.o"
+  "CMakeFiles/RunTests.dir/Tests/TestBoard.cpp.o.d"
+  "CMakeFiles/RunTests.dir/Tests/TestBook.cpp.o"
+  "CMakeFiles/RunTests.dir/Tests/TestBook.cpp.o.d"
+  "CMakeFiles/RunTests.dir/Tests/TestDtm.cpp.o"
+  "CMakeFiles/RunTests.dir/Tests/TestDtm.cpp.o.d"
+  "CMakeFiles/RunTests.dir/Tests/TestEngine.cpp.o"
+  "CMakeFiles/RunTests.dir/Tests/TestEngine.cpp.o.d"
+  "CMakeFiles/RunTests.dir/Tests/TestEpd.cpp.o"
+  "CMakeFiles/RunTests.dir/Tests/TestEpd.cpp.o.d"
+  "CMakeFiles/RunTests.dir/Tests/TestMaterial.cpp.o"
+  "CMakeFiles/RunTests.dir/Tests/TestMaterial.cpp.o.d"
+  "CMakeFiles/RunTests.dir/Tests/TestMove.cpp.o"
+  "CMakeFiles/RunTests.dir/Tests/TestMove.cpp.o.d"
+  "CMakeFiles/RunTests.dir/Tests/TestMoves.cpp.o"
+  "CMakeFiles/RunTests.dir/Tests/TestMoves.cpp.o.d"
+  "CMakeFiles/RunTests.dir/Tests/TestNnue.cpp.o"
+  "CMakeFiles/RunTests.dir/Tests/TestNnue.cpp.o.d"
+  "CMakeFiles/RunTests.dir/Tests/TestPawns.cpp.o"
+  "CMakeFiles/RunTests.dir/Tests/TestPawns.cpp.o.d"
+  "CMakeFiles/RunTests.dir/Tests/TestPgn.cpp.o"
+  "CMakeFiles/RunTests.dir/Tests/TestPgn.cpp.o.d"
+  "CMakeFiles/RunTests.dir/Tests/TestSyzygy.cpp.o"
+  "CMakeFiles/RunTests.dir/Tests/TestSyzygy.cpp.o.d"
+  "CMakeFiles/RunTests.dir/Tests/TestUci.cpp.o"
+  "CMakeFiles/RunTests.dir/Tests/TestUci.cpp.o.d"
+  "RunTests"
+  "RunTests.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/RunTests.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()